@@ -0,0 +1,432 @@
+#include "CompactTrajectory.h"
+
+#include "Algo/BinarySearch.h"
+
+namespace
+{
+	// Coarsest first; a block uses the first that divides all of its timestamp offsets
+	constexpr int64 TimeUnits[] = {ETimespan::TicksPerSecond, ETimespan::TicksPerMillisecond, ETimespan::TicksPerMicrosecond, 1};
+
+	// Fixed point steps per unit: 1e-8 degree (about a millimeter) and millimeters of height.
+	// UE coordinates use the same steps, since without a georeference they hold the WGS84 location as it was read.
+	constexpr double FixedPointScale[3] = {1.0e8, 1.0e8, 1.0e3};
+	// Largest magnitude that still leaves room for deltas in an int64
+	constexpr double MaxFixedPoint = 4.0e18;
+
+	void WriteVarint(TArray<uint8>& Data, uint64 Value)
+	{
+		while (Value >= 0x80)
+		{
+			Data.Add(static_cast<uint8>(Value) | 0x80);
+			Value >>= 7;
+		}
+		Data.Add(static_cast<uint8>(Value));
+	}
+
+	uint64 ReadVarint(const uint8*& Cursor)
+	{
+		uint64 Value = 0;
+		int32 Shift = 0;
+		uint8 Byte;
+		do
+		{
+			Byte = *Cursor++;
+			Value |= static_cast<uint64>(Byte & 0x7f) << Shift;
+			Shift += 7;
+		}
+		while (Byte & 0x80);
+		return Value;
+	}
+
+	// Small magnitudes of either sign become small unsigned values
+	uint64 ZigZag(const int64 Value) { return (static_cast<uint64>(Value) << 1) ^ static_cast<uint64>(Value >> 63); }
+	int64 UnZigZag(const uint64 Value) { return static_cast<int64>(Value >> 1) ^ -static_cast<int64>(Value & 1); }
+
+	int64 TicksOf(const FLocationTs& Location) { return Location.Timestamp.GetTicks(); }
+}
+
+/* Walks the samples of an encoded block from the first */
+struct FCompactTrajectory::FReader
+{
+	const FBlock& Block;
+	const uint8* Cursor;
+	int64 Value = 0;
+	int64 Delta = 0;
+	int64 Ticks = 0;
+	int64 Quantized[3];
+
+	explicit FReader(const FBlock& InBlock)
+		: Block(InBlock), Cursor(InBlock.Data.GetData())
+	{
+		for (int32 Axis = 0; Axis < 3; Axis++) Quantized[Axis] = Block.Origin[Axis];
+	}
+
+	void Next()
+	{
+		Delta += UnZigZag(ReadVarint(Cursor));
+		Value += Delta;
+		Ticks = Block.FirstTicks + Value * TimeUnits[Block.TimeUnit];
+		for (int32 Axis = 0; Axis < 3; Axis++) Quantized[Axis] += UnZigZag(ReadVarint(Cursor));
+	}
+
+	FLocationTs GetLocation(const FLocationTsFromWgs84* FromWgs84) const
+	{
+		return MakeLocation(Ticks, Quantized, FromWgs84);
+	}
+
+	/* A sample read earlier, from its ticks and fixed point coordinate */
+	FLocationTs MakeLocation(const int64 SampleTicks, const int64 (&SampleQuantized)[3], const FLocationTsFromWgs84* FromWgs84) const
+	{
+		const FDateTime Timestamp(SampleTicks);
+		const double* Scale = FixedPointScale;
+		const FVector Coordinate(SampleQuantized[0] / Scale[0], SampleQuantized[1] / Scale[1], SampleQuantized[2] / Scale[2]);
+		if (Block.Encoding == EEncoding::Unreal) return FLocationTs(Timestamp, Coordinate, FVector::ZeroVector, FVector::ZeroVector);
+		if (FromWgs84 != nullptr) return (*FromWgs84)(Timestamp, Coordinate);
+		return FLocationTs(Timestamp, FVector::ZeroVector, Coordinate, FVector::ZeroVector);
+	}
+};
+
+void FCompactTrajectory::Encode(FBlock& Block, const FLocationTs* Locations, const int32 Count,
+                                const FLocationTsFromWgs84* FromWgs84)
+{
+	Block.Count = Count;
+	Block.FirstTicks = TicksOf(Locations[0]);
+	Block.LastTicks = TicksOf(Locations[Count - 1]);
+	Block.Data.Reset();
+	Block.Locations.Reset();
+
+	// WGS84 when the other coordinates can be derived from it, UE when it is all there is
+	bool Geodetic = FromWgs84 != nullptr;
+	bool Unreal = true;
+	for (int32 i = 0; i < Count; i++)
+	{
+		if (Locations[i].Wgs84Coordinate.IsZero()) Geodetic = false;
+		else Unreal = false;
+		if (!Locations[i].EcefCoordinate.IsZero()) Unreal = false;
+		for (int32 Axis = 0; Axis < 3 && Unreal; Axis++)
+		{
+			Unreal = FMath::Abs(Locations[i].UECoordinate[Axis] * FixedPointScale[Axis]) < MaxFixedPoint;
+		}
+	}
+	Block.Encoding = Geodetic ? EEncoding::Geodetic : (Unreal ? EEncoding::Unreal : EEncoding::Plain);
+	if (Block.Encoding == EEncoding::Plain)
+	{
+		Block.Data.Empty();
+		Block.Locations.Append(Locations, Count);
+		Block.Locations.Shrink();
+		return;
+	}
+
+	Block.TimeUnit = static_cast<uint8>(UE_ARRAY_COUNT(TimeUnits) - 1);
+	for (uint8 Unit = 0; Unit < UE_ARRAY_COUNT(TimeUnits); Unit++)
+	{
+		bool Exact = true;
+		for (int32 i = 0; i < Count && Exact; i++) Exact = (TicksOf(Locations[i]) - Block.FirstTicks) % TimeUnits[Unit] == 0;
+		if (!Exact) continue;
+		Block.TimeUnit = Unit;
+		break;
+	}
+
+	const double* Scale = FixedPointScale;
+	const auto Quantize = [&Block, Scale](const FLocationTs& Location, const int32 Axis)
+	{
+		const FVector& Coordinate = Block.Encoding == EEncoding::Geodetic ? Location.Wgs84Coordinate : Location.UECoordinate;
+		return static_cast<int64>(FMath::RoundToDouble(Coordinate[Axis] * Scale[Axis]));
+	};
+	for (int32 Axis = 0; Axis < 3; Axis++) Block.Origin[Axis] = Quantize(Locations[0], Axis);
+
+	int64 PreviousValue = 0, PreviousDelta = 0;
+	int64 Previous[3] = {Block.Origin[0], Block.Origin[1], Block.Origin[2]};
+	Block.Data.Reserve(Count * 6);
+	for (int32 i = 0; i < Count; i++)
+	{
+		const int64 Value = (TicksOf(Locations[i]) - Block.FirstTicks) / TimeUnits[Block.TimeUnit];
+		const int64 Delta = Value - PreviousValue;
+		WriteVarint(Block.Data, ZigZag(Delta - PreviousDelta));
+		PreviousValue = Value;
+		PreviousDelta = Delta;
+		for (int32 Axis = 0; Axis < 3; Axis++)
+		{
+			const int64 Quantized = Quantize(Locations[i], Axis);
+			WriteVarint(Block.Data, ZigZag(Quantized - Previous[Axis]));
+			Previous[Axis] = Quantized;
+		}
+	}
+	Block.Data.Shrink();
+}
+
+void FCompactTrajectory::Decode(const FBlock& Block, const FLocationTsFromWgs84* FromWgs84, const int32 First, const int32 End,
+                                TArray<FLocationTs>& OutLocations)
+{
+	if (Block.Encoding == EEncoding::Plain)
+	{
+		OutLocations.Append(Block.Locations.GetData() + First, End - First);
+		return;
+	}
+	FReader Reader(Block);
+	for (int32 i = 0; i < End; i++)
+	{
+		Reader.Next();
+		if (i >= First) OutLocations.Add(Reader.GetLocation(FromWgs84));
+	}
+}
+
+int32 FCompactTrajectory::FindInBlock(const FBlock& Block, const int64 Ticks, const bool After)
+{
+	if (Block.Encoding == EEncoding::Plain)
+	{
+		return After ? Algo::UpperBoundBy(Block.Locations, Ticks, TicksOf) : Algo::LowerBoundBy(Block.Locations, Ticks, TicksOf);
+	}
+	FReader Reader(Block);
+	for (int32 i = 0; i < Block.Count; i++)
+	{
+		Reader.Next();
+		if (After ? Reader.Ticks > Ticks : Reader.Ticks >= Ticks) return i;
+	}
+	return Block.Count;
+}
+
+bool FCompactTrajectory::Add(const FLocationTs& Location, const FLocationTsFromWgs84* FromWgs84)
+{
+	const int64 Ticks = TicksOf(Location);
+	if (Blocks.Num() == 0 || Blocks.Last().LastTicks < Ticks)
+	{
+		if (Tail.Num() == 0 || Tail.Last() < Location) Tail.Add(Location);
+		else
+		{
+			const int32 Position = Algo::LowerBoundBy(Tail, Ticks, TicksOf);
+			if (TicksOf(Tail[Position]) == Ticks) return false;
+			Tail.Insert(Location, Position);
+		}
+		if (Tail.Num() >= 2 * BlockSize) SealTail(FromWgs84);
+		return true;
+	}
+
+	// older than the tail: the block is decoded, inserted into and encoded again
+	const int32 BlockIndex = Algo::LowerBoundBy(Blocks, Ticks, [](const FBlock& Block) { return Block.LastTicks; });
+	TArray<FLocationTs> Locations;
+	Decode(Blocks[BlockIndex], FromWgs84, 0, Blocks[BlockIndex].Count, Locations);
+	const int32 Position = Algo::LowerBoundBy(Locations, Ticks, TicksOf);
+	if (Position < Locations.Num() && TicksOf(Locations[Position]) == Ticks) return false;
+	Locations.Insert(Location, Position);
+	if (Locations.Num() >= 2 * BlockSize)
+	{
+		const int32 Half = Locations.Num() / 2;
+		Encode(Blocks[BlockIndex], Locations.GetData(), Half, FromWgs84);
+		FBlock& Split = Blocks.InsertDefaulted_GetRef(BlockIndex + 1);
+		Encode(Split, Locations.GetData() + Half, Locations.Num() - Half, FromWgs84);
+	}
+	else
+	{
+		Encode(Blocks[BlockIndex], Locations.GetData(), Locations.Num(), FromWgs84);
+	}
+	SealedCount++;
+	UpdateStarts(BlockIndex);
+	return true;
+}
+
+void FCompactTrajectory::SealTail(const FLocationTsFromWgs84* FromWgs84)
+{
+	FBlock& Block = Blocks.AddDefaulted_GetRef();
+	Block.Start = SealedCount;
+	Encode(Block, Tail.GetData(), BlockSize, FromWgs84);
+	SealedCount += BlockSize;
+	Tail.RemoveAt(0, BlockSize, false);
+}
+
+int32 FCompactTrajectory::FindBlock(const int32 Index) const
+{
+	return Algo::UpperBoundBy(Blocks, Index, [](const FBlock& Block) { return Block.Start; }) - 1;
+}
+
+void FCompactTrajectory::UpdateStarts(const int32 FirstBlock)
+{
+	for (int32 i = FMath::Max(FirstBlock, 0); i < Blocks.Num(); i++)
+	{
+		Blocks[i].Start = i == 0 ? 0 : Blocks[i - 1].Start + Blocks[i - 1].Count;
+	}
+}
+
+int32 FCompactTrajectory::LowerBound(const int64 Ticks) const
+{
+	const int32 BlockIndex = Algo::LowerBoundBy(Blocks, Ticks, [](const FBlock& Block) { return Block.LastTicks; });
+	if (BlockIndex == Blocks.Num()) return SealedCount + Algo::LowerBoundBy(Tail, Ticks, TicksOf);
+	return Blocks[BlockIndex].Start + FindInBlock(Blocks[BlockIndex], Ticks, false);
+}
+
+int32 FCompactTrajectory::UpperBound(const int64 Ticks) const
+{
+	const int32 BlockIndex = Algo::UpperBoundBy(Blocks, Ticks, [](const FBlock& Block) { return Block.LastTicks; });
+	if (BlockIndex == Blocks.Num()) return SealedCount + Algo::UpperBoundBy(Tail, Ticks, TicksOf);
+	return Blocks[BlockIndex].Start + FindInBlock(Blocks[BlockIndex], Ticks, true);
+}
+
+int64 FCompactTrajectory::GetTicks(const int32 Index) const
+{
+	if (Index >= SealedCount) return TicksOf(Tail[Index - SealedCount]);
+	const FBlock& Block = Blocks[FindBlock(Index)];
+	const int32 Local = Index - Block.Start;
+	if (Block.Encoding == EEncoding::Plain) return TicksOf(Block.Locations[Local]);
+	FReader Reader(Block);
+	for (int32 i = 0; i <= Local; i++) Reader.Next();
+	return Reader.Ticks;
+}
+
+FLocationTs FCompactTrajectory::Get(const int32 Index, const FLocationTsFromWgs84* FromWgs84) const
+{
+	if (Index >= SealedCount) return Tail[Index - SealedCount];
+	const FBlock& Block = Blocks[FindBlock(Index)];
+	const int32 Local = Index - Block.Start;
+	if (Block.Encoding == EEncoding::Plain) return Block.Locations[Local];
+	FReader Reader(Block);
+	for (int32 i = 0; i <= Local; i++) Reader.Next();
+	return Reader.GetLocation(FromWgs84);
+}
+
+bool FCompactTrajectory::GetAround(const int64 Ticks, const int64 MinTicks, const FLocationTsFromWgs84* FromWgs84,
+                                   const bool WithNext, FLocationTs& OutLatest, TOptional<FLocationTs>& OutNext) const
+{
+	OutNext.Reset();
+	const int32 BlockIndex = Algo::UpperBoundBy(Blocks, Ticks, [](const FBlock& Block) { return Block.LastTicks; });
+	if (BlockIndex == Blocks.Num())
+	{
+		// every encoded location is at or before Ticks, so both are in the tail, or the latest ends the last block
+		const int32 Next = Algo::UpperBoundBy(Tail, Ticks, TicksOf);
+		if (WithNext && Next < Tail.Num()) OutNext = Tail[Next];
+		if (Next > 0)
+		{
+			if (TicksOf(Tail[Next - 1]) < MinTicks) return false;
+			OutLatest = Tail[Next - 1];
+			return true;
+		}
+	}
+	else
+	{
+		// the block holds the next location, and the latest too unless the next one starts it
+		const FBlock& Block = Blocks[BlockIndex];
+		if (Block.Encoding == EEncoding::Plain)
+		{
+			const int32 Next = Algo::UpperBoundBy(Block.Locations, Ticks, TicksOf);
+			if (WithNext) OutNext = Block.Locations[Next];
+			if (Next > 0)
+			{
+				if (TicksOf(Block.Locations[Next - 1]) < MinTicks) return false;
+				OutLatest = Block.Locations[Next - 1];
+				return true;
+			}
+		}
+		else
+		{
+			FReader Reader(Block);
+			int64 LatestTicks = 0;
+			int64 Latest[3] = {0, 0, 0};
+			int32 Next = 0;
+			for (; Next < Block.Count; Next++)
+			{
+				Reader.Next();
+				if (Reader.Ticks > Ticks) break;
+				LatestTicks = Reader.Ticks;
+				FMemory::Memcpy(Latest, Reader.Quantized, sizeof(Latest));
+			}
+			if (WithNext) OutNext = Reader.GetLocation(FromWgs84);
+			if (Next > 0)
+			{
+				if (LatestTicks < MinTicks) return false;
+				OutLatest = Reader.MakeLocation(LatestTicks, Latest, FromWgs84);
+				return true;
+			}
+		}
+	}
+
+	if (BlockIndex == 0) return false;
+	const FBlock& Previous = Blocks[BlockIndex - 1];
+	if (Previous.LastTicks < MinTicks) return false;
+	if (Previous.Encoding == EEncoding::Plain)
+	{
+		OutLatest = Previous.Locations.Last();
+		return true;
+	}
+	FReader Reader(Previous);
+	for (int32 i = 0; i < Previous.Count; i++) Reader.Next();
+	OutLatest = Reader.GetLocation(FromWgs84);
+	return true;
+}
+
+void FCompactTrajectory::GetRange(const int32 First, const int32 End, const FLocationTsFromWgs84* FromWgs84,
+                                  TArray<FLocationTs>& OutLocations) const
+{
+	if (End <= First) return;
+	OutLocations.Reserve(OutLocations.Num() + End - First);
+	int32 Index = First;
+	for (int32 BlockIndex = Index < SealedCount ? FindBlock(Index) : Blocks.Num(); BlockIndex < Blocks.Num() && Index < End; BlockIndex++)
+	{
+		const FBlock& Block = Blocks[BlockIndex];
+		const int32 BlockEnd = FMath::Min(End, Block.Start + Block.Count);
+		Decode(Block, FromWgs84, Index - Block.Start, BlockEnd - Block.Start, OutLocations);
+		Index = BlockEnd;
+	}
+	if (Index < End) OutLocations.Append(Tail.GetData() + Index - SealedCount, End - Index);
+}
+
+void FCompactTrajectory::GetAllTicks(TArray<int64>& OutTicks) const
+{
+	OutTicks.Reserve(OutTicks.Num() + Num());
+	for (const FBlock& Block : Blocks)
+	{
+		if (Block.Encoding == EEncoding::Plain)
+		{
+			for (const FLocationTs& Location : Block.Locations) OutTicks.Add(TicksOf(Location));
+			continue;
+		}
+		FReader Reader(Block);
+		for (int32 i = 0; i < Block.Count; i++)
+		{
+			Reader.Next();
+			OutTicks.Add(Reader.Ticks);
+		}
+	}
+	for (const FLocationTs& Location : Tail) OutTicks.Add(TicksOf(Location));
+}
+
+void FCompactTrajectory::RemoveFirst(const int32 Count, const FLocationTsFromWgs84* FromWgs84)
+{
+	if (Count <= 0) return;
+	if (Count >= SealedCount)
+	{
+		Tail.RemoveAt(0, FMath::Min(Count - SealedCount, Tail.Num()));
+		Blocks.Reset();
+		SealedCount = 0;
+		return;
+	}
+
+	// whole blocks go, and the block with the first kept location is encoded again without the rest
+	const int32 BlockIndex = FindBlock(Count);
+	FBlock& Block = Blocks[BlockIndex];
+	const int32 Local = Count - Block.Start;
+	if (Local > 0)
+	{
+		TArray<FLocationTs> Kept;
+		Decode(Block, FromWgs84, Local, Block.Count, Kept);
+		Encode(Block, Kept.GetData(), Kept.Num(), FromWgs84);
+	}
+	Blocks.RemoveAt(0, BlockIndex);
+	SealedCount -= Count;
+	UpdateStarts(0);
+}
+
+void FCompactTrajectory::Reset()
+{
+	Blocks.Reset();
+	SealedCount = 0;
+	Tail.Reset();
+}
+
+SIZE_T FCompactTrajectory::GetAllocatedSize() const
+{
+	SIZE_T Size = Blocks.GetAllocatedSize() + Tail.GetAllocatedSize();
+	for (const FBlock& Block : Blocks)
+	{
+		Size += Block.Data.GetAllocatedSize() + Block.Locations.GetAllocatedSize();
+	}
+	return Size;
+}
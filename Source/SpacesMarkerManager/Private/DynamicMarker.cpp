@@ -1,6 +1,7 @@
 #include "DynamicMarker.h"
 
 #include "JsonObjectConverter.h"
+#include "Algo/BinarySearch.h"
 #include "Kismet/GameplayStatics.h"
 
 DEFINE_LOG_CATEGORY(LogDynamicMarker);
@@ -9,7 +10,7 @@ DEFINE_LOG_CATEGORY(LogDynamicMarker);
 ADynamicMarker::ADynamicMarker()
 {
 	PrimaryActorTick.bCanEverTick = true;
-	PrimaryActorTick.TickInterval = 0.01f;
+	PrimaryActorTick.TickInterval = BaseTickInterval;
 	Super::MarkerType = ELocationMarkerType::Dynamic;
 	Super::BaseColor = DynamicMarkerColor;
 	Super::DeleteFromDBOnDestroy = false;
@@ -20,7 +21,7 @@ ADynamicMarker::ADynamicMarker()
 void ADynamicMarker::BeginPlay()
 {
 	Super::BeginPlay();
-	if (HasAuthority())
+	if (HasAuthority() && ReplicateAsActor)
 	{
 		SetReplicates(true);
 		SetReplicateMovement(true);
@@ -29,45 +30,234 @@ void ADynamicMarker::BeginPlay()
 	{
 		LocationTs.UECoordinate = GetActorLocation();
 	}
-	SetLifeSpan(0);
+	CurrentLocation = GetActorLocation();
+	// dynamic markers expire only after reaching their last location
+	CancelExpiry();
 }
 
 void ADynamicMarker::Tick(const float DeltaTime)
 {
-	if (GetActorLocation() == LocationTs.UECoordinate)
+	AdvanceLocation(DeltaTime);
+	// hidden markers only follow their history, the actor catches up when they are revealed
+	if (Significance != EMarkerSignificance::Hidden && GetActorLocation() != CurrentLocation)
 	{
-		if (idx >= 0 && idx + 1 < HistoryArr.Num())
+		SetActorLocation(CurrentLocation, true, nullptr, ETeleportType::None);
+	}
+	if (ReachedLastLocation && CurrentLocation == LocationTs.UECoordinate) Super::Tick(DeltaTime);
+}
+
+void ADynamicMarker::AdvanceLocation(const float DeltaTime)
+{
+	// a long tick covers several locations, so markers keep their pace at any significance
+	double Distance = FMath::Abs(DeltaTime) * InterpolationsPerSecond;
+	while (true)
+	{
+		if (CurrentLocation != LocationTs.UECoordinate)
 		{
-			if (DeltaTime > 0) idx++;
-			else if (DeltaTime < 0 && idx > 0) idx--;
-			LocationTs = HistoryArr[idx];
-			if (idx + 1 == HistoryArr.Num())
+			const FVector ToTarget = LocationTs.UECoordinate - CurrentLocation;
+			const double Remaining = ToTarget.Size();
+			if (Remaining > Distance)
 			{
-				UE_LOG(LogDynamicMarker, Display, TEXT("DynamicMarker %s reached final location. Will be destroyed in %f seconds."), *DeviceID, DefaultLifeSpan);
-				if (!ReachedLastLocation)
-				{
-					ReachedLastLocation = true;
-					SetLifeSpan(DefaultLifeSpan);
-				} 
-			} 
+				CurrentLocation += ToTarget * (Distance / Remaining);
+				return;
+			}
+			CurrentLocation = LocationTs.UECoordinate;
+			Distance -= Remaining;
 		}
-		if (ReachedLastLocation) Super::Tick(DeltaTime); 
+		if (!StepHistory(DeltaTime) || Distance <= 0.0) return;
 	}
-	else
+}
+
+bool ADynamicMarker::StepHistory(const float DeltaTime)
+{
+	if (idx < 0 || idx + 1 >= HistoryArr.Num()) return false;
+	if (DeltaTime > 0) idx++;
+	else if (DeltaTime < 0 && idx > 0) idx--;
+	else return false;
+	LocationTs = HistoryArr[idx];
+	if (idx + 1 == HistoryArr.Num())
 	{
-		const FVector Step = FMath::VInterpConstantTo(
-			GetActorLocation(),
-			LocationTs.UECoordinate,
-			DeltaTime,
-			InterpolationsPerSecond);
-		SetActorLocation(Step, true, nullptr, ETeleportType::None);
+		UE_LOG(LogDynamicMarker, Display, TEXT("DynamicMarker %s reached final location. Will be destroyed in %f seconds."), *DeviceID, DefaultLifeSpan);
+		if (!ReachedLastLocation)
+		{
+			ReachedLastLocation = true;
+			ScheduleExpiry(DefaultLifeSpan);
+		}
 	}
+	return true;
+}
+
+void ADynamicMarker::SetSignificance(const EMarkerSignificance InSignificance, const int32 UpdateRateDivisor)
+{
+	const bool Revealed = Significance == EMarkerSignificance::Hidden && InSignificance != EMarkerSignificance::Hidden;
+	Super::SetSignificance(InSignificance, UpdateRateDivisor);
+	SetActorTickInterval(BaseTickInterval * FMath::Max(UpdateRateDivisor, 1));
+	if (Revealed) SetActorLocation(CurrentLocation, false, nullptr, ETeleportType::TeleportPhysics);
 }
 
 void ADynamicMarker::AddLocationTs(const FLocationTs Location)
 {
-	HistoryArr.HeapPush(Location);
-	SetLifeSpan(0);
+	// device ID and timestamp identify a record, so a location with a known timestamp is a duplicate
+	if (HistoryArr.Num() == 0 || HistoryArr.Last() < Location) HistoryArr.Add(Location);
+	else
+	{
+		const int32 Index = Algo::LowerBound(HistoryArr, Location);
+		if (Index < HistoryArr.Num() && HistoryArr[Index].Timestamp == Location.Timestamp) return;
+		HistoryArr.Insert(Location, Index);
+		// a late location before the current one keeps the marker where it is
+		if (Index <= idx) idx++;
+	}
+	ReachedLastLocation = false;
+	CancelExpiry();
+	OnLocationsAdded(1);
+}
+
+void ADynamicMarker::AddLocationTsBatch(const TArray<FLocationTs>& Locations)
+{
+	if (Locations.Num() == 0) return;
+
+	// Locations is sorted, so only the part of the history from its first timestamp on is merged
+	const int32 Start = Algo::LowerBound(HistoryArr, Locations[0]);
+	if (Start == HistoryArr.Num())
+	{
+		HistoryArr.Reserve(HistoryArr.Num() + Locations.Num());
+		for (const FLocationTs& Location : Locations)
+		{
+			if (HistoryArr.Num() == 0 || HistoryArr.Last() < Location) HistoryArr.Add(Location);
+		}
+	}
+	else
+	{
+		TArray<FLocationTs> Tail(HistoryArr.GetData() + Start, HistoryArr.Num() - Start);
+		HistoryArr.SetNum(Start, false);
+		HistoryArr.Reserve(Start + Tail.Num() + Locations.Num());
+		int32 NewIdx = idx;
+		int32 i = 0, j = 0;
+		while (i < Tail.Num() || j < Locations.Num())
+		{
+			// known locations win over new ones with the same timestamp, since device ID and timestamp identify a record
+			const bool TakeKnown = j == Locations.Num() || (i < Tail.Num() && !(Locations[j] < Tail[i]));
+			const FLocationTs& Next = TakeKnown ? Tail[i++] : Locations[j++];
+			if (HistoryArr.Num() > 0 && !(HistoryArr.Last() < Next)) continue;
+			// a late location before the current one keeps the marker where it is
+			if (!TakeKnown && i < Tail.Num() && Start + i <= idx) NewIdx++;
+			HistoryArr.Add(Next);
+		}
+		idx = NewIdx;
+	}
+	ReachedLastLocation = false;
+	CancelExpiry();
+	OnLocationsAdded(Locations.Num());
+}
+
+void ADynamicMarker::SkipToLatestLocation()
+{
+	if (HistoryArr.Num() == 0) return;
+	idx = HistoryArr.Num() - 1;
+	LocationTs = HistoryArr[idx];
+	CurrentLocation = LocationTs.UECoordinate;
+	if (Significance != EMarkerSignificance::Hidden)
+	{
+		SetActorLocation(CurrentLocation, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+	// the end of the history is reached without stepping through it, so expire as StepHistory() would
+	if (!ReachedLastLocation)
+	{
+		ReachedLastLocation = true;
+		ScheduleExpiry(DefaultLifeSpan);
+	}
+}
+
+void ADynamicMarker::OnLocationsAdded(const int32 Count)
+{
+	LocationsSinceDecimation += Count;
+	if (DecimationToleranceMeters <= 0.0f || LocationsSinceDecimation < DecimationInterval) return;
+	LocationsSinceDecimation = 0;
+	DecimateHistory();
+}
+
+namespace
+{
+	// Tolerance doubles per age tier, up to 2^MaxDecimationTier
+	constexpr int32 MaxDecimationTier = 4;
+
+	/* Mark the locations of [First, Last] that Douglas-Peucker keeps at Tolerance. Both ends are kept. */
+	void SimplifyRange(const TArray<FLocationTs>& Locations, const int32 First, const int32 Last, const double Tolerance,
+	                   TBitArray<>& Keep)
+	{
+		Keep[First] = true;
+		Keep[Last] = true;
+		TArray<TPair<int32, int32>, TInlineAllocator<32>> Stack;
+		Stack.Emplace(First, Last);
+		while (Stack.Num() > 0)
+		{
+			const TPair<int32, int32> Range = Stack.Pop(false);
+			const FVector& Start = Locations[Range.Key].UECoordinate;
+			const FVector& End = Locations[Range.Value].UECoordinate;
+			double MaxDistance = 0.0;
+			int32 Farthest = INDEX_NONE;
+			for (int32 i = Range.Key + 1; i < Range.Value; i++)
+			{
+				const double Distance = FMath::PointDistToSegment(Locations[i].UECoordinate, Start, End);
+				if (Distance > MaxDistance)
+				{
+					MaxDistance = Distance;
+					Farthest = i;
+				}
+			}
+			if (Farthest == INDEX_NONE || MaxDistance <= Tolerance) continue;
+			Keep[Farthest] = true;
+			Stack.Emplace(Range.Key, Farthest);
+			Stack.Emplace(Farthest, Range.Value);
+		}
+	}
+}
+
+int ADynamicMarker::DecimateHistory()
+{
+	if (DecimationToleranceMeters <= 0.0f || HistoryArr.Num() < 3) return 0;
+
+	// UE units are centimeters
+	const double Tolerance = DecimationToleranceMeters * 100.0;
+	const double FullResolutionSeconds = FMath::Max(DecimationFullResolutionSeconds, 1.0f);
+	const FDateTime Latest = HistoryArr.Last().Timestamp;
+	const auto FirstNewerThan = [this, &Latest](const double AgeSeconds)
+	{
+		const FDateTime Threshold = Latest - FTimespan::FromSeconds(AgeSeconds);
+		return static_cast<int32>(Algo::LowerBoundBy(HistoryArr, Threshold, [](const FLocationTs& Location) { return Location.Timestamp; }));
+	};
+
+	// everything from FullResolutionStart on is kept
+	const int32 FullResolutionStart = FirstNewerThan(FullResolutionSeconds);
+	if (FullResolutionStart < 2) return 0;
+	TBitArray<> Keep(false, HistoryArr.Num());
+	for (int32 i = FullResolutionStart; i < HistoryArr.Num(); i++) Keep[i] = true;
+	if (idx >= 0 && idx < HistoryArr.Num()) Keep[idx] = true;
+
+	// tier k holds ages in [FullResolutionSeconds * 2^k, FullResolutionSeconds * 2^(k+1)), the last tier everything older.
+	// neighbouring tiers share their boundary location, so the simplified path stays connected.
+	int32 TierEnd = FullResolutionStart;
+	for (int32 Tier = 0; Tier <= MaxDecimationTier && TierEnd > 0; Tier++)
+	{
+		const int32 TierStart = Tier == MaxDecimationTier ? 0 : FirstNewerThan(FullResolutionSeconds * (2 << Tier));
+		if (TierStart < TierEnd) SimplifyRange(HistoryArr, TierStart, TierEnd, Tolerance * (1 << Tier), Keep);
+		TierEnd = TierStart;
+	}
+
+	int32 Kept = 0;
+	int32 NewIdx = idx;
+	for (int32 i = 0; i < HistoryArr.Num(); i++)
+	{
+		if (!Keep[i]) continue;
+		if (i == idx) NewIdx = Kept;
+		if (Kept != i) HistoryArr[Kept] = HistoryArr[i];
+		Kept++;
+	}
+	const int32 Removed = HistoryArr.Num() - Kept;
+	HistoryArr.SetNum(Kept, false);
+	idx = FMath::Min(NewIdx, HistoryArr.Num() - 1);
+	if (Removed > 0) UE_LOG(LogDynamicMarker, Verbose, TEXT("DynamicMarker %s: decimated %d locations, %d left"), *DeviceID, Removed, Kept);
+	return Removed;
 }
 
 FString ADynamicMarker::ToString() const
@@ -0,0 +1,87 @@
+#include "DynamoDBAsyncAction.h"
+
+#include "LocationMarker.h"
+#include "MarkerManager.h"
+#include "Kismet/GameplayStatics.h"
+
+UDynamoDBAsyncAction* UDynamoDBAsyncAction::Create(UObject* WorldContextObject,
+                                                   TFunction<void(UMarkerManager*, UDynamoDBAsyncAction*)>&& InOperation)
+{
+	UDynamoDBAsyncAction* Action = NewObject<UDynamoDBAsyncAction>();
+	Action->WorldContext = WorldContextObject;
+	Action->Operation = MoveTemp(InOperation);
+	Action->RegisterWithGameInstance(WorldContextObject);
+	return Action;
+}
+
+UDynamoDBAsyncAction* UDynamoDBAsyncAction::CreateMarkerInDBAsync(UObject* WorldContextObject, const ALocationMarker* Marker)
+{
+	return Create(WorldContextObject, [Marker](UMarkerManager* Manager, UDynamoDBAsyncAction* Action)
+	{
+		if (Marker == nullptr)
+		{
+			Action->Finish(false, FVector::ZeroVector);
+			return;
+		}
+		TWeakObjectPtr<UDynamoDBAsyncAction> WeakAction(Action);
+		Manager->CreateMarkerInDBAsync(Marker).Next([WeakAction](const bool Success)
+		{
+			if (WeakAction.IsValid()) WeakAction->Finish(Success, FVector::ZeroVector);
+		});
+	});
+}
+
+UDynamoDBAsyncAction* UDynamoDBAsyncAction::DeleteMarkerFromDynamoDBAsync(UObject* WorldContextObject, const FString DeviceID, const FDateTime Timestamp)
+{
+	return Create(WorldContextObject, [DeviceID, Timestamp](UMarkerManager* Manager, UDynamoDBAsyncAction* Action)
+	{
+		TWeakObjectPtr<UDynamoDBAsyncAction> WeakAction(Action);
+		Manager->DeleteMarkerFromDynamoDBAsync(DeviceID, Timestamp).Next([WeakAction](const bool Success)
+		{
+			if (WeakAction.IsValid()) WeakAction->Finish(Success, FVector::ZeroVector);
+		});
+	});
+}
+
+UDynamoDBAsyncAction* UDynamoDBAsyncAction::GetLatestRecordAsync(UObject* WorldContextObject, const FString DeviceID, const FDateTime LastKnownTimestamp)
+{
+	return Create(WorldContextObject, [DeviceID, LastKnownTimestamp](UMarkerManager* Manager, UDynamoDBAsyncAction* Action)
+	{
+		TWeakObjectPtr<UDynamoDBAsyncAction> WeakAction(Action);
+		Manager->GetLatestRecordAsync(DeviceID, LastKnownTimestamp).Next([WeakAction](const FVector Location)
+		{
+			if (WeakAction.IsValid()) WeakAction->Finish(!Location.IsZero(), Location);
+		});
+	});
+}
+
+UDynamoDBAsyncAction* UDynamoDBAsyncAction::GetAllMarkersFromDynamoDBAsync(UObject* WorldContextObject, const bool StaticMarkersOnly)
+{
+	return Create(WorldContextObject, [StaticMarkersOnly](UMarkerManager* Manager, UDynamoDBAsyncAction* Action)
+	{
+		TWeakObjectPtr<UDynamoDBAsyncAction> WeakAction(Action);
+		Manager->GetAllMarkersFromDynamoDBAsync(StaticMarkersOnly).Next([WeakAction](const int Count)
+		{
+			if (WeakAction.IsValid()) WeakAction->Finish(Count >= 0, FVector::ZeroVector);
+		});
+	});
+}
+
+void UDynamoDBAsyncAction::Activate()
+{
+	UMarkerManager* Manager = Cast<UMarkerManager>(UGameplayStatics::GetGameInstance(WorldContext));
+	if (Manager == nullptr)
+	{
+		UE_LOG(LogMarkerManager, Warning, TEXT("DynamoDB async action requires MarkerManager as the Game Instance Class"));
+		Finish(false, FVector::ZeroVector);
+		return;
+	}
+	Operation(Manager, this);
+}
+
+void UDynamoDBAsyncAction::Finish(const bool Success, const FVector Location)
+{
+	if (Success) OnSuccess.Broadcast(Success, Location);
+	else OnFailure.Broadcast(Success, Location);
+	SetReadyToDestroy();
+}
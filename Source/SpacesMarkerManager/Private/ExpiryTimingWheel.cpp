@@ -0,0 +1,90 @@
+#include "ExpiryTimingWheel.h"
+
+#include "TemporaryMarker.h"
+
+FExpiryTimingWheel::FExpiryTimingWheel(const double InTickSeconds)
+	: TickSeconds(FMath::Max(InTickSeconds, 0.001))
+{
+}
+
+void FExpiryTimingWheel::Reset(const double Now)
+{
+	for (int32 Level = 0; Level < NumLevels; Level++)
+	{
+		for (int32 Slot = 0; Slot < NumSlots; Slot++)
+		{
+			Slots[Level][Slot].Reset();
+		}
+	}
+	Count = 0;
+	CurrentTick = static_cast<uint64>(FMath::Max(Now, 0.0) / TickSeconds);
+}
+
+void FExpiryTimingWheel::Schedule(ATemporaryMarker* Marker, const uint32 Generation, const double ExpireAt)
+{
+	FEntry Entry;
+	Entry.Marker = Marker;
+	Entry.Generation = Generation;
+	// round up, so a marker never expires before its time
+	const double ExpireTick = FMath::CeilToDouble(FMath::Max(ExpireAt, 0.0) / TickSeconds);
+	Entry.ExpireTick = FMath::Max(static_cast<uint64>(ExpireTick), CurrentTick + 1);
+	Insert(MoveTemp(Entry));
+	Count++;
+}
+
+void FExpiryTimingWheel::Insert(FEntry&& Entry)
+{
+	constexpr uint64 MaxDelta = (1ull << (SlotBits * NumLevels)) - 1;
+	Entry.ExpireTick = FMath::Min(Entry.ExpireTick, CurrentTick + MaxDelta);
+	const uint64 Delta = Entry.ExpireTick - CurrentTick;
+
+	// the lowest level whose span covers the delta
+	int32 Level = 0;
+	while (Level < NumLevels - 1 && Delta >= (1ull << (SlotBits * (Level + 1))))
+	{
+		Level++;
+	}
+	const int32 Slot = static_cast<int32>((Entry.ExpireTick >> (SlotBits * Level)) & SlotMask);
+	Slots[Level][Slot].Add(MoveTemp(Entry));
+}
+
+void FExpiryTimingWheel::Advance(const double Now, TArray<FEntry>& OutExpired)
+{
+	const uint64 TargetTick = static_cast<uint64>(FMath::Max(Now, 0.0) / TickSeconds);
+	while (CurrentTick < TargetTick)
+	{
+		CurrentTick++;
+
+		// when a level wraps, move the next slot of the level above down to where it now belongs
+		for (int32 Level = 1; Level < NumLevels; Level++)
+		{
+			if ((CurrentTick & ((1ull << (SlotBits * Level)) - 1)) != 0) break;
+			const int32 Slot = static_cast<int32>((CurrentTick >> (SlotBits * Level)) & SlotMask);
+			TArray<FEntry> Cascaded = MoveTemp(Slots[Level][Slot]);
+			Slots[Level][Slot].Reset();
+			for (FEntry& Entry : Cascaded)
+			{
+				Insert(MoveTemp(Entry));
+			}
+		}
+
+		TArray<FEntry>& Expired = Slots[0][CurrentTick & SlotMask];
+		Count -= Expired.Num();
+		OutExpired.Append(MoveTemp(Expired));
+		Expired.Reset();
+	}
+}
+
+void FExpiryTimingWheel::ForEach(const TFunctionRef<void(const FEntry&)> Visitor) const
+{
+	for (int32 Level = 0; Level < NumLevels; Level++)
+	{
+		for (int32 Slot = 0; Slot < NumSlots; Slot++)
+		{
+			for (const FEntry& Entry : Slots[Level][Slot])
+			{
+				Visitor(Entry);
+			}
+		}
+	}
+}
@@ -0,0 +1,143 @@
+#include "Geohash.h"
+
+namespace
+{
+	const ANSICHAR* GeohashAlphabet = "0123456789bcdefghjkmnpqrstuvwxyz";
+	constexpr double MetersPerDegreeLatitude = 111320.0;
+}
+
+FString FGeohash::Encode(const double Lat, const double Lon, const int32 Precision)
+{
+	double LatMin = -90.0, LatMax = 90.0;
+	double LonMin = -180.0, LonMax = 180.0;
+	FString Hash;
+	Hash.Reserve(Precision);
+
+	bool EvenBit = true;
+	int32 Bit = 0;
+	int32 Character = 0;
+	while (Hash.Len() < Precision)
+	{
+		if (EvenBit)
+		{
+			const double Mid = (LonMin + LonMax) / 2;
+			if (Lon >= Mid)
+			{
+				Character = (Character << 1) | 1;
+				LonMin = Mid;
+			}
+			else
+			{
+				Character = Character << 1;
+				LonMax = Mid;
+			}
+		}
+		else
+		{
+			const double Mid = (LatMin + LatMax) / 2;
+			if (Lat >= Mid)
+			{
+				Character = (Character << 1) | 1;
+				LatMin = Mid;
+			}
+			else
+			{
+				Character = Character << 1;
+				LatMax = Mid;
+			}
+		}
+		EvenBit = !EvenBit;
+
+		if (++Bit == 5)
+		{
+			Hash.AppendChar(GeohashAlphabet[Character]);
+			Bit = 0;
+			Character = 0;
+		}
+	}
+	return Hash;
+}
+
+void FGeohash::GetCellSize(const int32 Precision, double& OutLatDegrees, double& OutLonDegrees)
+{
+	const int32 Bits = 5 * Precision;
+	const int32 LonBits = (Bits + 1) / 2;
+	const int32 LatBits = Bits / 2;
+	OutLonDegrees = 360.0 / FMath::Pow(2.0, LonBits);
+	OutLatDegrees = 180.0 / FMath::Pow(2.0, LatBits);
+}
+
+TArray<FString> FGeohash::Expand(const FString& Hash, const int32 Precision)
+{
+	TArray<FString> Cells = {Hash};
+	for (int32 Length = Hash.Len(); Length < Precision; Length++)
+	{
+		TArray<FString> Children;
+		Children.Reserve(Cells.Num() * 32);
+		for (const FString& Cell : Cells)
+		{
+			for (const ANSICHAR* Character = GeohashAlphabet; *Character != '\0'; Character++)
+			{
+				Children.Add(Cell + *Character);
+			}
+		}
+		Cells = MoveTemp(Children);
+	}
+	return Cells;
+}
+
+TArray<FString> FGeohash::CoverRadius(const double Lat, const double Lon, const double RadiusMeters,
+                                      const int32 Precision, const int32 MaxCells)
+{
+	const double RadiusLat = RadiusMeters / MetersPerDegreeLatitude;
+	// a square that reaches a pole spans every longitude
+	const bool ReachesPole = FMath::Abs(Lat) + RadiusLat >= 90.0;
+	const double CosLat = FMath::Max(FMath::Cos(FMath::DegreesToRadians(Lat)), 0.01);
+	const double RadiusLon = ReachesPole ? 180.0 : FMath::Min(RadiusMeters / (MetersPerDegreeLatitude * CosLat), 180.0);
+
+	// coarser cells until the square fits in MaxCells of them, counting only the rows and columns that exist
+	int32 CellPrecision = FMath::Max(Precision, 1);
+	double CellLat, CellLon;
+	int32 StepsLat, StepsLon;
+	while (true)
+	{
+		GetCellSize(CellPrecision, CellLat, CellLon);
+		StepsLat = FMath::Min(FMath::CeilToInt(RadiusLat / CellLat), FMath::CeilToInt(180.0 / CellLat));
+		StepsLon = FMath::Min(FMath::CeilToInt(RadiusLon / CellLon), FMath::CeilToInt(180.0 / CellLon));
+		const int64 Rows = FMath::Min<int64>(2 * StepsLat + 1, FMath::CeilToInt(180.0 / CellLat) + 1);
+		const int64 Columns = FMath::Min<int64>(2 * StepsLon + 1, FMath::CeilToInt(360.0 / CellLon));
+		if (Rows * Columns <= MaxCells || CellPrecision == 1) break;
+		CellPrecision--;
+	}
+
+	// walk the cells outwards from the centre so truncation keeps the nearest ones
+	TArray<FIntPoint> Offsets;
+	Offsets.Reserve((2 * StepsLat + 1) * (2 * StepsLon + 1));
+	for (int32 y = -StepsLat; y <= StepsLat; y++)
+	{
+		for (int32 x = -StepsLon; x <= StepsLon; x++)
+		{
+			Offsets.Add(FIntPoint(x, y));
+		}
+	}
+	Offsets.Sort([](const FIntPoint& A, const FIntPoint& B) { return A.SizeSquared() < B.SizeSquared(); });
+
+	TArray<FString> Cells;
+	TSet<FString> Seen;
+	for (const FIntPoint& Offset : Offsets)
+	{
+		const double CellCentreLat = Lat + Offset.Y * CellLat;
+		if (CellCentreLat < -90.0 || CellCentreLat > 90.0) continue;
+		double CellCentreLon = Lon + Offset.X * CellLon;
+		CellCentreLon = FMath::Fmod(CellCentreLon + 540.0, 360.0) - 180.0;
+
+		FString Cell = Encode(CellCentreLat, CellCentreLon, CellPrecision);
+		if (!Seen.Contains(Cell))
+		{
+			Seen.Add(Cell);
+			Cells.Add(MoveTemp(Cell));
+			if (Cells.Num() >= MaxCells) break;
+		}
+	}
+	return Cells;
+}
\ No newline at end of file
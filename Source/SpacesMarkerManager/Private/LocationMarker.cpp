@@ -48,13 +48,19 @@ ALocationMarker::ALocationMarker()
 
 bool ALocationMarker::ToggleSelection()
 {
-	Selected = !Selected;
-	if (Selected) SetColor(FColor::Red);
-	else SetColor(BaseColor);
+	SetSelected(!Selected);
 	UE_LOG(LogLocationMarker, Display, TEXT("%s: %s"), Selected ? TEXT("Selected") : TEXT("Unselected"), *ToString());
 	return Selected;
 }
 
+void ALocationMarker::SetSelected(const bool InSelected)
+{
+	if (Selected == InSelected) return;
+	Selected = InSelected;
+	if (Selected) SetColor(FColor::Red);
+	else SetColor(BaseColor);
+}
+
 void ALocationMarker::SetColor(const FLinearColor Color) const
 {
 	DynamicMaterial->SetVectorParameterValue(TEXT("Color"), Color);
@@ -106,13 +112,13 @@ TSharedRef<FJsonObject> ALocationMarker::ToJsonObject() const
 {
 	const TSharedRef<FJsonObject> JsonObject = MakeShareable(new FJsonObject);
 
-	if (!DeviceID.IsEmpty()) JsonObject->SetStringField(PartitionKeyAttributeName, this->DeviceID);
-	else JsonObject->SetStringField(PartitionKeyAttributeName, FString(""));
-	JsonObject->SetStringField(SortKeyAttributeName, FString::FromInt(LocationTs.Timestamp.ToUnixTimestamp()));
-	JsonObject->SetStringField(PositionXAttributeName, FString::SanitizeFloat(LocationTs.UECoordinate.X));
-	JsonObject->SetStringField(PositionYAttributeName, FString::SanitizeFloat(LocationTs.UECoordinate.Y));
-	JsonObject->SetStringField(PositionZAttributeName, FString::SanitizeFloat(LocationTs.UECoordinate.Z));
-	JsonObject->SetStringField(MarkerTypeAttributeName, UEnum::GetValueAsName(this->MarkerType).ToString());
+	if (!DeviceID.IsEmpty()) JsonObject->SetStringField(AwsStringToFString(PartitionKeyAttributeNameAws), this->DeviceID);
+	else JsonObject->SetStringField(AwsStringToFString(PartitionKeyAttributeNameAws), FString(""));
+	JsonObject->SetStringField(AwsStringToFString(SortKeyAttributeNameAws), FString::FromInt(LocationTs.Timestamp.ToUnixTimestamp()));
+	JsonObject->SetStringField(AwsStringToFString(PositionXAttributeNameAws), FString::SanitizeFloat(LocationTs.UECoordinate.X));
+	JsonObject->SetStringField(AwsStringToFString(PositionYAttributeNameAws), FString::SanitizeFloat(LocationTs.UECoordinate.Y));
+	JsonObject->SetStringField(AwsStringToFString(PositionZAttributeNameAws), FString::SanitizeFloat(LocationTs.UECoordinate.Z));
+	JsonObject->SetStringField(AwsStringToFString(MarkerTypeAttributeNameAws), UEnum::GetValueAsName(this->MarkerType).ToString());
 	return JsonObject;
 }
 
@@ -0,0 +1,56 @@
+#include "MarkerAnchorArray.h"
+
+#include "LocationMarker.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	// Small enough to spread over the workers, large enough to outweigh the task overhead
+	constexpr int32 TransformChunkSize = 4096;
+}
+
+void FMarkerAnchorArray::Add(const FString& DeviceID, ALocationMarker* Marker, const FVector& EcefCoordinate)
+{
+	if (const int32* Existing = Index.Find(DeviceID))
+	{
+		EcefCoordinates[*Existing] = EcefCoordinate;
+		Markers[*Existing] = Marker;
+		return;
+	}
+	Index.Add(DeviceID, EcefCoordinates.Add(EcefCoordinate));
+	Markers.Add(Marker);
+	DeviceIDs.Add(DeviceID);
+}
+
+void FMarkerAnchorArray::Remove(const FString& DeviceID)
+{
+	int32 Removed;
+	if (!Index.RemoveAndCopyValue(DeviceID, Removed)) return;
+	EcefCoordinates.RemoveAtSwap(Removed, 1, false);
+	Markers.RemoveAtSwap(Removed, 1, false);
+	DeviceIDs.RemoveAtSwap(Removed, 1, false);
+	if (Removed < DeviceIDs.Num()) Index.Add(DeviceIDs[Removed], Removed);
+}
+
+void FMarkerAnchorArray::Reset()
+{
+	EcefCoordinates.Reset();
+	Markers.Reset();
+	DeviceIDs.Reset();
+	Index.Reset();
+}
+
+void FMarkerAnchorArray::Transform(const FMatrix& EcefToUnreal, TArray<FVector>& OutLocations) const
+{
+	const int32 Count = EcefCoordinates.Num();
+	OutLocations.SetNumUninitialized(Count);
+	const int32 NumChunks = FMath::DivideAndRoundUp(Count, TransformChunkSize);
+	ParallelFor(NumChunks, [this, &EcefToUnreal, &OutLocations, Count](const int32 Chunk)
+	{
+		const int32 End = FMath::Min((Chunk + 1) * TransformChunkSize, Count);
+		for (int32 i = Chunk * TransformChunkSize; i < End; i++)
+		{
+			OutLocations[i] = EcefToUnreal.TransformPosition(EcefCoordinates[i]);
+		}
+	});
+}
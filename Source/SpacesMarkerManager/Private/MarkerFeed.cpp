@@ -0,0 +1,279 @@
+#include "MarkerFeed.h"
+
+#include "MarkerManager.h"
+#include "Settings.h"
+#include "HAL/Event.h"
+#include "HAL/RunnableThread.h"
+#include "aws/core/client/ClientConfiguration.h"
+#include "aws/dynamodbstreams/DynamoDBStreamsErrors.h"
+#include "aws/dynamodbstreams/model/DescribeStreamRequest.h"
+#include "aws/dynamodbstreams/model/GetRecordsRequest.h"
+#include "aws/dynamodbstreams/model/GetShardIteratorRequest.h"
+#include "aws/dynamodbstreams/model/ListStreamsRequest.h"
+
+FMarkerFeed::FMarkerFeed(const FMarkerFeedConfig& InConfig, const Aws::Auth::AWSCredentials& Credentials)
+	: Config(InConfig), TableName(FStringToAwsString(InConfig.TableName))
+{
+	Aws::Client::ClientConfiguration ClientConfig = Aws::Client::ClientConfiguration();
+	ClientConfig.region = Config.Region.IsEmpty() ? Aws::String(SpacesAwsRegion) : FStringToAwsString(Config.Region);
+	if (UseDynamoDBLocal) ClientConfig.endpointOverride = DynamoDBLocalEndpoint;
+	Client = MakeUnique<Aws::DynamoDBStreams::DynamoDBStreamsClient>(Credentials, ClientConfig);
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+}
+
+FMarkerFeed::~FMarkerFeed()
+{
+	Shutdown();
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+}
+
+void FMarkerFeed::Start()
+{
+	if (Thread != nullptr) return;
+	Stopping = false;
+	Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("MarkerFeed %s"), *Config.Name), 0, TPri_BelowNormal);
+}
+
+void FMarkerFeed::Shutdown()
+{
+	if (Thread == nullptr) return;
+	Stop();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+}
+
+void FMarkerFeed::Stop()
+{
+	Stopping = true;
+	WakeEvent->Trigger();
+}
+
+bool FMarkerFeed::Dequeue(FRawMarkerRecord& OutRecord)
+{
+	if (!Records.Dequeue(OutRecord)) return false;
+	QueuedRecords.Decrement();
+	return true;
+}
+
+FMarkerFeedStatus FMarkerFeed::GetStatus() const
+{
+	FMarkerFeedStatus Status;
+	Status.Name = Config.Name;
+	Status.TableName = Config.TableName;
+	Status.Running = Thread != nullptr && !Stopping;
+	Status.ShardCount = ShardCount.GetValue();
+	Status.RecordsReceived = RecordsReceived.GetValue();
+	Status.DuplicateRecordsDropped = DuplicateRecordsDropped.GetValue();
+	Status.Errors = Errors.GetValue();
+	Status.QueuedRecords = QueuedRecords.GetValue();
+	Status.PausedShardReads = PausedShardReads.GetValue();
+	return Status;
+}
+
+uint32 FMarkerFeed::Run()
+{
+	UE_LOG(LogMarkerManager, Display, TEXT("Marker feed %s started for table %s"), *Config.Name, *Config.TableName);
+	while (!Stopping)
+	{
+		if (!TopologyKnown || FPlatformTime::Seconds() - LastTopologyRefresh >= Config.TopologyRefreshInterval)
+		{
+			RefreshTopology();
+		}
+
+		// read one shard after the other on this thread; the calls block on the network,
+		// and handing them to the task graph would keep its workers from engine work
+		for (const TUniquePtr<FShardState>& Shard : Shards)
+		{
+			if (Stopping) break;
+			PollShard(*Shard);
+		}
+
+		// a closed shard is done once its last page has been read
+		for (int32 i = Shards.Num() - 1; i >= 0; i--)
+		{
+			if (Shards[i]->Finished)
+			{
+				FinishedShards.Add(Shards[i]->ShardId);
+				Shards.RemoveAt(i);
+			}
+		}
+		ShardCount.Set(Shards.Num());
+
+		WakeEvent->Wait(FTimespan::FromSeconds(FMath::Max(Config.PollingInterval, 0.1f)));
+	}
+	UE_LOG(LogMarkerManager, Display, TEXT("Marker feed %s stopped"), *Config.Name);
+	return 0;
+}
+
+void FMarkerFeed::RefreshTopology()
+{
+	LastTopologyRefresh = FPlatformTime::Seconds();
+	const Aws::DynamoDBStreams::Model::ListStreamsOutcome ListStreamsOutcome = Client->ListStreams(
+		Aws::DynamoDBStreams::Model::ListStreamsRequest().WithTableName(TableName));
+	if (!ListStreamsOutcome.IsSuccess())
+	{
+		Errors.Increment();
+		UE_LOG(LogMarkerManager, Warning, TEXT("Marker feed %s: ListStreams error: %s"), *Config.Name,
+		       UTF8_TO_TCHAR(ListStreamsOutcome.GetError().GetMessage().c_str()));
+		return;
+	}
+
+	// a table has at most one enabled stream, while disabled streams stay listed for 24 hours
+	for (const Aws::DynamoDBStreams::Model::Stream& Stream : ListStreamsOutcome.GetResult().GetStreams())
+	{
+		Aws::DynamoDBStreams::Model::DescribeStreamRequest Request;
+		Request.SetStreamArn(Stream.GetStreamArn());
+		Aws::Vector<Aws::DynamoDBStreams::Model::Shard> StreamShards;
+		bool Enabled = false;
+		do
+		{
+			const Aws::DynamoDBStreams::Model::DescribeStreamOutcome Outcome = Client->DescribeStream(Request);
+			if (!Outcome.IsSuccess())
+			{
+				Errors.Increment();
+				UE_LOG(LogMarkerManager, Warning, TEXT("Marker feed %s: DescribeStream error: %s"), *Config.Name,
+				       UTF8_TO_TCHAR(Outcome.GetError().GetMessage().c_str()));
+				return;
+			}
+			const Aws::DynamoDBStreams::Model::StreamDescription& Description = Outcome.GetResult().GetStreamDescription();
+			Enabled = Description.GetStreamStatus() == Aws::DynamoDBStreams::Model::StreamStatus::ENABLED;
+			StreamShards.insert(StreamShards.end(), Description.GetShards().begin(), Description.GetShards().end());
+			Request.SetExclusiveStartShardId(Description.GetLastEvaluatedShardId());
+		}
+		while (Enabled && !Request.GetExclusiveStartShardId().empty());
+		if (!Enabled) continue;
+
+		if (Stream.GetStreamArn() != StreamArn)
+		{
+			// the stream was re-enabled, which starts over with new shards
+			StreamArn = Stream.GetStreamArn();
+			Shards.Reset();
+			FinishedShards.Reset();
+		}
+
+		for (const Aws::DynamoDBStreams::Model::Shard& StreamShard : StreamShards)
+		{
+			if (FinishedShards.Contains(StreamShard.GetShardId())) continue;
+			if (Shards.ContainsByPredicate(
+				[&StreamShard](const TUniquePtr<FShardState>& Shard) { return Shard->ShardId == StreamShard.GetShardId(); }))
+			{
+				continue;
+			}
+
+			// shards that exist when the feed starts are read from the latest record, unless replaying.
+			// shards that appear later are children of a split, and are read from the start.
+			const bool FromLatest = !TopologyKnown && !Config.StartFromTrimHorizon;
+			if (FromLatest && !StreamShard.GetSequenceNumberRange().GetEndingSequenceNumber().empty())
+			{
+				// closed shards have no latest record to wait for
+				FinishedShards.Add(StreamShard.GetShardId());
+				continue;
+			}
+			TUniquePtr<FShardState> Shard = MakeUnique<FShardState>();
+			Shard->ShardId = StreamShard.GetShardId();
+			Shard->InitialIteratorType = FromLatest
+				                             ? Aws::DynamoDBStreams::Model::ShardIteratorType::LATEST
+				                             : Aws::DynamoDBStreams::Model::ShardIteratorType::TRIM_HORIZON;
+			CreateIterator(*Shard, Shard->InitialIteratorType);
+			Shards.Add(MoveTemp(Shard));
+		}
+		TopologyKnown = true;
+		ShardCount.Set(Shards.Num());
+		UE_LOG(LogMarkerManager, Display, TEXT("Marker feed %s: reading %d shards"), *Config.Name, Shards.Num());
+		return;
+	}
+	UE_LOG(LogMarkerManager, Warning, TEXT("Marker feed %s: table %s has no enabled stream"), *Config.Name, *Config.TableName);
+}
+
+bool FMarkerFeed::CreateIterator(FShardState& Shard, const Aws::DynamoDBStreams::Model::ShardIteratorType IteratorType)
+{
+	Aws::DynamoDBStreams::Model::GetShardIteratorRequest Request;
+	Request.SetStreamArn(StreamArn);
+	Request.SetShardId(Shard.ShardId);
+	Request.SetShardIteratorType(IteratorType);
+	if (IteratorType == Aws::DynamoDBStreams::Model::ShardIteratorType::AFTER_SEQUENCE_NUMBER)
+	{
+		Request.SetSequenceNumber(Shard.Deduplicator.GetHighWatermark());
+	}
+
+	const Aws::DynamoDBStreams::Model::GetShardIteratorOutcome Outcome = Client->GetShardIterator(Request);
+	if (!Outcome.IsSuccess())
+	{
+		Errors.Increment();
+		UE_LOG(LogMarkerManager, Warning, TEXT("Marker feed %s: could not create iterator for shard %s: %s"), *Config.Name,
+		       UTF8_TO_TCHAR(Shard.ShardId.c_str()), UTF8_TO_TCHAR(Outcome.GetError().GetMessage().c_str()));
+		return false;
+	}
+	Shard.Iterator = Outcome.GetResult().GetShardIterator();
+	Shard.Deduplicator.BeginRun();
+	return true;
+}
+
+void FMarkerFeed::PollShard(FShardState& Shard)
+{
+	if (Shard.Iterator.empty())
+	{
+		// resume after the checkpoint, if anything has been read yet
+		if (!CreateIterator(Shard, Shard.Deduplicator.GetHighWatermark().empty()
+			                           ? Shard.InitialIteratorType
+			                           : Aws::DynamoDBStreams::Model::ShardIteratorType::AFTER_SEQUENCE_NUMBER))
+		{
+			return;
+		}
+	}
+
+	FRawMarkerRecord RawRecord;
+	for (int32 Page = 0; Page < Config.MaxPagesPerShard && !Stopping && !Shard.Iterator.empty(); Page++)
+	{
+		// the game thread is behind; the shard keeps its position and is read again on a later poll
+		if (QueuedRecords.GetValue() >= Config.MaxQueuedRecords)
+		{
+			PausedShardReads.Increment();
+			return;
+		}
+
+		const Aws::DynamoDBStreams::Model::GetRecordsOutcome Outcome = Client->GetRecords(
+			Aws::DynamoDBStreams::Model::GetRecordsRequest().WithShardIterator(Shard.Iterator));
+		if (!Outcome.IsSuccess())
+		{
+			const Aws::DynamoDBStreams::DynamoDBStreamsErrors ErrorType = Outcome.GetError().GetErrorType();
+			if (ErrorType == Aws::DynamoDBStreams::DynamoDBStreamsErrors::EXPIRED_ITERATOR ||
+				ErrorType == Aws::DynamoDBStreams::DynamoDBStreamsErrors::TRIMMED_DATA_ACCESS)
+			{
+				// picked up again from the checkpoint on the next poll
+				Shard.Iterator.clear();
+			}
+			else
+			{
+				Errors.Increment();
+				UE_LOG(LogMarkerManager, Warning, TEXT("Marker feed %s: GetRecords error: %s"), *Config.Name,
+				       UTF8_TO_TCHAR(Outcome.GetError().GetMessage().c_str()));
+			}
+			return;
+		}
+
+		const Aws::DynamoDBStreams::Model::GetRecordsResult& Result = Outcome.GetResult();
+		for (const Aws::DynamoDBStreams::Model::Record& Record : Result.GetRecords())
+		{
+			if (Record.GetEventName() != Aws::DynamoDBStreams::Model::OperationType::INSERT) continue;
+			if (!Shard.Deduplicator.Accept(Record.GetDynamodb().GetSequenceNumber()))
+			{
+				DuplicateRecordsDropped.Increment();
+				continue;
+			}
+			if (FRawMarkerRecord::FromStreamRecord(Record.GetDynamodb(), RawRecord))
+			{
+				Records.Enqueue(RawRecord);
+				QueuedRecords.Increment();
+				RecordsReceived.Increment();
+			}
+		}
+
+		// an empty next iterator means the shard is closed and has been read to the end
+		Shard.Iterator = Result.GetNextShardIterator();
+		if (Shard.Iterator.empty()) Shard.Finished = true;
+		if (Result.GetRecords().empty()) break;
+	}
+}
@@ -0,0 +1,83 @@
+#include "MarkerInterestGrid.h"
+
+FMarkerInterestGrid::FMarkerInterestGrid(const double InCellSize)
+	: CellSize(FMath::Max(InCellSize, 1.0))
+{
+}
+
+void FMarkerInterestGrid::Reset(const double InCellSize)
+{
+	CellSize = FMath::Max(InCellSize, 1.0);
+	Devices.Reset();
+	Cells.Reset();
+	NextVersion();
+}
+
+FIntVector FMarkerInterestGrid::GetCell(const FVector& UECoordinate) const
+{
+	return FIntVector(FMath::FloorToInt(UECoordinate.X / CellSize), FMath::FloorToInt(UECoordinate.Y / CellSize),
+	                  FMath::FloorToInt(UECoordinate.Z / CellSize));
+}
+
+int32 FMarkerInterestGrid::GetCellDistance(const FIntVector& A, const FIntVector& B)
+{
+	return FMath::Max3(FMath::Abs(A.X - B.X), FMath::Abs(A.Y - B.Y), FMath::Abs(A.Z - B.Z));
+}
+
+void FMarkerInterestGrid::Upsert(const FString& DeviceID, const ELocationMarkerType MarkerType, const FLocationTs& LocationTs)
+{
+	const FIntVector NewCell = GetCell(LocationTs.UECoordinate);
+	FDevice* Device = Devices.Find(DeviceID);
+	if (Device != nullptr)
+	{
+		if (LocationTs.Timestamp < Device->LocationTs.Timestamp) return;
+
+		FCell& OldCell = Cells.FindChecked(Device->Cell);
+		OldCell.LocationSum -= Device->LocationTs.UECoordinate;
+		if (Device->Cell != NewCell)
+		{
+			OldCell.DeviceIDs.Remove(DeviceID);
+			OldCell.Version = NextVersion();
+			if (OldCell.DeviceIDs.Num() == 0) Cells.Remove(Device->Cell);
+		}
+	}
+	else
+	{
+		Device = &Devices.Add(DeviceID);
+	}
+
+	Device->MarkerType = MarkerType;
+	Device->LocationTs = LocationTs;
+	Device->Cell = NewCell;
+	Device->Version = NextVersion();
+
+	FCell& Cell = Cells.FindOrAdd(NewCell);
+	Cell.DeviceIDs.Add(DeviceID);
+	Cell.LocationSum += LocationTs.UECoordinate;
+	Cell.Version = Device->Version;
+}
+
+void FMarkerInterestGrid::Reanchor(const FMatrix& EcefToUnreal)
+{
+	// every device gets a new version, so each replicator resends the cells it watches
+	TMap<FString, FDevice> Moved = MoveTemp(Devices);
+	Devices.Reset();
+	Cells.Reset();
+	for (TPair<FString, FDevice>& Pair : Moved)
+	{
+		Pair.Value.LocationTs.UECoordinate = EcefToUnreal.TransformPosition(Pair.Value.LocationTs.EcefCoordinate);
+		Upsert(Pair.Key, Pair.Value.MarkerType, Pair.Value.LocationTs);
+	}
+}
+
+void FMarkerInterestGrid::Remove(const FString& DeviceID)
+{
+	FDevice Device;
+	if (!Devices.RemoveAndCopyValue(DeviceID, Device)) return;
+
+	FCell& Cell = Cells.FindChecked(Device.Cell);
+	Cell.DeviceIDs.Remove(DeviceID);
+	Cell.LocationSum -= Device.LocationTs.UECoordinate;
+	Cell.Version = NextVersion();
+	if (Cell.DeviceIDs.Num() == 0) Cells.Remove(Device.Cell);
+}
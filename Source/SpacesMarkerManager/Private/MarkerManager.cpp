@@ -1,14 +1,21 @@
 #include "MarkerManager.h"
 
 #include "DynamicMarker.h"
+#include "Geohash.h"
+#include "MarkerReplicator.h"
+#include "MarkerStreamFastForward.h"
 #include "Settings.h"
 #include "TemporaryMarker.h"
+#include "UnrealAwsExecutor.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
 #include "aws/core/Aws.h"
 #include "aws/core/auth/AWSCredentials.h"
 #include "aws/core/client/ClientConfiguration.h"
 #include "aws/core/http/standard/StandardHttpRequest.h"
 #include "aws/dynamodb/DynamoDBClient.h"
 #include "aws/dynamodb/model/DeleteItemRequest.h"
+#include "aws/dynamodb/model/DescribeTableRequest.h"
 #include "aws/dynamodb/model/PutItemRequest.h"
 #include "aws/dynamodb/model/QueryRequest.h"
 #include "aws/dynamodb/model/ScanRequest.h"
@@ -17,7 +24,14 @@
 #include "aws/dynamodbstreams/model/GetShardIteratorRequest.h"
 #include "aws/dynamodbstreams/model/ListStreamsRequest.h"
 #include "CesiumGeoreference.h"
-#include "Misc/DefaultValueHelper.h"
+#include "ConvexVolume.h"
+#include "SceneManagement.h"
+#include "SceneView.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/SphereComponent.h"
+#include "Engine/LocalPlayer.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
 
 DEFINE_LOG_CATEGORY(LogMarkerManager);
 
@@ -25,31 +39,242 @@ void UMarkerManager::Init()
 {
 	UE_LOG(LogMarkerManager, Display, TEXT("Game instance initializing"));
 	Super::Init();
-	UE_LOG(LogMarkerManager, Display, TEXT("Initializing AWS SDK..."));
-	Aws::InitAPI(Aws::SDKOptions());
 
-	const Aws::Auth::AWSCredentials Credentials = Aws::Auth::AWSCredentials(AWSAccessKeyId, AWSSecretKey);
-	Aws::Client::ClientConfiguration Config = Aws::Client::ClientConfiguration();
-	Config.region = SpacesAwsRegion;
-	if (UseDynamoDBLocal) Config.endpointOverride = DynamoDBLocalEndpoint;
+	// SDK and client setup takes a while, and runs alongside the first level load instead of before it
+	UE_LOG(LogMarkerManager, Display, TEXT("Initializing AWS SDK in the background..."));
+	TWeakObjectPtr<UMarkerManager> WeakThis(this);
+	const bool Warm = WarmAwsConnections;
+	AwsStartup = Async(EAsyncExecution::ThreadPool, [this, WeakThis, Warm]()
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		Aws::InitAPI(Aws::SDKOptions());
+
+		const Aws::Auth::AWSCredentials Credentials = Aws::Auth::AWSCredentials(AWSAccessKeyId, AWSSecretKey);
+		Aws::Client::ClientConfiguration Config = Aws::Client::ClientConfiguration();
+		Config.region = SpacesAwsRegion;
+		if (UseDynamoDBLocal) Config.endpointOverride = DynamoDBLocalEndpoint;
+		// *Async requests run on the engine thread pool
+		AwsExecutor = Aws::MakeShared<FUnrealAwsExecutor>("SpacesMarkerManager");
+		Config.executor = AwsExecutor;
+
+		DynamoClient = new Aws::DynamoDB::DynamoDBClient(Credentials, Config);
+		DynamoDBStreamsClient = new Aws::DynamoDBStreams::DynamoDBStreamsClient(Credentials, Config);
+		UE_LOG(LogMarkerManager, Display, TEXT("Initialized AWS SDK and DynamoDB clients in %.0f ms"),
+		       (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+		if (Warm)
+		{
+			// resolves the endpoint and opens a TLS connection that later requests reuse
+			const double WarmStartTime = FPlatformTime::Seconds();
+			DynamoClient->DescribeTableAsync(
+				Aws::DynamoDB::Model::DescribeTableRequest().WithTableName(DynamoDBTableNameAws),
+				[WarmStartTime](const Aws::DynamoDB::DynamoDBClient*,
+				                const Aws::DynamoDB::Model::DescribeTableRequest&,
+				                const Aws::DynamoDB::Model::DescribeTableOutcome& Outcome,
+				                const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+				{
+					if (Outcome.IsSuccess())
+					{
+						UE_LOG(LogMarkerManager, Display, TEXT("DynamoDB connection warmed in %.0f ms"),
+						       (FPlatformTime::Seconds() - WarmStartTime) * 1000.0);
+					}
+					else
+					{
+						UE_LOG(LogMarkerManager, Warning, TEXT("DescribeTable error: %s"),
+						       UTF8_TO_TCHAR(Outcome.GetError().GetMessage().c_str()));
+					}
+				});
+		}
 
-	DynamoClient = new Aws::DynamoDB::DynamoDBClient(Credentials, Config);
-	UE_LOG(LogMarkerManager, Display, TEXT("DynamoDB client ready"));
+		AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+		{
+			if (WeakThis.IsValid()) WeakThis->FinishAwsStartup();
+		});
+	});
+
+	ApplyQueueTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &UMarkerManager::TickApplyQueue));
 
-	DynamoDBStreamsClient = new Aws::DynamoDBStreams::DynamoDBStreamsClient(Credentials, Config);
-	UE_LOG(LogMarkerManager, Display, TEXT("DynamoDB Streams client ready/ Initialized AWS SDK."));
+	UE_LOG(LogMarkerManager, Display, TEXT("Initialized MarkerManager GameInstance."));
+}
 
-	if (UseCesiumGeoreference)
+void UMarkerManager::OnStart()
+{
+	Super::OnStart();
+	// the georeference lives in the level, which exists by now
+	if (UseCesiumGeoreference && Georeference == nullptr)
 	{
 		this->Georeference = ACesiumGeoreference::GetDefaultGeoreference(this);
 		UE_LOG(LogMarkerManager, Display, TEXT("Initialized CesiumGeoreference."));
 	}
+	if (Georeference != nullptr && UseCesiumGeoreference)
+	{
+		// history is stored as WGS84 and converted with the current georeference when read
+		TemporalStore.SetLocationConverter([this](const FDateTime Timestamp, const FVector& Wgs84)
+		{
+			return WrapLocationTs(Timestamp, Wgs84);
+		});
+	}
+	if (Georeference != nullptr && BatchedReanchoring)
+	{
+		AnchoredEcefToUnreal = GetEcefToUnrealTransform();
+		Georeference->OnGeoreferenceUpdated.AddUniqueDynamic(this, &UMarkerManager::OnGeoreferenceUpdated);
+	}
+}
 
-	UE_LOG(LogMarkerManager, Display, TEXT("Initialized MarkerManager GameInstance."));
+FMatrix UMarkerManager::GetEcefToUnrealTransform() const
+{
+	// the transform is affine, so the image of the origin and of three axis points recovers it exactly.
+	// long axes keep the rounding of the large ECEF offsets out of the rotation part.
+	constexpr double Axis = 1.0e6;
+	const auto ToUnreal = [this](const double X, const double Y, const double Z)
+	{
+		const glm::dvec3 Unreal = Georeference->TransformEcefToUnreal(glm::dvec3(X, Y, Z));
+		return FVector(Unreal.x, Unreal.y, Unreal.z);
+	};
+	const FVector Origin = ToUnreal(0.0, 0.0, 0.0);
+	const FVector X = (ToUnreal(Axis, 0.0, 0.0) - Origin) / Axis;
+	const FVector Y = (ToUnreal(0.0, Axis, 0.0) - Origin) / Axis;
+	const FVector Z = (ToUnreal(0.0, 0.0, Axis) - Origin) / Axis;
+	return FMatrix(FPlane(X, 0.0), FPlane(Y, 0.0), FPlane(Z, 0.0), FPlane(Origin, 1.0));
+}
+
+void UMarkerManager::OnGeoreferenceUpdated()
+{
+	if (BatchedReanchoring) ReanchorMarkers();
+}
+
+void UMarkerManager::ReanchorMarkers()
+{
+	if (Georeference == nullptr) return;
+	const double StartTime = FPlatformTime::Seconds();
+	const FMatrix EcefToUnreal = GetEcefToUnrealTransform();
+	// moves points that were placed with the previous transform, for positions between two history entries
+	const FMatrix Delta = AnchoredEcefToUnreal.Inverse() * EcefToUnreal;
+	AnchoredEcefToUnreal = EcefToUnreal;
+
+	// markers that do not move: one parallel transform, then one loop of moves
+	TArray<FVector> Locations;
+	MarkerAnchors.Transform(EcefToUnreal, Locations);
+	const TArray<TWeakObjectPtr<ALocationMarker>>& Anchored = MarkerAnchors.GetMarkers();
+	for (int32 i = 0; i < Anchored.Num(); i++)
+	{
+		ALocationMarker* Marker = Anchored[i].Get();
+		if (Marker == nullptr) continue;
+		Marker->LocationTs.UECoordinate = Locations[i];
+		Marker->SetActorLocation(Locations[i], false, nullptr, ETeleportType::TeleportPhysics);
+	}
+
+	// dynamic markers: their histories are plain data, converted in parallel
+	TArray<ADynamicMarker*> DynamicMarkers;
+	for (const TPair<FString, ALocationMarker*>& Pair : SpawnedLocationMarkers)
+	{
+		if (ADynamicMarker* DynamicMarker = Cast<ADynamicMarker>(Pair.Value)) DynamicMarkers.Add(DynamicMarker);
+	}
+	TArray<bool> AtTarget;
+	AtTarget.SetNumUninitialized(DynamicMarkers.Num());
+	for (int32 i = 0; i < DynamicMarkers.Num(); i++)
+	{
+		AtTarget[i] = DynamicMarkers[i]->CurrentLocation == DynamicMarkers[i]->LocationTs.UECoordinate;
+	}
+	ParallelFor(DynamicMarkers.Num(), [&DynamicMarkers, &EcefToUnreal](const int32 i)
+	{
+		ADynamicMarker* Marker = DynamicMarkers[i];
+		for (FLocationTs& Location : Marker->HistoryArr)
+		{
+			Location.UECoordinate = EcefToUnreal.TransformPosition(Location.EcefCoordinate);
+		}
+		Marker->LocationTs.UECoordinate = EcefToUnreal.TransformPosition(Marker->LocationTs.EcefCoordinate);
+	});
+	for (int32 i = 0; i < DynamicMarkers.Num(); i++)
+	{
+		ADynamicMarker* Marker = DynamicMarkers[i];
+		Marker->CurrentLocation = AtTarget[i] ? Marker->LocationTs.UECoordinate : Delta.TransformPosition(Marker->CurrentLocation);
+		Marker->SetActorLocation(Marker->CurrentLocation, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+
+	// queued updates would otherwise spawn at positions of the old origin
+	for (FMarkerRecordBatch& Batch : PendingBatches)
+	{
+		for (FLocationTs& Location : Batch.Locations)
+		{
+			Location.UECoordinate = EcefToUnreal.TransformPosition(Location.EcefCoordinate);
+		}
+	}
+	PendingBatchesNeedSort = true;
+	ReorderBuffer.Reanchor(EcefToUnreal);
+	for (TPair<FString, TArray<FMarkerRecord>>& Pair : TileCache)
+	{
+		for (FMarkerRecord& Record : Pair.Value)
+		{
+			Record.LocationTs.UECoordinate = EcefToUnreal.TransformPosition(Record.LocationTs.EcefCoordinate);
+		}
+	}
+	if (ReplicationServer) InterestGrid.Reanchor(EcefToUnreal);
+
+	// every pickable marker has moved, so the grid is rebuilt rather than updated cell by cell
+	if (PickingGrid.Num() > 0)
+	{
+		TArray<ALocationMarker*> Pickable;
+		for (const TPair<FString, ALocationMarker*>& Pair : SpawnedLocationMarkers)
+		{
+			if (Pair.Value != nullptr && PickingGrid.Contains(Pair.Key)) Pickable.Add(Pair.Value);
+		}
+		PickingGrid.Reset(PickingCellSize);
+		for (ALocationMarker* Marker : Pickable)
+		{
+			PickingGrid.Update(Marker->DeviceID, Marker, Marker->GetActorLocation(), Marker->DefaultRadius * Marker->GetActorScale3D().GetMax());
+		}
+	}
+
+	UE_LOG(LogMarkerManager, Display, TEXT("Re-anchored %d markers and %d dynamic markers in %.2f ms"), MarkerAnchors.Num(),
+	       DynamicMarkers.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	OnMarkersReanchored.Broadcast();
+}
+
+void UMarkerManager::FinishAwsStartup()
+{
+	if (AwsReady) return;
+	AwsReady = true;
+	TArray<TUniqueFunction<void()>> Calls = MoveTemp(PendingAwsCalls);
+	PendingAwsCalls.Reset();
+	UE_LOG(LogMarkerManager, Display, TEXT("AWS ready, running %d queued calls"), Calls.Num());
+	for (TUniqueFunction<void()>& Call : Calls)
+	{
+		Call();
+	}
+	OnAwsReady.Broadcast();
+}
+
+void UMarkerManager::WhenAwsReady(TUniqueFunction<void()>&& Call) const
+{
+	if (AwsReady) Call();
+	else PendingAwsCalls.Add(MoveTemp(Call));
+}
+
+void UMarkerManager::WaitForAws() const
+{
+	if (AwsReady || !AwsStartup.IsValid()) return;
+	UE_LOG(LogMarkerManager, Display, TEXT("Waiting for AWS startup"));
+	AwsStartup.Wait();
 }
 
 void UMarkerManager::Shutdown()
 {
+	FTSTicker::GetCoreTicker().RemoveTicker(ApplyQueueTickerHandle);
+	// the SDK cannot shut down while it is still starting
+	if (AwsStartup.IsValid()) AwsStartup.Wait();
+	PendingAwsCalls.Reset();
+	// the feeds' clients have to be destroyed before the SDK shuts down
+	StopMarkerFeeds();
+	// and our own background requests and the *Async calls in flight have to finish
+	if (BackgroundAwsTasks.GetValue() > 0 || (AwsExecutor && AwsExecutor->GetOutstandingTasks() > 0))
+	{
+		UE_LOG(LogMarkerManager, Display, TEXT("Waiting for %d background tasks and %d AWS requests"),
+		       BackgroundAwsTasks.GetValue(), AwsExecutor ? AwsExecutor->GetOutstandingTasks() : 0);
+	}
+	while (BackgroundAwsTasks.GetValue() > 0) FPlatformProcess::Sleep(0.001f);
+	if (AwsExecutor) AwsExecutor->WaitForTasks();
 	Super::Shutdown();
 	Aws::ShutdownAPI(Aws::SDKOptions());
 	UE_LOG(LogMarkerManager, Display, TEXT("MarkerManager GameInstance shutdown complete"));
@@ -71,86 +296,221 @@ void UMarkerManager::DynamoDBStreamsListen()
 
 void UMarkerManager::DynamoDBStreamsListenOnce()
 {
-	const TArray<FAwsString> Streams = GetStreams(
-		FAwsString::FromFString(*DynamoDBTableName));
+	// the timer tries again on the next interval
+	if (!AwsReady) return;
+	const TArray<Aws::String> Streams = GetStreamArns(DynamoDBTableNameAws);
 	if (Streams.Num() > 0)
 	{
-		const FAwsString StreamArn = Streams[0];
-		const TArray<FAwsString> Shards = GetShards(StreamArn);
+		const Aws::String& StreamArn = Streams[0];
+		const TArray<Aws::String> Shards = GetShardIds(StreamArn);
 		if (Shards.Num() > 0)
 		{
-			IterateShard(StreamArn, Shards[0],
-			             Aws::DynamoDBStreams::Model::ShardIteratorType::LATEST, NULL);
+			ReadShard(StreamArn, Shards[0],
+			          Aws::DynamoDBStreams::Model::ShardIteratorType::LATEST, NULL);
 		}
 	}
 }
 
-TArray<FAwsString> UMarkerManager::GetStreams(const FAwsString TableName)
+TArray<Aws::String> UMarkerManager::GetStreamArns(const Aws::String& TableName)
 {
-	UE_LOG(LogMarkerManager, Display, TEXT("Fetching DynamoDB Streams for table: %s"), *TableName.Fstring);
+	WaitForAws();
+	UE_LOG(LogMarkerManager, Display, TEXT("Fetching DynamoDB Streams for table: %s"), UTF8_TO_TCHAR(TableName.c_str()));
 	Aws::DynamoDBStreams::Model::ListStreamsOutcome ListStreamsOutcome = DynamoDBStreamsClient->ListStreams(
-		Aws::DynamoDBStreams::Model::ListStreamsRequest().WithTableName(TableName.AwsString));
+		Aws::DynamoDBStreams::Model::ListStreamsRequest().WithTableName(TableName));
 	
-	TArray<FAwsString> StreamArns;
+	TArray<Aws::String> StreamArns;
 	if (ListStreamsOutcome.IsSuccess())
 	{
-		const Aws::DynamoDBStreams::Model::ListStreamsResult ListStreamsResult = ListStreamsOutcome.GetResultWithOwnership();
-		Aws::Vector<Aws::DynamoDBStreams::Model::Stream> Streams = ListStreamsResult.GetStreams();
-		for (Aws::DynamoDBStreams::Model::Stream Stream : Streams)
+		const Aws::DynamoDBStreams::Model::ListStreamsResult& ListStreamsResult = ListStreamsOutcome.GetResult();
+		const Aws::Vector<Aws::DynamoDBStreams::Model::Stream>& Streams = ListStreamsResult.GetStreams();
+		for (const Aws::DynamoDBStreams::Model::Stream& Stream : Streams)
 		{
-			StreamArns.Add(FAwsString::FromAwsString(Stream.GetStreamArn()));
+			StreamArns.Add(Stream.GetStreamArn());
 		} 
 		LastEvaluatedStreamArn = ListStreamsResult.GetLastEvaluatedStreamArn();
-		UE_LOG(LogMarkerManager, Display, TEXT("Found %d DynamoDB Streams for table %s"), Streams.size(), *TableName.Fstring);
+		UE_LOG(LogMarkerManager, Display, TEXT("Found %d DynamoDB Streams for table %s"), Streams.size(), UTF8_TO_TCHAR(TableName.c_str()));
 	} else
 	{
-		UE_LOG(LogMarkerManager, Warning, TEXT("ListStreams error: %s"), *FString(ListStreamsOutcome.GetError().GetMessage().c_str()));
+		UE_LOG(LogMarkerManager, Warning, TEXT("ListStreams error: %s"), UTF8_TO_TCHAR(ListStreamsOutcome.GetError().GetMessage().c_str()));
 	}
 	return StreamArns;
 }
 
-TArray<FAwsString> UMarkerManager::GetShards(const FAwsString StreamArn) const
+TArray<FAwsString> UMarkerManager::GetStreams(const FAwsString TableName)
+{
+	TArray<FAwsString> StreamArns;
+	for (const Aws::String& StreamArn : GetStreamArns(TableName.AwsString))
+	{
+		StreamArns.Add(FAwsString::FromAwsString(StreamArn));
+	}
+	return StreamArns;
+}
+
+TArray<Aws::String> UMarkerManager::GetShardIds(const Aws::String& StreamArn) const
 {
-	UE_LOG(LogMarkerManager, Display, TEXT("Stream ARN %s"), *StreamArn.Fstring);
+	WaitForAws();
+	UE_LOG(LogMarkerManager, Display, TEXT("Stream ARN %s"), UTF8_TO_TCHAR(StreamArn.c_str()));
 	Aws::DynamoDBStreams::Model::DescribeStreamOutcome DescribeStreamOutcome = DynamoDBStreamsClient->DescribeStream(
-		Aws::DynamoDBStreams::Model::DescribeStreamRequest().WithStreamArn(StreamArn.AwsString));
+		Aws::DynamoDBStreams::Model::DescribeStreamRequest().WithStreamArn(StreamArn));
 
-	TArray<FAwsString> ShardIds;
+	TArray<Aws::String> ShardIds;
 	if (DescribeStreamOutcome.IsSuccess())
 	{
-		const Aws::DynamoDBStreams::Model::DescribeStreamResult DescribeStreamResult = DescribeStreamOutcome.GetResultWithOwnership();
-		Aws::Vector<Aws::DynamoDBStreams::Model::Shard> Shards = DescribeStreamResult.GetStreamDescription().GetShards();
-		for (Aws::DynamoDBStreams::Model::Shard Shard : Shards)
+		const Aws::Vector<Aws::DynamoDBStreams::Model::Shard>& Shards = DescribeStreamOutcome.GetResult().GetStreamDescription().GetShards();
+		for (const Aws::DynamoDBStreams::Model::Shard& Shard : Shards)
 		{
-			ShardIds.Add(FAwsString::FromAwsString(Shard.GetShardId()));
+			ShardIds.Add(Shard.GetShardId());
 		} 
-		UE_LOG(LogMarkerManager, Display, TEXT("Found %d shards for Stream ARN %s"), Shards.size(), *StreamArn.Fstring);
+		UE_LOG(LogMarkerManager, Display, TEXT("Found %d shards for Stream ARN %s"), Shards.size(), UTF8_TO_TCHAR(StreamArn.c_str()));
 	}
 	else
 	{
-		UE_LOG(LogMarkerManager, Warning, TEXT("DescribeStreams error: %s"), *FString(DescribeStreamOutcome.GetError().GetMessage().c_str()));
+		UE_LOG(LogMarkerManager, Warning, TEXT("DescribeStreams error: %s"), UTF8_TO_TCHAR(DescribeStreamOutcome.GetError().GetMessage().c_str()));
+	}
+	return ShardIds;
+}
+
+TArray<FAwsString> UMarkerManager::GetShards(const FAwsString StreamArn) const
+{
+	TArray<FAwsString> ShardIds;
+	for (const Aws::String& ShardId : GetShardIds(StreamArn.AwsString))
+	{
+		ShardIds.Add(FAwsString::FromAwsString(ShardId));
 	}
 	return ShardIds;
 }
 
+FString UMarkerManager::GetShardIterator() const
+{
+	return ShardIterator;
+}
+
+void UMarkerManager::SetShardIterator(const Aws::String& Iterator)
+{
+	ShardIteratorAws = Iterator;
+	ShardIterator = AwsStringToFString(Iterator);
+}
+
 void UMarkerManager::DynamoDBStreamsReplay(FString TableName)
 {
-	TArray<FAwsString> Streams;
-	if (TableName == "") Streams = GetStreams(FAwsString::FromAwsString(DynamoDBTableNameAws));
-	else Streams = GetStreams(FAwsString::FromFString(TableName));
-	for (const auto Stream : Streams)
+	if (FastForwardReplay)
+	{
+		DynamoDBStreamsFastForwardAsync(TableName, FDateTime::UtcNow() - FTimespan::FromHours(24.0));
+		return;
+	}
+	if (!AwsReady)
+	{
+		WhenAwsReady([this, TableName]() { DynamoDBStreamsReplay(TableName); });
+		return;
+	}
+	const TArray<Aws::String> Streams = GetStreamArns(TableName == "" ? DynamoDBTableNameAws : FStringToAwsString(TableName));
+	for (const Aws::String& Stream : Streams)
+	{
+		ScanStreamArn(Stream, FDateTime::UtcNow() - FTimespan::FromHours(24.0));
+	}
+}
+
+void UMarkerManager::DynamoDBStreamsFastForward(const FString TableName)
+{
+	DynamoDBStreamsFastForwardAsync(TableName, FDateTime::UtcNow() - FTimespan::FromHours(24.0));
+}
+
+TFuture<int> UMarkerManager::DynamoDBStreamsFastForwardAsync(const FString& TableName, const FDateTime From)
+{
+	const TSharedRef<TPromise<int>> Promise = MakeShared<TPromise<int>>();
+	TFuture<int> Future = Promise->GetFuture();
+	TWeakObjectPtr<UMarkerManager> WeakThis(this);
+
+	WhenAwsReady([this, Promise, WeakThis, TableName, From]()
+	{
+		if (FastForwardRunning)
+		{
+			UE_LOG(LogMarkerManager, Warning, TEXT("A fast-forward replay is already running"));
+			Promise->SetValue(-1);
+			return;
+		}
+		FastForwardRunning = true;
+
+		// the worker converts locations with the transform of now; ApplyFastForward() catches up if it changes meanwhile
+		TOptional<FMatrix> EcefToUnreal;
+		if (Georeference != nullptr && UseCesiumGeoreference) EcefToUnreal = GetEcefToUnrealTransform();
+		const TSharedRef<FMarkerStreamFastForward> FastForward =
+			MakeShared<FMarkerStreamFastForward>(DynamoDBStreamsClient, StreamDeduplicator, EcefToUnreal);
+		const Aws::String Table = TableName.IsEmpty() ? DynamoDBTableNameAws : FStringToAwsString(TableName);
+		const bool KeepHistory = FastForwardKeepHistory;
+		const int32 MaxEmptyPages = NumberOfEmptyShardsLimit;
+
+		// the run waits on network reads for its whole length, so it gets a thread rather than a pool worker
+		// Shutdown() waits on the counter, so the manager outlives the pointer
+		FThreadSafeCounter* Tasks = &BackgroundAwsTasks;
+		Tasks->Increment();
+		Async(EAsyncExecution::Thread, [Promise, WeakThis, FastForward, Table, From, KeepHistory, MaxEmptyPages, EcefToUnreal, Tasks]()
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			const TSharedRef<TArray<FMarkerRecordBatch>> Batches = MakeShared<TArray<FMarkerRecordBatch>>();
+			const bool Success = FastForward->Run(Table, From, KeepHistory, MaxEmptyPages, *Batches);
+			Tasks->Decrement();
+			UE_LOG(LogMarkerManager, Display, TEXT("Fast-forward read %lld records (%lld duplicates) of %d markers in %.1f s"),
+			       FastForward->GetRecordsRead(), FastForward->GetDuplicateRecordsDropped(), Batches->Num(),
+			       FPlatformTime::Seconds() - StartTime);
+
+			AsyncTask(ENamedThreads::GameThread, [Promise, WeakThis, FastForward, Batches, Success, EcefToUnreal]()
+			{
+				if (!WeakThis.IsValid())
+				{
+					Promise->SetValue(-1);
+					return;
+				}
+				WeakThis->FastForwardRunning = false;
+				if (!Success)
+				{
+					Promise->SetValue(-1);
+					return;
+				}
+				// the manager kept reading while the worker ran, so what each side has seen is merged shard by shard
+				WeakThis->StreamDeduplicator.Merge(FastForward->GetDeduplicator());
+				WeakThis->DuplicateRecordsDropped += FastForward->GetDuplicateRecordsDropped();
+				const int Count = Batches->Num();
+				WeakThis->ApplyFastForward(MoveTemp(*Batches), EcefToUnreal);
+				Promise->SetValue(Count);
+			});
+		});
+	});
+	return Future;
+}
+
+void UMarkerManager::ApplyFastForward(TArray<FMarkerRecordBatch>&& Batches, const TOptional<FMatrix>& EcefToUnreal)
+{
+	if (EcefToUnreal.IsSet() && Georeference != nullptr)
 	{
-		ScanStream(Stream, FDateTime::Now() - FTimespan::FromHours(24.0));
+		const FMatrix Current = GetEcefToUnrealTransform();
+		if (!Current.Equals(EcefToUnreal.GetValue(), 0.0))
+		{
+			ParallelFor(Batches.Num(), [&Batches, &Current](const int32 i)
+			{
+				for (FLocationTs& Location : Batches[i].Locations)
+				{
+					Location.UECoordinate = Current.TransformPosition(Location.EcefCoordinate);
+				}
+			});
+		}
 	}
+	// already reduced and sorted, so past the reorder buffer and into the budgeted apply queue
+	EnqueueMarkerRecordBatches(MoveTemp(Batches));
 }
 
 void UMarkerManager::ScanStream(const FAwsString StreamArn, const FDateTime TReplayStartFrom)
 {
-	const TArray<FAwsString> Shards = GetShards(StreamArn);
-	for (auto Shard : Shards)
+	ScanStreamArn(StreamArn.AwsString, TReplayStartFrom);
+}
+
+void UMarkerManager::ScanStreamArn(const Aws::String& StreamArn, const FDateTime TReplayStartFrom)
+{
+	const TArray<Aws::String> Shards = GetShardIds(StreamArn);
+	for (const Aws::String& Shard : Shards)
 	{
-		UE_LOG(LogMarkerManager, Display, TEXT("Shard %s"), *Shard.Fstring);
-		IterateShard(StreamArn, Shard, Aws::DynamoDBStreams::Model::ShardIteratorType::TRIM_HORIZON, TReplayStartFrom);
+		UE_LOG(LogMarkerManager, Display, TEXT("Shard %s"), UTF8_TO_TCHAR(Shard.c_str()));
+		ReadShard(StreamArn, Shard, Aws::DynamoDBStreams::Model::ShardIteratorType::TRIM_HORIZON, TReplayStartFrom, true);
 	}
 }
 
@@ -160,55 +520,87 @@ void UMarkerManager::IterateShard(
 	const FDynamoDBStreamShardIteratorType ShardIteratorType,
 	const FDateTime TReplayStartFrom)
 {
-	if (ShardIterator == "")
+	ReadShard(StreamArn.AwsString, ShardId.AwsString, ShardIteratorType, TReplayStartFrom);
+}
+
+void UMarkerManager::ReadShard(
+	const Aws::String& StreamArn,
+	const Aws::String& ShardId,
+	const FDynamoDBStreamShardIteratorType ShardIteratorType,
+	const FDateTime TReplayStartFrom,
+	const bool DrainWhenFull)
+{
+	WaitForAws();
+	if (ShardId != ShardIteratorShardId)
+	{
+		// the iterator, and the empty page count, belong to the previous shard, whose records are deduplicated under its ID
+		SetShardIterator(Aws::String());
+		ShardIteratorShardId = ShardId;
+		NumberOfEmptyShards = 0;
+	}
+	if (ShardIteratorAws.empty())
 	{
 		UE_LOG(LogMarkerManager, Display, TEXT("ShardIterator not created. Creating it now."));
 		Aws::DynamoDBStreams::Model::GetShardIteratorOutcome GetShardIteratorOutcome = DynamoDBStreamsClient->GetShardIterator(
 			Aws::DynamoDBStreams::Model::GetShardIteratorRequest()
-			.WithStreamArn(StreamArn.AwsString)
-			.WithShardId(ShardId.AwsString)
+			.WithStreamArn(StreamArn)
+			.WithShardId(ShardId)
 			.WithShardIteratorType(ShardIteratorType.Value));
 		if (GetShardIteratorOutcome.IsSuccess())
 		{
-			ShardIterator = FString(GetShardIteratorOutcome.GetResult().GetShardIterator().c_str());
+			SetShardIterator(GetShardIteratorOutcome.GetResult().GetShardIterator());
+			StreamDeduplicator.GetShard(ShardId).BeginRun();
 		}
 		else
 		{
 			UE_LOG(LogMarkerManager, Warning, TEXT("Error: Could not create ShardIterator"));
 		}
-		return;
+		// a replay reads the shard right away, a listener on its next poll
+		if (!DrainWhenFull || ShardIteratorAws.empty()) return;
 	}
 
 	int ProcessedRecordCount = 0;
 	int ShardPageCount = 0;
 	do
 	{
-		UE_LOG(LogMarkerManager, Display, TEXT("Shard Iterator %s"), *ShardIterator);
+		if (ShouldPauseReads() && DrainWhenFull)
+		{
+			// a replay moves on to the next shard after this one, so it cannot leave the iterator here
+			UE_LOG(LogMarkerManager, Verbose, TEXT("Apply queue full, applying it before the next page"));
+			DrainApplyQueue();
+		}
+		else if (ShouldPauseReads())
+		{
+			// keep the iterator, so the next poll continues from here once the queue has drained
+			UE_LOG(LogMarkerManager, Verbose, TEXT("Apply queue full, pausing shard read"));
+			break;
+		}
+		UE_LOG(LogMarkerManager, Verbose, TEXT("Shard Iterator %s"), *ShardIterator);
 		Aws::DynamoDBStreams::Model::GetRecordsOutcome GetRecordsOutcome = DynamoDBStreamsClient->GetRecords(
-			Aws::DynamoDBStreams::Model::GetRecordsRequest().WithShardIterator(
-				Aws::String(TCHAR_TO_UTF8(*ShardIterator))));
+			Aws::DynamoDBStreams::Model::GetRecordsRequest().WithShardIterator(ShardIteratorAws));
 		if (GetRecordsOutcome.IsSuccess())
 		{
-			Aws::Vector<Aws::DynamoDBStreams::Model::Record> Records = GetRecordsOutcome.GetResult().GetRecords();
-			ProcessDynamoDBStreamRecords(Records, TReplayStartFrom);
+			const Aws::Vector<Aws::DynamoDBStreams::Model::Record>& Records = GetRecordsOutcome.GetResult().GetRecords();
+			ProcessDynamoDBStreamRecords(Records, ShardId, TReplayStartFrom);
 			ProcessedRecordCount += Records.size();
 			ShardPageCount++;
-			ShardIterator = FString(GetRecordsOutcome.GetResult().GetNextShardIterator().c_str());
+			SetShardIterator(GetRecordsOutcome.GetResult().GetNextShardIterator());
 		}
 		else
 		{
 			UE_LOG(LogMarkerManager, Warning, TEXT("GetRecords error: %s"),
-			       *FString(GetRecordsOutcome.GetError().GetMessage().c_str()));
+			       UTF8_TO_TCHAR(GetRecordsOutcome.GetError().GetMessage().c_str()));
 			break;
 		}
 		UE_LOG(LogMarkerManager, Display, TEXT("Processing complete. Processed %d events from %d pages"), ProcessedRecordCount,
 		       ShardPageCount);
 	}
-	while (ShardIterator != "" && NumberOfEmptyShards <= NumberOfEmptyShardsLimit);
+	while (!ShardIteratorAws.empty() && NumberOfEmptyShards <= NumberOfEmptyShardsLimit);
 }
 
 void UMarkerManager::ProcessDynamoDBStreamRecords(
-	const Aws::Vector<Aws::DynamoDBStreams::Model::Record> Records,
+	const Aws::Vector<Aws::DynamoDBStreams::Model::Record>& Records,
+	const Aws::String& ShardId,
 	const FDateTime TReplayStartFrom)
 {
 	UE_LOG(LogMarkerManager, Display, TEXT("Found %d records"), Records.size());
@@ -219,75 +611,33 @@ void UMarkerManager::ProcessDynamoDBStreamRecords(
 	}
 	
 	NumberOfEmptyShards = 0;
-	for (auto Record : Records)
+	FShardSequenceDeduplicator& ShardDeduplicator = StreamDeduplicator.GetShard(ShardId);
+	TArray<FMarkerRecord> DecodedRecords;
+	DecodedRecords.Reserve(Records.size());
+	FRawMarkerRecord RawRecord;
+	for (const Aws::DynamoDBStreams::Model::Record& Record : Records)
 	{
 		if (Record.GetEventName() == Aws::DynamoDBStreams::Model::OperationType::INSERT)
 		{
-			Aws::Utils::Json::JsonValue JsonValue = Record.Jsonize();
-			Aws::Utils::Json::JsonView JsonView = JsonValue.View().GetObject("dynamodb").GetObject("NewImage");
-
-			LastEvaluatedSequenceNumber = JsonValue.View().GetObject("dynamodb").GetString("SequenceNumber");
-			const int CreationDateTime = JsonValue.View().GetObject("dynamodb").GetInteger("ApproximateCreationDateTime");
-			FDateTime CreatedDateTime = FDateTime::FromUnixTimestamp(CreationDateTime);
+			const Aws::DynamoDBStreams::Model::StreamRecord& StreamRecord = Record.GetDynamodb();
+			LastEvaluatedSequenceNumber = StreamRecord.GetSequenceNumber();
+			const FDateTime CreatedDateTime = FDateTime::FromUnixTimestamp(StreamRecord.GetApproximateCreationDateTime().Millis() / 1000);
 
 			if (CreatedDateTime >= TReplayStartFrom)
 			{
-				if (JsonView.ValueExists(PartitionKeyAttributeNameAws) && JsonView.ValueExists(SortKeyAttributeNameAws))
+				// drop events already delivered by an earlier replay or listen pass, before decoding them.
+				// only records in the window count as seen, so a later replay from further back still applies the rest.
+				if (!ShardDeduplicator.Accept(StreamRecord.GetSequenceNumber()))
 				{
-					ELocationMarkerType MarkerType = ELocationMarkerType::Static;;
-					if (JsonView.KeyExists(MarkerTypeAttributeNameAws) && JsonView.ValueExists(MarkerTypeAttributeNameAws))
-					{
-						FString MarkerTypeStr = FString(JsonView.GetObject(MarkerTypeAttributeNameAws).GetString("S").c_str()).ToLower();
-						if (MarkerTypeStr == TemporaryMarkerName.ToLower()) MarkerType = ELocationMarkerType::Temporary;
-						else if (MarkerTypeStr == DynamicMarkerName.ToLower()) MarkerType = ELocationMarkerType::Dynamic;
-					}
+					DuplicateRecordsDropped++;
+					continue;
+				}
 
-					FString DeviceID = FString(JsonView.GetObject(PartitionKeyAttributeNameAws).GetString("S").c_str());
-					FString TimestampStr = FString(JsonView.GetObject(SortKeyAttributeNameAws).GetString("S").c_str());
-					const FDateTime Timestamp = FDateTime::FromUnixTimestamp(FCString::Atoi(*TimestampStr));
-					const double Lon = FCString::Atod(*FString(JsonView.GetObject(PositionXAttributeNameAws).GetString("N").c_str()));
-					const double Lat = FCString::Atod(*FString(JsonView.GetObject(PositionYAttributeNameAws).GetString("N").c_str()));
-					const double Elev = FCString::Atod(*FString(JsonView.GetObject(PositionZAttributeNameAws).GetString("N").c_str()));
-					const FLocationTs LocationTs = WrapLocationTs(Timestamp, Lon, Lat, Elev);
-					
-					ALocationMarker* Marker;
-					if (MarkerType == ELocationMarkerType::Dynamic)
-					{
-						if (SpawnedLocationMarkers.Contains(DeviceID))
-						{
-							// dynamic marker with matching device id already exists
-							Marker = *SpawnedLocationMarkers.Find(DeviceID);
-							if (ADynamicMarker* DynamicMarker = Cast<ADynamicMarker>(Marker))
-							{
-								// pass the new data to the marker
-								DynamicMarker->AddLocationTs(LocationTs);
-								UE_LOG(LogMarkerManager, Display, TEXT("Added new location %s for Dynamic marker %s"),
-									*LocationTs.ToString(),
-									*Marker->ToString());
-							}
-						} else
-						{
-							// spawn marker only if AllMarkers doesn't contain the device ID
-							Marker = SpawnAndInitializeMarker(LocationTs, MarkerType, DeviceID);
-							if (Marker != nullptr)
-							{
-								UE_LOG(LogMarkerManager, Display, TEXT("Created Dynamic Marker: %s"), *Marker->ToString());
-							} else
-							{
-								UE_LOG(LogMarkerManager, Display, TEXT("Failed to create Dynamic Marker: %s"), *DeviceID);
-							}
-						}
-					} else
-					{
-						// for static and temporary marker, spawn only if device ID is new
-						// in other words, static and temp markers are assumed to be locked in position
-						if (!SpawnedLocationMarkers.Contains(DeviceID))
-						{
-							// spawn marker only if AllMarkers doesn't contain the device ID
-							Marker = SpawnAndInitializeMarker(LocationTs, MarkerType, DeviceID);
-							if (Marker != nullptr) UE_LOG(LogMarkerManager, Display, TEXT("Created: %s"), *Marker->ToString());
-						}
-					}
+				// read the attributes from the SDK model in place, rather than through a JSON copy of the record
+				if (FRawMarkerRecord::FromStreamRecord(StreamRecord, RawRecord))
+				{
+					DecodedRecords.Emplace(RawRecord.DeviceID, RawRecord.MarkerType,
+					                       WrapLocationTs(RawRecord.Timestamp, RawRecord.Lon, RawRecord.Lat, RawRecord.Elev));
 				}
 				else
 				{
@@ -297,99 +647,878 @@ void UMarkerManager::ProcessDynamoDBStreamRecords(
 			}
 		}
 	}
+	EnqueueStreamRecordBatches(FMarkerRecordBatch::Coalesce(DecodedRecords));
 }
 
-FLocationTs UMarkerManager::WrapLocationTs(const FDateTime Timestamp, const double Lon, const double Lat, const double Elev) const
+void UMarkerManager::ApplyMarkerRecordBatches(const TArray<FMarkerRecordBatch>& Batches)
 {
-	FVector InGameCoordinate, EcefCoordinate, Wgs84Coordinate = FVector(Lon, Lat, Elev);
-	if (this->Georeference && UseCesiumGeoreference)
+	for (const FMarkerRecordBatch& Batch : Batches)
 	{
-		const glm::dvec3 UECoord = this->Georeference->TransformLongitudeLatitudeHeightToUnreal(glm::dvec3(Lon, Lat, Elev));
-		InGameCoordinate = FVector(UECoord.x, UECoord.y, UECoord.z);
+		ApplyMarkerRecordBatch(Batch);
+	}
+}
 
-		const glm::dvec3 EcEfCoord = this->Georeference->TransformLongitudeLatitudeHeightToEcef(glm::dvec3(Lon, Lat, Elev));
-		EcefCoordinate = FVector(EcEfCoord.x, EcEfCoord.y, EcEfCoord.z);
-		return FLocationTs(Timestamp, InGameCoordinate, Wgs84Coordinate, EcefCoordinate);
-	} else
+void UMarkerManager::ApplyMarkerRecordBatch(const FMarkerRecordBatch& Batch)
+{
+	if (Batch.Locations.Num() == 0) return;
+	if (RecordMarkerHistory) TemporalStore.Add(Batch.DeviceID, Batch.MarkerType, Batch.Locations);
+	OnMarkerBatchApplied.Broadcast(Batch);
+
+	ALocationMarker** Existing = SpawnedLocationMarkers.Find(Batch.DeviceID);
+	if (Batch.MarkerType == ELocationMarkerType::Dynamic)
 	{
-		return FLocationTs(Timestamp, Wgs84Coordinate, FVector::ZeroVector, FVector::ZeroVector);
+		if (Existing != nullptr)
+		{
+			// dynamic marker with matching device id already exists, pass the new data to the marker
+			if (ADynamicMarker* DynamicMarker = Cast<ADynamicMarker>(*Existing))
+			{
+				DynamicMarker->AddLocationTsBatch(Batch.Locations);
+				if (Batch.FastForward) DynamicMarker->SkipToLatestLocation();
+				UE_LOG(LogMarkerManager, Display, TEXT("Added %d new locations for Dynamic marker %s, latest %s"),
+					Batch.Locations.Num(),
+					*Batch.DeviceID,
+					*Batch.Locations.Last().ToString());
+			}
+		}
+		else
+		{
+			// spawn with the oldest location, then hand over the rest in one append.
+			// fast-forwarded markers spawn at the latest one, and the older ones are merged in behind it.
+			const int32 SpawnIndex = Batch.FastForward ? Batch.Locations.Num() - 1 : 0;
+			ALocationMarker* Marker = SpawnAndInitializeMarker(Batch.Locations[SpawnIndex], Batch.MarkerType, Batch.DeviceID);
+			if (ADynamicMarker* DynamicMarker = Cast<ADynamicMarker>(Marker))
+			{
+				if (Batch.Locations.Num() > 1)
+				{
+					DynamicMarker->AddLocationTsBatch(TArray<FLocationTs>(Batch.Locations.GetData() + (SpawnIndex == 0 ? 1 : 0), Batch.Locations.Num() - 1));
+				}
+				if (Batch.FastForward) DynamicMarker->SkipToLatestLocation();
+				UE_LOG(LogMarkerManager, Display, TEXT("Created Dynamic Marker %s with %d locations"), *Batch.DeviceID, Batch.Locations.Num());
+			}
+			else
+			{
+				UE_LOG(LogMarkerManager, Display, TEXT("Failed to create Dynamic Marker: %s"), *Batch.DeviceID);
+			}
+		}
+		ReplicateMarkerUpdate(Batch.DeviceID, Batch.MarkerType, Batch.Locations.Last());
+	}
+	else if (Existing == nullptr)
+	{
+		// for static and temporary marker, spawn only if device ID is new
+		// in other words, static and temp markers are assumed to be locked in position
+		SpawnAndInitializeMarker(Batch.Locations[0], Batch.MarkerType, Batch.DeviceID);
 	}
 }
 
-FLocationTs UMarkerManager::WrapLocationTs(const FDateTime Timestamp, const FVector Coordinate) const
+void UMarkerManager::RemovePendingBatch(const FString& DeviceID)
 {
-	return WrapLocationTs(Timestamp, Coordinate.X, Coordinate.Y, Coordinate.Z);
+	ReorderBuffer.Remove(DeviceID);
+	int32 Index;
+	if (!PendingBatchIndex.RemoveAndCopyValue(DeviceID, Index)) return;
+	PendingLocationCount -= PendingBatches[Index].Locations.Num();
+	PendingBatches.RemoveAtSwap(Index, 1, false);
+	if (Index < PendingBatches.Num())
+	{
+		PendingBatchIndex.Add(PendingBatches[Index].DeviceID, Index);
+		PendingBatchesNeedSort = true;
+	}
 }
 
-auto UMarkerManager::GetLatestRecord(const FString DeviceID, const FDateTime LastKnownTimestamp) -> FVector
+void UMarkerManager::EnqueueMarkerRecordBatches(TArray<FMarkerRecordBatch>&& Batches, const bool Live)
 {
-	Aws::DynamoDB::Model::QueryRequest Request;
-	Request.SetTableName(DynamoDBTableNameAws);
-	Request.SetKeyConditionExpression(PartitionKeyAttributeNameAws + " = :valueToMatch");
-
-	// Set Expression AttributeValues
-	Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue> AttributeValues;
-	Aws::String PartitionKeyVal = Aws::String(TCHAR_TO_UTF8(*DeviceID));
-	AttributeValues.emplace(":valueToMatch", PartitionKeyVal);
-	Request.SetExpressionAttributeValues(AttributeValues);
-	Request.SetScanIndexForward(false);
-	Request.SetLimit(1);
-
-	// Perform Query operation
-	const Aws::DynamoDB::Model::QueryOutcome& Result = DynamoClient->Query(Request);
-	if (Result.IsSuccess())
+	for (FMarkerRecordBatch& Batch : Batches)
 	{
-		// Reference the retrieved items
-		for (const auto& Item : Result.GetResult().GetItems())
+		Batch.Live = Live;
+		PendingLocationCount += Batch.Locations.Num();
+		if (const int32* Index = PendingBatchIndex.Find(Batch.DeviceID))
 		{
-			// get timestamp data
-			Aws::DynamoDB::Model::AttributeValue TimestampValue = Item.at(SortKeyAttributeNameAws);
-			FDateTime Timestamp = FDateTime::FromUnixTimestamp(std::atoi(TimestampValue.GetS().c_str()));
-			UE_LOG(LogMarkerManager, Display, TEXT("Timestamp: %s"), *Timestamp.ToIso8601());
+			FMarkerRecordBatch& Pending = PendingBatches[*Index];
+			Pending.Locations.Append(MoveTemp(Batch.Locations));
+			Pending.Locations.StableSort();
+			Pending.FastForward = Pending.FastForward || Batch.FastForward;
+			// once a read the caller asked for is merged in, the device's update is no longer sheddable
+			Pending.Live = Pending.Live && Batch.Live;
+		}
+		else
+		{
+			PendingBatchIndex.Add(Batch.DeviceID, PendingBatches.Add(MoveTemp(Batch)));
+		}
+	}
+	PendingBatchesNeedSort = true;
+	if (Live && PendingLocationCount > MaxPendingLocations) ShedPendingBatches();
+}
 
-			if (Timestamp > LastKnownTimestamp)
-			{
-				// get location data
-				double lon, lat, elev;
-				FDefaultValueHelper::ParseDouble(FString(Item.at(PositionXAttributeNameAws).GetN().c_str()), lon);
-				FDefaultValueHelper::ParseDouble(FString(Item.at(PositionYAttributeNameAws).GetN().c_str()), lat);
-				FDefaultValueHelper::ParseDouble(FString(Item.at(PositionZAttributeNameAws).GetN().c_str()), elev);
-				return FVector(lon, lat, elev);
-			}
+void UMarkerManager::EnqueueStreamRecordBatches(TArray<FMarkerRecordBatch>&& Batches)
+{
+	ReorderBuffer.SetLateness(ReorderLatenessSeconds);
+	if (ReorderLatenessSeconds <= 0.0f)
+	{
+		if (ReorderBuffer.Num() > 0)
+		{
+			TArray<FMarkerRecordBatch> Held;
+			ReorderBuffer.Flush(Held);
+			EnqueueMarkerRecordBatches(MoveTemp(Held), true);
 		}
+		EnqueueMarkerRecordBatches(MoveTemp(Batches), true);
+		return;
 	}
-	UE_LOG(LogMarkerManager, Warning, TEXT("Failed to query items: %s"), *FString(Result.GetError().GetMessage().c_str()));
-	return FVector::ZeroVector;
+
+	// late locations skip the buffer; the marker history merges them in by timestamp
+	TArray<FMarkerRecordBatch> Late;
+	ReorderBuffer.Add(MoveTemp(Batches), FPlatformTime::Seconds(), Late);
+	if (Late.Num() > 0) EnqueueMarkerRecordBatches(MoveTemp(Late), true);
 }
 
-ALocationMarker* UMarkerManager::SpawnAndInitializeMarker(const FLocationTs LocationTs, const ELocationMarkerType MarkerType, const FString DeviceID)
+void UMarkerManager::SortPendingBatches(const FVector& CameraLocation)
 {
-	if (SpawnedLocationMarkers.Contains(DeviceID))
+	PendingBatches.Sort([&CameraLocation](const FMarkerRecordBatch& A, const FMarkerRecordBatch& B)
 	{
-		UE_LOG(LogMarkerManager, Warning, TEXT("Cannot create marker with ID %s because it already exists"), *DeviceID);
-		return nullptr;
+		return FVector::DistSquared(A.Locations.Last().UECoordinate, CameraLocation) >
+			FVector::DistSquared(B.Locations.Last().UECoordinate, CameraLocation);
+	});
+	PendingBatchIndex.Reset();
+	for (int32 i = 0; i < PendingBatches.Num(); i++)
+	{
+		PendingBatchIndex.Add(PendingBatches[i].DeviceID, i);
 	}
-	if (LocationTs.UECoordinate == FVector::ZeroVector)
+	LastPrioritizedCameraLocation = CameraLocation;
+	PendingBatchesNeedSort = false;
+}
+
+void UMarkerManager::ShedPendingBatches()
+{
+	const int32 Before = PendingLocationCount;
+
+	// one location per device: static and temporary markers only ever use the first, dynamic markers jump to the latest
+	if (KeepLatestLocationUnderLoad)
 	{
-		UE_LOG(LogMarkerManager, Warning, TEXT("Marker with ID %s cannot be created because the location is a zero vector"), *DeviceID);
-		return nullptr;
+		for (FMarkerRecordBatch& Batch : PendingBatches)
+		{
+			const int32 Extra = Batch.Locations.Num() - 1;
+			if (Extra <= 0 || !Batch.Live) continue;
+			if (Batch.MarkerType == ELocationMarkerType::Dynamic) Batch.Locations.RemoveAt(0, Extra, false);
+			else Batch.Locations.RemoveAt(1, Extra, false);
+			PendingLocationCount -= Extra;
+			ShedCounters.LocationsCoalesced += Extra;
+		}
 	}
-	
-	UE_LOG(LogMarkerManager, Display, TEXT("Creating marker with ID %s: %s"), *DeviceID, *LocationTs.ToString());
-	ALocationMarker* Marker;
-	FTransform SpawnLoc = FTransform(LocationTs.UECoordinate);
-	switch (MarkerType)
+
+	bool Removed = false;
+	if (DropTemporaryMarkersUnderLoad && PendingLocationCount > MaxPendingLocations)
 	{
-		case ELocationMarkerType::Dynamic:
-			Marker = GetWorld()->SpawnActorDeferred<ADynamicMarker>(ADynamicMarker::StaticClass(), SpawnLoc);
-			break;
-		case ELocationMarkerType::Temporary:
-			Marker = GetWorld()->SpawnActorDeferred<ATemporaryMarker>(ATemporaryMarker::StaticClass(), SpawnLoc);
-			break;
-		case ELocationMarkerType::Static:
-			Marker = GetWorld()->SpawnActorDeferred<ALocationMarker>(ALocationMarker::StaticClass(), SpawnLoc);
-			break;
-		default:
+		for (int32 i = PendingBatches.Num() - 1; i >= 0 && PendingLocationCount > MaxPendingLocations; i--)
+		{
+			if (PendingBatches[i].MarkerType != ELocationMarkerType::Temporary || !PendingBatches[i].Live) continue;
+			PendingLocationCount -= PendingBatches[i].Locations.Num();
+			PendingBatches.RemoveAt(i, 1, false);
+			ShedCounters.TemporaryBatchesDropped++;
+			Removed = true;
+		}
+	}
+
+	if (PendingLocationCount > MaxPendingLocations)
+	{
+		// the front of the queue is farthest from the camera
+		FVector CameraLocation;
+		if (GetCameraLocation(CameraLocation)) SortPendingBatches(CameraLocation);
+		int32 Dropped = 0;
+		for (int32 i = 0; i < PendingBatches.Num() && PendingLocationCount > MaxPendingLocations; i++)
+		{
+			if (!PendingBatches[i].Live) continue;
+			PendingLocationCount -= PendingBatches[i].Locations.Num();
+			PendingBatches[i].Locations.Reset();
+			Dropped++;
+		}
+		if (Dropped > 0) PendingBatches.RemoveAll([](const FMarkerRecordBatch& Batch) { return Batch.Locations.Num() == 0; });
+		ShedCounters.FarthestBatchesDropped += Dropped;
+		Removed = Removed || Dropped > 0;
+	}
+
+	if (Removed)
+	{
+		PendingBatchIndex.Reset();
+		for (int32 i = 0; i < PendingBatches.Num(); i++)
+		{
+			PendingBatchIndex.Add(PendingBatches[i].DeviceID, i);
+		}
+	}
+	UE_LOG(LogMarkerManager, Warning, TEXT("Apply queue over %d locations, shed %d of %d"),
+	       MaxPendingLocations, Before - PendingLocationCount, Before);
+}
+
+bool UMarkerManager::ShouldPauseReads() const
+{
+	// room for at least one more GetRecords page, which holds up to 1000 records, or for what the limit allows
+	const int PageAllowance = FMath::Clamp(MaxPendingLocations, 0, 1000);
+	return PauseReadsUnderLoad && PendingLocationCount + ReorderBuffer.Num() + PageAllowance > MaxPendingLocations;
+}
+
+void UMarkerManager::DrainApplyQueue()
+{
+	TArray<FMarkerRecordBatch> Held;
+	ReorderBuffer.Flush(Held);
+	if (Held.Num() > 0) EnqueueMarkerRecordBatches(MoveTemp(Held), true);
+	while (PendingBatches.Num() > 0)
+	{
+		const FMarkerRecordBatch Batch = PendingBatches.Pop(false);
+		PendingBatchIndex.Remove(Batch.DeviceID);
+		PendingLocationCount -= Batch.Locations.Num();
+		ApplyMarkerRecordBatch(Batch);
+	}
+}
+
+FMarkerIngestStatus UMarkerManager::GetIngestStatus() const
+{
+	FMarkerIngestStatus Status = ShedCounters;
+	for (const TUniquePtr<FMarkerFeed>& Feed : MarkerFeeds)
+	{
+		Status.FeedQueuedRecords += Feed->GetStatus().QueuedRecords;
+	}
+	Status.PendingBatches = PendingBatches.Num();
+	Status.ReorderHeldLocations = ReorderBuffer.Num();
+	Status.LateLocations = ReorderBuffer.GetLateCount();
+	Status.PendingLocations = PendingLocationCount;
+	Status.MaxPendingLocations = MaxPendingLocations;
+	Status.ReadsPaused = ShouldPauseReads();
+	return Status;
+}
+
+bool UMarkerManager::GetCameraLocation(FVector& OutLocation) const
+{
+	const APlayerController* PlayerController = GetFirstLocalPlayerController();
+	if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr) return false;
+	OutLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	return true;
+}
+
+bool UMarkerManager::TickApplyQueue(const float DeltaTime)
+{
+	LastFrameSeconds = DeltaTime;
+	if (GetWorld() == nullptr) return true;
+	UpdateMarkerSignificance();
+	TickExpiry();
+	TickFullResync();
+	TrimMarkerHistory();
+	DrainMarkerFeeds();
+	if (ReorderBuffer.NumDevices() > 0)
+	{
+		TArray<FMarkerRecordBatch> Released;
+		ReorderBuffer.SetLateness(ReorderLatenessSeconds);
+		ReorderBuffer.Release(FPlatformTime::Seconds(), Released);
+		if (Released.Num() > 0) EnqueueMarkerRecordBatches(MoveTemp(Released), true);
+	}
+	if (PendingBatches.Num() == 0) return true;
+
+	FVector CameraLocation;
+	if (GetCameraLocation(CameraLocation) &&
+		(PendingBatchesNeedSort || FVector::Dist(CameraLocation, LastPrioritizedCameraLocation) > ReprioritizeDistance))
+	{
+		SortPendingBatches(CameraLocation);
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double Budget = FMath::Max<double>(SpawnBudgetMilliseconds / 1000.0, 0.0);
+	int AppliedCount = 0;
+	// at least one batch per frame, so the queue drains even with no budget left
+	while (PendingBatches.Num() > 0 && (AppliedCount == 0 || FPlatformTime::Seconds() - StartTime < Budget))
+	{
+		const FMarkerRecordBatch Batch = PendingBatches.Pop(false);
+		PendingBatchIndex.Remove(Batch.DeviceID);
+		PendingLocationCount -= Batch.Locations.Num();
+		ApplyMarkerRecordBatch(Batch);
+		AppliedCount++;
+	}
+
+	if (AppliedCount > 0)
+	{
+		const double SecondsPerBatch = (FPlatformTime::Seconds() - StartTime) / AppliedCount;
+		AverageBatchApplySeconds = AverageBatchApplySeconds == 0.0
+			                           ? SecondsPerBatch
+			                           : 0.9 * AverageBatchApplySeconds + 0.1 * SecondsPerBatch;
+	}
+	UE_LOG(LogMarkerManager, Verbose, TEXT("Applied %d marker updates, %d pending"), AppliedCount, PendingBatches.Num());
+	return true;
+}
+
+void UMarkerManager::ScheduleMarkerExpiry(ATemporaryMarker* Marker)
+{
+	ExpiryWheel.Schedule(Marker, Marker->ExpiryGeneration, Marker->ExpiryTime);
+}
+
+int UMarkerManager::GetScheduledExpiryCount() const
+{
+	return ExpiryWheel.Num();
+}
+
+void UMarkerManager::TickExpiry()
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (Now < ExpiryWheel.GetTime())
+	{
+		// a new world starts its clock at zero, and the markers of the old one are gone
+		ExpiryWheel.Reset(Now);
+		LastShrinkTime = 0.0;
+	}
+
+	TArray<FExpiryTimingWheel::FEntry> Expired;
+	ExpiryWheel.Advance(Now, Expired);
+	for (const FExpiryTimingWheel::FEntry& Entry : Expired)
+	{
+		ATemporaryMarker* Marker = Entry.Marker.Get();
+		if (Marker == nullptr || Marker->ExpiryGeneration != Entry.Generation || Marker->IsActorBeingDestroyed()) continue;
+		Marker->Destroy();
+	}
+
+	if (!ShrinkTemporaryMarkersInMaterial && Now - LastShrinkTime >= TemporaryMarkerShrinkInterval)
+	{
+		LastShrinkTime = Now;
+		const uint32 Pass = ShrinkPassCount++;
+		ExpiryWheel.ForEach([this, Now, Pass](const FExpiryTimingWheel::FEntry& Entry)
+		{
+			ATemporaryMarker* Marker = Entry.Marker.Get();
+			if (Marker == nullptr || Marker->ExpiryGeneration != Entry.Generation) return;
+			// hidden markers are rescaled when they are revealed, farther tiers on every n-th pass,
+			// offset by the device so each pass rescales a share of them rather than all at once
+			if (Marker->Significance == EMarkerSignificance::Hidden ||
+				(Pass + GetTypeHash(Marker->DeviceID)) % GetSignificanceRateDivisor(Marker->Significance) != 0) return;
+			const float Scale = Marker->GetExpiryScale(Now);
+			Marker->SetActorRelativeScale3D(FVector(Scale, Scale, Scale));
+		});
+	}
+}
+
+int32 UMarkerManager::GetSignificanceRateDivisor(const EMarkerSignificance Significance) const
+{
+	switch (Significance)
+	{
+	case EMarkerSignificance::Mid: return FMath::Max(SignificanceMidRateDivisor, 1);
+	case EMarkerSignificance::Far: return FMath::Max(SignificanceFarRateDivisor, 1);
+	case EMarkerSignificance::Hidden: return FMath::Max(SignificanceHiddenRateDivisor, 1);
+	default: return 1;
+	}
+}
+
+int UMarkerManager::GetMarkerSignificanceCount(const EMarkerSignificance Significance) const
+{
+	return SignificanceCounts[static_cast<int32>(Significance)];
+}
+
+void UMarkerManager::UpdateMarkerSignificance()
+{
+	const UWorld* World = GetWorld();
+	// markers replicated as actors carry their transforms to the clients
+	const bool Enabled = MarkerSignificance && !World->IsNetMode(NM_DedicatedServer) && !World->IsNetMode(NM_ListenServer);
+	if (!Enabled)
+	{
+		if (SignificanceApplied) ResetMarkerSignificance();
+		return;
+	}
+	const double Now = FPlatformTime::Seconds();
+	if (Now - LastSignificanceTime < SignificanceUpdateInterval) return;
+	LastSignificanceTime = Now;
+
+	// without a view, for example in a commandlet, there is nothing to rank against
+	FVector CameraLocation;
+	FMatrix ViewProjection;
+	FIntRect ViewRect;
+	if (!GetCameraLocation(CameraLocation) ||
+		!GetPlayerViewProjection(GetFirstLocalPlayerController(), ViewProjection, ViewRect))
+	{
+		return;
+	}
+	FConvexVolume Frustum;
+	GetViewFrustumBounds(Frustum, ViewProjection, false);
+
+	// horizon culling against a sphere of the polar radius, which lies inside the ellipsoid:
+	// a point is behind the globe if it is past the horizon plane and inside the cone of the horizon
+	bool CullHorizon = false;
+	FVector EarthCenter = FVector::ZeroVector;
+	double HorizonDistanceSquared = 0.0;
+	if (Georeference != nullptr && UseCesiumGeoreference)
+	{
+		const FMatrix EcefToUnreal = GetEcefToUnrealTransform();
+		EarthCenter = EcefToUnreal.TransformPosition(FVector::ZeroVector);
+		const double Radius = 6356752.3142 * EcefToUnreal.GetScaleVector().GetMin();
+		HorizonDistanceSquared = FVector::DistSquared(CameraLocation, EarthCenter) - Radius * Radius;
+		CullHorizon = HorizonDistanceSquared > 0.0;
+	}
+	const FVector CameraFromCenter = CameraLocation - EarthCenter;
+	const double NearSquared = FMath::Square(static_cast<double>(SignificanceNearDistance));
+	const double MidSquared = FMath::Square(static_cast<double>(SignificanceMidDistance));
+	const double HiddenSquared = SignificanceHiddenDistance > 0.0f
+		                             ? FMath::Square(static_cast<double>(SignificanceHiddenDistance))
+		                             : TNumericLimits<double>::Max();
+
+	for (int32& Count : SignificanceCounts) Count = 0;
+	for (const TPair<FString, ALocationMarker*>& Pair : SpawnedLocationMarkers)
+	{
+		ATemporaryMarker* Marker = Cast<ATemporaryMarker>(Pair.Value);
+		if (Marker == nullptr || Marker->IsActorBeingDestroyed()) continue;
+		const ADynamicMarker* DynamicMarker = Cast<ADynamicMarker>(Marker);
+		// hidden dynamic markers have not moved the actor, so rank them where they logically are
+		const FVector Location = DynamicMarker != nullptr ? DynamicMarker->CurrentLocation : Marker->GetActorLocation();
+		const FVector ToMarker = Location - CameraLocation;
+		const double DistanceSquared = ToMarker.SizeSquared();
+
+		const double Along = -FVector::DotProduct(ToMarker, CameraFromCenter);
+		const bool BehindGlobe = CullHorizon && Along > HorizonDistanceSquared &&
+			Along * Along > HorizonDistanceSquared * DistanceSquared;
+
+		EMarkerSignificance Significance;
+		if (Marker->Selected) Significance = EMarkerSignificance::Near;
+		else if (DistanceSquared > HiddenSquared || BehindGlobe ||
+			!Frustum.IntersectSphere(Location, Marker->DefaultRadius * Marker->MaxScale + SignificanceFrustumMargin))
+		{
+			Significance = EMarkerSignificance::Hidden;
+		}
+		else if (DistanceSquared <= NearSquared) Significance = EMarkerSignificance::Near;
+		else if (DistanceSquared <= MidSquared) Significance = EMarkerSignificance::Mid;
+		else Significance = EMarkerSignificance::Far;
+		SignificanceCounts[static_cast<int32>(Significance)]++;
+
+		if (Significance == Marker->Significance) continue;
+		const bool Revealed = Marker->Significance == EMarkerSignificance::Hidden;
+		Marker->SetSignificance(Significance, GetSignificanceRateDivisor(Significance));
+		// the shrink pass skipped it while hidden
+		if (Revealed && !ShrinkTemporaryMarkersInMaterial && Marker->ExpiryTime != 0.0f)
+		{
+			const float Scale = Marker->GetExpiryScale(World->GetTimeSeconds());
+			Marker->SetActorRelativeScale3D(FVector(Scale, Scale, Scale));
+		}
+	}
+	SignificanceApplied = true;
+	UE_LOG(LogMarkerManager, VeryVerbose, TEXT("Marker significance: %d near, %d mid, %d far, %d hidden"),
+	       SignificanceCounts[0], SignificanceCounts[1], SignificanceCounts[2], SignificanceCounts[3]);
+}
+
+void UMarkerManager::ResetMarkerSignificance()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	for (const TPair<FString, ALocationMarker*>& Pair : SpawnedLocationMarkers)
+	{
+		ATemporaryMarker* Marker = Cast<ATemporaryMarker>(Pair.Value);
+		if (Marker == nullptr || Marker->Significance == EMarkerSignificance::Near) continue;
+		const bool Revealed = Marker->Significance == EMarkerSignificance::Hidden;
+		Marker->SetSignificance(EMarkerSignificance::Near, 1);
+		if (Revealed && !ShrinkTemporaryMarkersInMaterial && Marker->ExpiryTime != 0.0f)
+		{
+			const float Scale = Marker->GetExpiryScale(Now);
+			Marker->SetActorRelativeScale3D(FVector(Scale, Scale, Scale));
+		}
+	}
+	for (int32& Count : SignificanceCounts) Count = 0;
+	SignificanceApplied = false;
+}
+
+void UMarkerManager::TrimMarkerHistory()
+{
+	const double Now = FPlatformTime::Seconds();
+	if (MarkerHistoryRetentionHours <= 0.0f || Now - LastHistoryTrimTime < 60.0) return;
+	LastHistoryTrimTime = Now;
+
+	FDateTime Earliest, Latest;
+	if (!TemporalStore.GetTimeRange(Earliest, Latest)) return;
+	// relative to the newest record rather than the clock, so replayed history is kept
+	const FDateTime Cutoff = Latest - FTimespan::FromHours(MarkerHistoryRetentionHours);
+	if (Earliest >= Cutoff) return;
+	const int64 RecordCount = TemporalStore.GetRecordCount();
+	TemporalStore.TrimBefore(Cutoff);
+	UE_LOG(LogMarkerManager, Verbose, TEXT("Trimmed %lld history records older than %s"),
+		RecordCount - TemporalStore.GetRecordCount(), *Cutoff.ToIso8601());
+	UE_LOG(LogMarkerManager, Verbose, TEXT("History of %lld records takes %.1f MB, %.1f MB uncompressed"),
+		TemporalStore.GetRecordCount(), TemporalStore.GetAllocatedSize() / 1048576.0, TemporalStore.GetUncompressedSize() / 1048576.0);
+}
+
+TArray<FMarkerState> UMarkerManager::GetMarkerStatesAt(const FDateTime Time, const bool Interpolate, const float MaxAgeSeconds) const
+{
+	TArray<FMarkerState> States;
+	TemporalStore.GetStatesAt(Time, Interpolate, MaxAgeSeconds, States);
+	return States;
+}
+
+TArray<FMarkerState> UMarkerManager::GetMarkerRecordsBetween(const FDateTime From, const FDateTime To) const
+{
+	TArray<FMarkerState> Records;
+	TemporalStore.GetRecordsBetween(From, To, Records);
+	return Records;
+}
+
+bool UMarkerManager::GetMarkerHistoryRange(FDateTime& Earliest, FDateTime& Latest) const
+{
+	return TemporalStore.GetTimeRange(Earliest, Latest);
+}
+
+void UMarkerManager::GetMarkerHistoryMemory(int64& Bytes, int64& UncompressedBytes) const
+{
+	Bytes = TemporalStore.GetAllocatedSize();
+	UncompressedBytes = TemporalStore.GetUncompressedSize();
+}
+
+void UMarkerManager::StartMarkerFeeds()
+{
+	// feeds create their own clients, which needs the SDK
+	if (!AwsReady)
+	{
+		WhenAwsReady([this]() { StartMarkerFeeds(); });
+		return;
+	}
+	StopMarkerFeeds();
+
+	TArray<FMarkerFeedConfig> Configs = MarkerFeedConfigs;
+	if (Configs.Num() == 0)
+	{
+		FMarkerFeedConfig Default;
+		Default.Name = TEXT("Default");
+		Default.TableName = AwsStringToFString(DynamoDBTableNameAws);
+		Default.PollingInterval = PollingInterval;
+		Configs.Add(Default);
+	}
+
+	const Aws::Auth::AWSCredentials Credentials = Aws::Auth::AWSCredentials(AWSAccessKeyId, AWSSecretKey);
+	for (const FMarkerFeedConfig& Config : Configs)
+	{
+		TUniquePtr<FMarkerFeed>& Feed = MarkerFeeds.Add_GetRef(MakeUnique<FMarkerFeed>(Config, Credentials));
+		Feed->Start();
+	}
+	UE_LOG(LogMarkerManager, Display, TEXT("Started %d marker feeds"), MarkerFeeds.Num());
+}
+
+void UMarkerManager::StopMarkerFeeds()
+{
+	for (const TUniquePtr<FMarkerFeed>& Feed : MarkerFeeds)
+	{
+		Feed->Stop();
+	}
+	for (const TUniquePtr<FMarkerFeed>& Feed : MarkerFeeds)
+	{
+		Feed->Shutdown();
+	}
+	MarkerFeeds.Reset();
+}
+
+TArray<FMarkerFeedStatus> UMarkerManager::GetMarkerFeedStatus() const
+{
+	TArray<FMarkerFeedStatus> Status;
+	for (const TUniquePtr<FMarkerFeed>& Feed : MarkerFeeds)
+	{
+		Status.Add(Feed->GetStatus());
+	}
+	return Status;
+}
+
+void UMarkerManager::DrainMarkerFeeds()
+{
+	if (MarkerFeeds.Num() == 0) return;
+
+	// records left on the feeds fill their queues, which pauses their shard reads in turn
+	int32 MaxRecords = MaxFeedRecordsPerFrame;
+	if (PauseReadsUnderLoad) MaxRecords = FMath::Min(MaxRecords, MaxPendingLocations - PendingLocationCount - ReorderBuffer.Num());
+	if (MaxRecords <= 0) return;
+
+	TArray<FMarkerRecord> Records;
+	FRawMarkerRecord RawRecord;
+	const int32 MaxRecordsPerFeed = FMath::Max(MaxRecords / MarkerFeeds.Num(), 1);
+	for (const TUniquePtr<FMarkerFeed>& Feed : MarkerFeeds)
+	{
+		for (int32 i = 0; i < MaxRecordsPerFeed && Feed->Dequeue(RawRecord); i++)
+		{
+			Records.Emplace(RawRecord.DeviceID, RawRecord.MarkerType,
+			                WrapLocationTs(RawRecord.Timestamp, RawRecord.Lon, RawRecord.Lat, RawRecord.Elev));
+		}
+	}
+	if (Records.Num() > 0) EnqueueStreamRecordBatches(FMarkerRecordBatch::Coalesce(Records));
+}
+
+void UMarkerManager::StartServerReplication()
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr || World->GetNetMode() == NM_Client || World->GetNetMode() == NM_Standalone)
+	{
+		UE_LOG(LogMarkerManager, Warning, TEXT("Server replication can only be started on a dedicated or listen server"));
+		return;
+	}
+	if (ReplicationServer) return;
+	ReplicationServer = true;
+	ServerAuthoritativeReplication = true;
+
+	// markers spawned before replication started
+	InterestGrid.Reset(InterestCellSize);
+	for (const TPair<FString, ALocationMarker*>& Pair : SpawnedLocationMarkers)
+	{
+		if (Pair.Value == nullptr) continue;
+		FLocationTs Latest = Pair.Value->LocationTs;
+		if (ADynamicMarker* DynamicMarker = Cast<ADynamicMarker>(Pair.Value))
+		{
+			DynamicMarker->ReplicateAsActor = false;
+			DynamicMarker->SetReplicates(false);
+			if (DynamicMarker->HistoryArr.Num() > 0) Latest = DynamicMarker->HistoryArr.Last();
+		}
+		InterestGrid.Upsert(Pair.Key, Pair.Value->MarkerType, Latest);
+	}
+
+	PostLoginHandle = FGameModeEvents::GameModePostLoginEvent.AddUObject(this, &UMarkerManager::OnPostLogin);
+	LogoutHandle = FGameModeEvents::GameModeLogoutEvent.AddUObject(this, &UMarkerManager::OnLogout);
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		SpawnMarkerReplicator(It->Get());
+	}
+	UE_LOG(LogMarkerManager, Display, TEXT("Replicating %d markers to clients"), InterestGrid.GetDeviceCount());
+}
+
+void UMarkerManager::StopServerReplication()
+{
+	if (!ReplicationServer) return;
+	FGameModeEvents::GameModePostLoginEvent.Remove(PostLoginHandle);
+	FGameModeEvents::GameModeLogoutEvent.Remove(LogoutHandle);
+	for (const TWeakObjectPtr<AMarkerReplicator>& Replicator : TArray<TWeakObjectPtr<AMarkerReplicator>>(MarkerReplicators))
+	{
+		if (Replicator.IsValid()) Replicator->Destroy();
+	}
+	MarkerReplicators.Reset();
+	InterestGrid.Reset(InterestCellSize);
+	ReplicationServer = false;
+	ServerAuthoritativeReplication = false;
+}
+
+void UMarkerManager::SpawnMarkerReplicator(APlayerController* PlayerController)
+{
+	// the host of a listen server sees the server's own markers
+	if (PlayerController == nullptr || PlayerController->IsLocalController()) return;
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.Owner = PlayerController;
+	// AMarkerReplicator::BeginPlay() registers itself
+	GetWorld()->SpawnActor<AMarkerReplicator>(SpawnParameters);
+}
+
+void UMarkerManager::OnPostLogin(AGameModeBase* GameMode, APlayerController* PlayerController)
+{
+	if (GameMode == nullptr || GameMode->GetWorld() != GetWorld()) return;
+	SpawnMarkerReplicator(PlayerController);
+}
+
+void UMarkerManager::OnLogout(AGameModeBase* GameMode, AController* Controller)
+{
+	for (const TWeakObjectPtr<AMarkerReplicator>& Replicator : TArray<TWeakObjectPtr<AMarkerReplicator>>(MarkerReplicators))
+	{
+		if (Replicator.IsValid() && Replicator->GetOwner() == Controller) Replicator->Destroy();
+	}
+}
+
+void UMarkerManager::RegisterMarkerReplicator(AMarkerReplicator* Replicator)
+{
+	MarkerReplicators.AddUnique(Replicator);
+	if (!Replicator->HasAuthority())
+	{
+		ServerAuthoritativeReplication = true;
+		UE_LOG(LogMarkerManager, Display, TEXT("Receiving markers from the server"));
+	}
+}
+
+void UMarkerManager::UnregisterMarkerReplicator(AMarkerReplicator* Replicator)
+{
+	MarkerReplicators.Remove(Replicator);
+	if (Replicator->HasAuthority()) return;
+	ServerAuthoritativeReplication = false;
+
+	// the client's markers all came from the replicator
+	TArray<ALocationMarker*> Markers;
+	SpawnedLocationMarkers.GenerateValueArray(Markers);
+	for (ALocationMarker* Marker : Markers)
+	{
+		if (Marker == nullptr) continue;
+		Marker->DeleteFromDBOnDestroy = false;
+		Marker->Destroy();
+	}
+}
+
+TArray<FReplicatedMarkerCluster> UMarkerManager::GetReplicatedClusters() const
+{
+	for (const TWeakObjectPtr<AMarkerReplicator>& Replicator : MarkerReplicators)
+	{
+		if (Replicator.IsValid() && !Replicator->HasAuthority()) return Replicator->GetClusters();
+	}
+	return TArray<FReplicatedMarkerCluster>();
+}
+
+void UMarkerManager::ReplicateMarkerUpdate(const FString& DeviceID, const ELocationMarkerType MarkerType, const FLocationTs& LocationTs)
+{
+	if (!ReplicationServer || !SpawnedLocationMarkers.Contains(DeviceID)) return;
+	InterestGrid.Upsert(DeviceID, MarkerType, LocationTs);
+}
+
+void UMarkerManager::ApplyReplicatedMarker(const FString& DeviceID, const ELocationMarkerType MarkerType, const FLocationTs& LocationTs)
+{
+	ALocationMarker** Existing = SpawnedLocationMarkers.Find(DeviceID);
+	if (Existing == nullptr)
+	{
+		// replicated markers belong to the server, so destroying the local copy never touches DynamoDB
+		if (ALocationMarker* Marker = SpawnAndInitializeMarker(LocationTs, MarkerType, DeviceID))
+		{
+			Marker->DeleteFromDBOnDestroy = false;
+		}
+		return;
+	}
+	if (ADynamicMarker* DynamicMarker = Cast<ADynamicMarker>(*Existing))
+	{
+		DynamicMarker->AddLocationTs(LocationTs);
+	}
+}
+
+void UMarkerManager::RemoveReplicatedMarker(const FString& DeviceID)
+{
+	ALocationMarker** Existing = SpawnedLocationMarkers.Find(DeviceID);
+	if (Existing == nullptr || *Existing == nullptr) return;
+	(*Existing)->DeleteFromDBOnDestroy = false;
+	(*Existing)->Destroy();
+}
+
+int UMarkerManager::GetPendingMarkerUpdateCount() const
+{
+	return PendingBatches.Num();
+}
+
+int UMarkerManager::GetSpawnedMarkerCount() const
+{
+	return SpawnedLocationMarkers.Num();
+}
+
+float UMarkerManager::GetEstimatedDrainSeconds() const
+{
+	if (PendingBatches.Num() == 0) return 0.0f;
+	const double Budget = FMath::Max<double>(SpawnBudgetMilliseconds / 1000.0, SMALL_NUMBER);
+	const double BatchesPerFrame = FMath::Max<double>(Budget / FMath::Max<double>(AverageBatchApplySeconds, SMALL_NUMBER), 1.0);
+	return FMath::CeilToDouble(PendingBatches.Num() / BatchesPerFrame) * LastFrameSeconds;
+}
+
+FLocationTs UMarkerManager::WrapLocationTs(const FDateTime Timestamp, const double Lon, const double Lat, const double Elev) const
+{
+	FVector InGameCoordinate, EcefCoordinate, Wgs84Coordinate = FVector(Lon, Lat, Elev);
+	if (this->Georeference && UseCesiumGeoreference)
+	{
+		const glm::dvec3 UECoord = this->Georeference->TransformLongitudeLatitudeHeightToUnreal(glm::dvec3(Lon, Lat, Elev));
+		InGameCoordinate = FVector(UECoord.x, UECoord.y, UECoord.z);
+
+		const glm::dvec3 EcEfCoord = this->Georeference->TransformLongitudeLatitudeHeightToEcef(glm::dvec3(Lon, Lat, Elev));
+		EcefCoordinate = FVector(EcEfCoord.x, EcEfCoord.y, EcEfCoord.z);
+		return FLocationTs(Timestamp, InGameCoordinate, Wgs84Coordinate, EcefCoordinate);
+	} else
+	{
+		return FLocationTs(Timestamp, Wgs84Coordinate, FVector::ZeroVector, FVector::ZeroVector);
+	}
+}
+
+FLocationTs UMarkerManager::WrapLocationTs(const FDateTime Timestamp, const FVector Coordinate) const
+{
+	return WrapLocationTs(Timestamp, Coordinate.X, Coordinate.Y, Coordinate.Z);
+}
+
+FLocationTs UMarkerManager::WrapUnrealLocationTs(const FDateTime Timestamp, const FVector& UECoordinate) const
+{
+	if (this->Georeference && UseCesiumGeoreference)
+	{
+		const glm::dvec3 Wgs84Coord = this->Georeference->TransformUnrealToLongitudeLatitudeHeight(
+			glm::dvec3(UECoordinate.X, UECoordinate.Y, UECoordinate.Z));
+		return WrapLocationTs(Timestamp, Wgs84Coord.x, Wgs84Coord.y, Wgs84Coord.z);
+	}
+	// without a georeference, WrapLocationTs() keeps the input as the UE coordinate
+	return FLocationTs(Timestamp, UECoordinate, FVector::ZeroVector, FVector::ZeroVector);
+}
+
+Aws::DynamoDB::Model::QueryRequest UMarkerManager::MakeLatestRecordRequest(const FString& DeviceID)
+{
+	Aws::DynamoDB::Model::QueryRequest Request;
+	Request.SetTableName(DynamoDBTableNameAws);
+	Request.SetKeyConditionExpression(PartitionKeyAttributeNameAws + " = :valueToMatch");
+
+	// Set Expression AttributeValues
+	Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue> AttributeValues;
+	AttributeValues.emplace(":valueToMatch", FStringToAwsString(DeviceID));
+	Request.SetExpressionAttributeValues(AttributeValues);
+	Request.SetScanIndexForward(false);
+	Request.SetLimit(1);
+	return Request;
+}
+
+FVector UMarkerManager::DecodeLatestRecord(const Aws::DynamoDB::Model::QueryOutcome& Result, const FDateTime LastKnownTimestamp)
+{
+	if (Result.IsSuccess())
+	{
+		// Reference the retrieved items
+		for (const auto& Item : Result.GetResult().GetItems())
+		{
+			// get timestamp data
+			const FDateTime Timestamp = FDateTime::FromUnixTimestamp(AwsStringToInt64(Item.at(SortKeyAttributeNameAws).GetS()));
+			UE_LOG(LogMarkerManager, Display, TEXT("Timestamp: %s"), *Timestamp.ToIso8601());
+
+			if (Timestamp > LastKnownTimestamp)
+			{
+				// get location data
+				return FVector(AwsStringToDouble(Item.at(PositionXAttributeNameAws).GetN()),
+				               AwsStringToDouble(Item.at(PositionYAttributeNameAws).GetN()),
+				               AwsStringToDouble(Item.at(PositionZAttributeNameAws).GetN()));
+			}
+		}
+	}
+	UE_LOG(LogMarkerManager, Warning, TEXT("Failed to query items: %s"), *FString(Result.GetError().GetMessage().c_str()));
+	return FVector::ZeroVector;
+}
+
+FVector UMarkerManager::GetLatestRecord(const FString DeviceID, const FDateTime LastKnownTimestamp)
+{
+	WaitForAws();
+	// Perform Query operation
+	const Aws::DynamoDB::Model::QueryOutcome& Result = DynamoClient->Query(MakeLatestRecordRequest(DeviceID));
+	return DecodeLatestRecord(Result, LastKnownTimestamp);
+}
+
+TFuture<FVector> UMarkerManager::GetLatestRecordAsync(const FString DeviceID, const FDateTime LastKnownTimestamp) const
+{
+	const TSharedRef<TPromise<FVector>> Promise = MakeShared<TPromise<FVector>>();
+	TFuture<FVector> Future = Promise->GetFuture();
+	WhenAwsReady([this, Promise, Request = MakeLatestRecordRequest(DeviceID), LastKnownTimestamp]()
+	{
+		DynamoClient->QueryAsync(
+			Request,
+			[Promise, LastKnownTimestamp](const Aws::DynamoDB::DynamoDBClient*,
+			                              const Aws::DynamoDB::Model::QueryRequest&,
+			                              const Aws::DynamoDB::Model::QueryOutcome& Outcome,
+			                              const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+			{
+				const FVector Location = DecodeLatestRecord(Outcome, LastKnownTimestamp);
+				AsyncTask(ENamedThreads::GameThread, [Promise, Location]() { Promise->SetValue(Location); });
+			});
+	});
+	return Future;
+}
+
+ALocationMarker* UMarkerManager::SpawnAndInitializeMarker(const FLocationTs LocationTs, const ELocationMarkerType MarkerType, const FString DeviceID)
+{
+	if (SpawnedLocationMarkers.Contains(DeviceID))
+	{
+		UE_LOG(LogMarkerManager, Warning, TEXT("Cannot create marker with ID %s because it already exists"), *DeviceID);
+		return nullptr;
+	}
+	if (LocationTs.UECoordinate == FVector::ZeroVector)
+	{
+		UE_LOG(LogMarkerManager, Warning, TEXT("Marker with ID %s cannot be created because the location is a zero vector"), *DeviceID);
+		return nullptr;
+	}
+	
+	UE_LOG(LogMarkerManager, Display, TEXT("Creating marker with ID %s: %s"), *DeviceID, *LocationTs.ToString());
+	ALocationMarker* Marker;
+	FTransform SpawnLoc = FTransform(LocationTs.UECoordinate);
+	switch (MarkerType)
+	{
+		case ELocationMarkerType::Dynamic:
+			Marker = GetWorld()->SpawnActorDeferred<ADynamicMarker>(ADynamicMarker::StaticClass(), SpawnLoc);
+			break;
+		case ELocationMarkerType::Temporary:
+			Marker = GetWorld()->SpawnActorDeferred<ATemporaryMarker>(ATemporaryMarker::StaticClass(), SpawnLoc);
+			break;
+		case ELocationMarkerType::Static:
+			Marker = GetWorld()->SpawnActorDeferred<ALocationMarker>(ALocationMarker::StaticClass(), SpawnLoc);
+			break;
+		default:
 			UE_LOG(LogMarkerManager, Warning, TEXT("Error: Could not spawn marker: %s - %s"), *DeviceID, *LocationTs.ToString());
 			return nullptr;
 	}
@@ -397,40 +1526,91 @@ ALocationMarker* UMarkerManager::SpawnAndInitializeMarker(const FLocationTs Loca
 	/* Bind the Marker's BeginDestroy with deletion from database. Do this only for static location markers. */
 	Marker->MarkerOnDelete.BindUFunction(this, "DestroyMarker");
 	Marker->InitializeParams(DeviceID, LocationTs);
+	if (ADynamicMarker* DynamicMarker = Cast<ADynamicMarker>(Marker))
+	{
+		DynamicMarker->ReplicateAsActor = !ServerAuthoritativeReplication;
+	}
+	if (CollisionFreePicking)
+	{
+		// before FinishSpawning(), so no physics bodies are created at all
+		Marker->StaticMeshComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		if (Marker->SphereComp != nullptr) Marker->SphereComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	}
 	Marker->FinishSpawning(SpawnLoc);
 	if (ADynamicMarker* DynamicMarker = Cast<ADynamicMarker>(Marker))
 	{
 		DynamicMarker->AddLocationTs(LocationTs);
 	}
 	SpawnedLocationMarkers.Add(DeviceID, Marker);
+	if (BatchedReanchoring && Georeference != nullptr && UseCesiumGeoreference)
+	{
+		// the manager re-anchors the marker, see ReanchorMarkers()
+		if (Marker->CesiumGlobeAnchor != nullptr)
+		{
+			Marker->CesiumGlobeAnchor->DestroyComponent();
+			Marker->CesiumGlobeAnchor = nullptr;
+		}
+		if (MarkerType != ELocationMarkerType::Dynamic) MarkerAnchors.Add(DeviceID, Marker, LocationTs.EcefCoordinate);
+	}
+	if (CollisionFreePicking)
+	{
+		if (PickingGrid.Num() == 0) PickingGrid.Reset(PickingCellSize);
+		PickingGrid.Update(DeviceID, Marker, Marker->GetActorLocation(), Marker->DefaultRadius * Marker->GetActorScale3D().GetMax());
+		if (MarkerType == ELocationMarkerType::Dynamic) PickableDynamicMarkers.Add(DeviceID);
+	}
+	ReplicateMarkerUpdate(DeviceID, MarkerType, LocationTs);
 	UE_LOG(LogMarkerManager, Display, TEXT("Created %s"), *Marker->ToString());
 	return Marker;
 }
 
-bool UMarkerManager::CreateMarkerInDB(const ALocationMarker* Marker) const
+Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue> UMarkerManager::MakeMarkerItem(const FString& DeviceID, const FLocationTs& LocationTs)
 {
-	Aws::DynamoDB::Model::PutItemRequest Request;
-	Request.SetTableName(DynamoDBTableNameAws);
+	Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue> Item;
 
 	Aws::DynamoDB::Model::AttributeValue PartitionKeyValue;
-	PartitionKeyValue.SetS(Aws::String(TCHAR_TO_UTF8(*Marker->DeviceID)));
-	Request.AddItem(PartitionKeyAttributeNameAws, PartitionKeyValue);
+	PartitionKeyValue.SetS(FStringToAwsString(DeviceID));
+	Item.emplace(PartitionKeyAttributeNameAws, PartitionKeyValue);
 
 	Aws::DynamoDB::Model::AttributeValue SortKeyValue;
-	SortKeyValue.SetS(Aws::String(TCHAR_TO_UTF8(*FString::FromInt(Marker->LocationTs.Timestamp.ToUnixTimestamp()))));
-	Request.AddItem(SortKeyAttributeNameAws, SortKeyValue);
+	const int64 UnixTimestamp = LocationTs.Timestamp.ToUnixTimestamp();
+	SortKeyValue.SetS(AwsStringFromInt64(UnixTimestamp));
+	Item.emplace(SortKeyAttributeNameAws, SortKeyValue);
 
+	// coordinates are numbers, which is what every decoder reads with GetN()
 	Aws::DynamoDB::Model::AttributeValue Lon, Lat, Elev;
-	Lon.SetS(Aws::String(TCHAR_TO_UTF8(*FString::SanitizeFloat(Marker->LocationTs.Wgs84Coordinate.X))));
-	Request.AddItem(PositionXAttributeNameAws, Lon);
+	Lon.SetN(AwsStringFromDouble(LocationTs.Wgs84Coordinate.X));
+	Item.emplace(PositionXAttributeNameAws, Lon);
 
-	Lat.SetS(Aws::String(TCHAR_TO_UTF8(*FString::SanitizeFloat(Marker->LocationTs.Wgs84Coordinate.Y))));
-	Request.AddItem(PositionYAttributeNameAws, Lat);
+	Lat.SetN(AwsStringFromDouble(LocationTs.Wgs84Coordinate.Y));
+	Item.emplace(PositionYAttributeNameAws, Lat);
 
-	Elev.SetS(Aws::String(TCHAR_TO_UTF8(*FString::SanitizeFloat(Marker->LocationTs.Wgs84Coordinate.Z))));
-	Request.AddItem(PositionZAttributeNameAws, Elev);
+	Elev.SetN(AwsStringFromDouble(LocationTs.Wgs84Coordinate.Z));
+	Item.emplace(PositionZAttributeNameAws, Elev);
 
-	const Aws::DynamoDB::Model::PutItemOutcome Outcome = DynamoClient->PutItem(Request);
+	// time bucket for the time index used by SyncMarkersSince()
+	Aws::DynamoDB::Model::AttributeValue TimeBucket;
+	TimeBucket.SetS(AwsStringFromInt64(FMarkerQuery::GetTimeBucket(UnixTimestamp)));
+	Item.emplace(TimeBucketAttributeNameAws, TimeBucket);
+
+	// geohash tile for the tile index used by region streaming
+	Aws::DynamoDB::Model::AttributeValue Tile;
+	Tile.SetS(FStringToAwsString(FGeohash::Encode(LocationTs.Wgs84Coordinate.Y, LocationTs.Wgs84Coordinate.X, TileGeohashPrecision)));
+	Item.emplace(TileAttributeNameAws, Tile);
+	return Item;
+}
+
+Aws::DynamoDB::Model::PutItemRequest UMarkerManager::MakePutItemRequest(const ALocationMarker* Marker)
+{
+	Aws::DynamoDB::Model::PutItemRequest Request;
+	Request.SetTableName(DynamoDBTableNameAws);
+	Request.SetItem(MakeMarkerItem(Marker->DeviceID, Marker->LocationTs));
+	return Request;
+}
+
+bool UMarkerManager::CreateMarkerInDB(const ALocationMarker* Marker) const
+{
+	WaitForAws();
+	const Aws::DynamoDB::Model::PutItemOutcome Outcome = DynamoClient->PutItem(MakePutItemRequest(Marker));
 
 	if (Outcome.IsSuccess())
 	{
@@ -443,82 +1623,547 @@ bool UMarkerManager::CreateMarkerInDB(const ALocationMarker* Marker) const
 	return Outcome.IsSuccess();
 }
 
+TFuture<bool> UMarkerManager::CreateMarkerInDBAsync(const ALocationMarker* Marker) const
+{
+	const TSharedRef<TPromise<bool>> Promise = MakeShared<TPromise<bool>>();
+	TFuture<bool> Future = Promise->GetFuture();
+	// the request is built now, since the marker may be gone by the time AWS is ready
+	WhenAwsReady([this, Promise, Request = MakePutItemRequest(Marker)]()
+	{
+		DynamoClient->PutItemAsync(
+			Request,
+			[Promise](const Aws::DynamoDB::DynamoDBClient*,
+			          const Aws::DynamoDB::Model::PutItemRequest&,
+			          const Aws::DynamoDB::Model::PutItemOutcome& Outcome,
+			          const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+			{
+				const bool Success = Outcome.IsSuccess();
+				if (!Success) UE_LOG(LogMarkerManager, Warning, TEXT("Put item Fail: %s"), *FString(Outcome.GetError().GetMessage().c_str()));
+				AsyncTask(ENamedThreads::GameThread, [Promise, Success]() { Promise->SetValue(Success); });
+			});
+	});
+	return Future;
+}
+
+TArray<FMarkerRecord> UMarkerManager::DecodeItems(
+	const Aws::Vector<Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue>>& Items) const
+{
+	TArray<FMarkerRecord> Records;
+	Records.Reserve(Items.size());
+
+	for (const auto& Pairs : Items)
+	{
+		// type
+		const auto MarkerTypeValue = Pairs.find(MarkerTypeAttributeNameAws);
+		const ELocationMarkerType MarkerType = MarkerTypeValue == Pairs.end()
+			                                       ? ELocationMarkerType::Static
+			                                       : FRawMarkerRecord::ParseMarkerType(MarkerTypeValue->second.GetS());
+		
+		const FDateTime Timestamp = FDateTime::FromUnixTimestamp(AwsStringToInt64(Pairs.at(SortKeyAttributeNameAws).GetS()));
+		const double Lon = AwsStringToDouble(Pairs.at(PositionXAttributeNameAws).GetN());
+		const double Lat = AwsStringToDouble(Pairs.at(PositionYAttributeNameAws).GetN());
+		const double Elev = AwsStringToDouble(Pairs.at(PositionZAttributeNameAws).GetN());
+		Records.Emplace(Pairs.at(PartitionKeyAttributeNameAws).GetS(), MarkerType, WrapLocationTs(Timestamp, Lon, Lat, Elev));
+	}
+	return Records;
+}
+
+bool UMarkerManager::FetchItems(const Aws::DynamoDB::DynamoDBClient* Client, const FCompiledMarkerQuery& Query,
+                                Aws::Vector<Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue>>& OutItems)
+{
+	if (Query.UseScan)
+	{
+		Aws::DynamoDB::Model::ScanRequest Request = Query.ScanRequest;
+		do
+		{
+			const Aws::DynamoDB::Model::ScanOutcome Outcome = Client->Scan(Request);
+			if (!Outcome.IsSuccess())
+			{
+				UE_LOG(LogMarkerManager, Warning, TEXT("DynamoDB Scan Request failed: %s"), *FString(Outcome.GetError().GetMessage().c_str()));
+				return false;
+			}
+			const Aws::DynamoDB::Model::ScanResult& Result = Outcome.GetResult();
+			OutItems.insert(OutItems.end(), Result.GetItems().begin(), Result.GetItems().end());
+			Request.SetExclusiveStartKey(Result.GetLastEvaluatedKey());
+		}
+		while (!Request.GetExclusiveStartKey().empty());
+		return true;
+	}
+
+	for (Aws::DynamoDB::Model::QueryRequest Request : Query.QueryRequests)
+	{
+		do
+		{
+			const Aws::DynamoDB::Model::QueryOutcome Outcome = Client->Query(Request);
+			if (!Outcome.IsSuccess())
+			{
+				UE_LOG(LogMarkerManager, Warning, TEXT("DynamoDB Query Request failed: %s"), *FString(Outcome.GetError().GetMessage().c_str()));
+				return false;
+			}
+			const Aws::DynamoDB::Model::QueryResult& Result = Outcome.GetResult();
+			OutItems.insert(OutItems.end(), Result.GetItems().begin(), Result.GetItems().end());
+			Request.SetExclusiveStartKey(Result.GetLastEvaluatedKey());
+		}
+		while (!Request.GetExclusiveStartKey().empty());
+	}
+	return true;
+}
+
+FMarkerQuery UMarkerManager::MakeMarkerTypeQuery(const bool StaticMarkersOnly)
+{
+	FMarkerQuery Query;
+	if (StaticMarkersOnly) Query.WithMarkerTypes({ELocationMarkerType::Static});
+	return Query;
+}
+
 void UMarkerManager::GetAllMarkersFromDynamoDB(bool StaticMarkersOnly)
 {
-	Aws::DynamoDB::Model::ScanRequest Request;
-	Request.SetTableName(DynamoDBTableNameAws);
-	Aws::DynamoDB::Model::ScanOutcome Outcome = DynamoClient->Scan(Request);
-	if (Outcome.IsSuccess())
+	if (!AwsReady)
+	{
+		WhenAwsReady([this, StaticMarkersOnly]() { GetAllMarkersFromDynamoDB(StaticMarkersOnly); });
+		return;
+	}
+	const FDateTime ScanStartedAt = FDateTime::UtcNow();
+	Aws::Vector<Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue>> Items;
+	if (FetchItems(DynamoClient, MakeMarkerTypeQuery(StaticMarkersOnly).Compile(), Items))
 	{
-		Aws::DynamoDB::Model::ScanResult Result = Outcome.GetResult();
-		UE_LOG(LogMarkerManager, Display, TEXT("DynamoDB Scan Request success: %d items"), Result.GetCount());
-		TMap<FString, FJsonObject*> DynamicMarkers;
+		LastSyncTimestamp = ScanStartedAt;
+		UE_LOG(LogMarkerManager, Display, TEXT("DynamoDB Scan Request success: %d items"), Items.size());
+		if (ReconcileFullSyncs)
+		{
+			ReconcileMarkerRecords(DecodeItems(Items), StaticMarkersOnly, ScanStartedAt);
+			return;
+		}
+		EnqueueMarkerRecordBatches(FMarkerRecordBatch::Coalesce(DecodeItems(Items)));
+	}
+}
 
-		for (auto Pairs : Result.GetItems())
+TFuture<int> UMarkerManager::GetAllMarkersFromDynamoDBAsync(const bool StaticMarkersOnly)
+{
+	if (ReconcileFullSyncs)
+	{
+		return ReconcileMarkersAsync(StaticMarkersOnly).Next([](const FMarkerReconcileResult& Result)
 		{
-			// device id
-			FString DeviceID = AwsStringToFString(Pairs.at(PartitionKeyAttributeNameAws).GetS());
+			return Result.Success ? Result.Records : -1;
+		});
+	}
+	TWeakObjectPtr<UMarkerManager> WeakThis(this);
+	const FDateTime ScanStartedAt = FDateTime::UtcNow();
+	return LoadMarkersAsync(MakeMarkerTypeQuery(StaticMarkersOnly)).Next([WeakThis, ScanStartedAt](const int Count)
+	{
+		if (Count >= 0 && WeakThis.IsValid()) WeakThis->LastSyncTimestamp = ScanStartedAt;
+		return Count;
+	});
+}
+
+TFuture<TOptional<TArray<FMarkerRecord>>> UMarkerManager::QueryMarkersAsync(const FMarkerQuery& Query)
+{
+	const TSharedRef<TPromise<TOptional<TArray<FMarkerRecord>>>> Promise = MakeShared<TPromise<TOptional<TArray<FMarkerRecord>>>>();
+	TFuture<TOptional<TArray<FMarkerRecord>>> Future = Promise->GetFuture();
+	TWeakObjectPtr<UMarkerManager> WeakThis(this);
 
-			// type
-			ELocationMarkerType MarkerType;
-			if (Pairs.find(MarkerTypeAttributeNameAws) == Pairs.end())
+	// the requests of a query run back to back on the thread pool
+	WhenAwsReady([this, Promise, WeakThis, Compiled = Query.Compile()]()
+	{
+		// Shutdown() waits on the counter before the client and the SDK go away
+		FThreadSafeCounter* Tasks = &BackgroundAwsTasks;
+		Tasks->Increment();
+		Async(EAsyncExecution::ThreadPool, [Promise, WeakThis, Client = DynamoClient, Compiled, Tasks]()
+		{
+			TSharedRef<Aws::Vector<Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue>>> Items =
+				MakeShared<Aws::Vector<Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue>>>();
+			const bool Fetched = FetchItems(Client, Compiled, *Items);
+			Tasks->Decrement();
+			if (!Fetched)
 			{
-				MarkerType = ELocationMarkerType::Static;
+				AsyncTask(ENamedThreads::GameThread, [Promise]() { Promise->SetValue(TOptional<TArray<FMarkerRecord>>()); });
+				return;
 			}
-			else
+			UE_LOG(LogMarkerManager, Display, TEXT("Fetched %d items with %s"), Items->size(),
+			       Compiled.UseScan ? TEXT("Scan") : *FString::Printf(TEXT("%d Query requests"), Compiled.QueryRequests.Num()));
+
+			// decoding needs the georeference, so it happens on the game thread along with merging
+			AsyncTask(ENamedThreads::GameThread, [Promise, WeakThis, Items]()
 			{
-				const FString MarkerTypeStr = FString(Pairs.at(MarkerTypeAttributeNameAws).GetS().c_str());
-				if (MarkerTypeStr.ToLower().Equals(DynamicMarkerName.ToLower()))
+				if (!WeakThis.IsValid())
 				{
-					MarkerType = ELocationMarkerType::Dynamic;
+					Promise->SetValue(TOptional<TArray<FMarkerRecord>>());
+					return;
 				}
-				else MarkerType = ELocationMarkerType::Static;
-			}
-			
-			Aws::DynamoDB::Model::AttributeValue TimestampValue = Pairs.at(SortKeyAttributeNameAws);
-			FDateTime Timestamp = FDateTime::FromUnixTimestamp(std::atoi(TimestampValue.GetS().c_str()));
-			
-			double Lon, Lat, Elev;
-			FDefaultValueHelper::ParseDouble(FString(Pairs.at(PositionXAttributeNameAws).GetN().c_str()), Lon);
-			FDefaultValueHelper::ParseDouble(FString(Pairs.at(PositionYAttributeNameAws).GetN().c_str()), Lat);
-			FDefaultValueHelper::ParseDouble(FString(Pairs.at(PositionZAttributeNameAws).GetN().c_str()), Elev);
-			const FLocationTs LocationTs = WrapLocationTs(Timestamp, Lon, Lat, Elev);
-					
-			ALocationMarker* Marker;
-			if (MarkerType == ELocationMarkerType::Static)
+				Promise->SetValue(WeakThis->DecodeItems(*Items));
+			});
+		});
+	});
+	return Future;
+}
+
+TFuture<int> UMarkerManager::LoadMarkersAsync(const FMarkerQuery& Query)
+{
+	TWeakObjectPtr<UMarkerManager> WeakThis(this);
+	return QueryMarkersAsync(Query).Next([WeakThis](const TOptional<TArray<FMarkerRecord>>& Records)
+	{
+		if (!Records.IsSet() || !WeakThis.IsValid()) return -1;
+		WeakThis->EnqueueMarkerRecordBatches(FMarkerRecordBatch::Coalesce(Records.GetValue()));
+		return Records->Num();
+	});
+}
+
+void UMarkerManager::LoadMarkers(const FMarkerQuery& Query)
+{
+	LoadMarkersAsync(Query);
+}
+
+TFuture<int> UMarkerManager::SyncMarkersSinceAsync(const FDateTime Since, const bool StaticMarkersOnly)
+{
+	TWeakObjectPtr<UMarkerManager> WeakThis(this);
+	const FDateTime SyncStartedAt = FDateTime::UtcNow();
+	// compiles to one query per time bucket on the time index
+	return LoadMarkersAsync(MakeMarkerTypeQuery(StaticMarkersOnly).WithTimeRange(Since))
+		.Next([WeakThis, Since, SyncStartedAt](const int Count)
+		{
+			if (Count >= 0 && WeakThis.IsValid())
 			{
-				Marker = SpawnAndInitializeMarker(LocationTs, MarkerType, DeviceID);
+				UE_LOG(LogMarkerManager, Display, TEXT("Synced %d records created since %s"), Count, *Since.ToIso8601());
+				WeakThis->LastSyncTimestamp = SyncStartedAt;
 			}
-			else if (MarkerType == ELocationMarkerType::Dynamic && !StaticMarkersOnly)
+			return Count;
+		});
+}
+
+void UMarkerManager::SyncMarkersSince(const FDateTime Since, const bool StaticMarkersOnly)
+{
+	SyncMarkersSinceAsync(Since, StaticMarkersOnly);
+}
+
+void UMarkerManager::SyncMarkersSinceLastSync(const bool StaticMarkersOnly)
+{
+	if (LastSyncTimestamp == FDateTime::MinValue())
+	{
+		UE_LOG(LogMarkerManager, Warning, TEXT("Nothing has been synced yet, loading all markers instead"));
+		GetAllMarkersFromDynamoDBAsync(StaticMarkersOnly);
+		return;
+	}
+	// overlap with the previous sync to pick up rows written late with an older timestamp.
+	// rows already applied are skipped, since device ID and timestamp are the primary key.
+	SyncMarkersSinceAsync(LastSyncTimestamp - FTimespan::FromMinutes(5.0), StaticMarkersOnly);
+}
+
+TFuture<FMarkerReconcileResult> UMarkerManager::ReconcileMarkersAsync(const bool StaticMarkersOnly)
+{
+	if (ReconcileRunning)
+	{
+		UE_LOG(LogMarkerManager, Warning, TEXT("A reconcile is already running"));
+		return MakeFulfilledPromise<FMarkerReconcileResult>().GetFuture();
+	}
+	ReconcileRunning = true;
+	TWeakObjectPtr<UMarkerManager> WeakThis(this);
+	const FDateTime ReadStartedAt = FDateTime::UtcNow();
+	// the records are decoded on the game thread, so the diff runs against the markers as they are then
+	return QueryMarkersAsync(MakeMarkerTypeQuery(StaticMarkersOnly))
+		.Next([WeakThis, StaticMarkersOnly, ReadStartedAt](const TOptional<TArray<FMarkerRecord>>& Records)
+		{
+			if (!WeakThis.IsValid()) return FMarkerReconcileResult();
+			WeakThis->ReconcileRunning = false;
+			if (!Records.IsSet())
 			{
-				if (SpawnedLocationMarkers.Contains(DeviceID))
-				{
-					// dynamic marker with matching device id already exists
-					Marker = *SpawnedLocationMarkers.Find(DeviceID);
-					if (ADynamicMarker* DynamicMarker = Cast<ADynamicMarker>(Marker))
-					{
-						// pass the new data to the marker
-						DynamicMarker->AddLocationTs(LocationTs);
-						UE_LOG(LogMarkerManager, Display, TEXT("Added new location %s for Dynamic marker %s"),
-							*LocationTs.ToString(),
-							*Marker->ToString());
-					}
-				} else
-				{
-					// spawn dynamic marker only if SpawnedLocationMarkers doesn't contain the device ID
-					Marker = SpawnAndInitializeMarker(LocationTs, MarkerType, DeviceID);
-					UE_LOG(LogMarkerManager, Display, TEXT("Created Dynamic Marker: %s"), *Marker->GetName());
-				}
+				WeakThis->LastReconcileResult = FMarkerReconcileResult();
+				return FMarkerReconcileResult();
 			}
+			WeakThis->LastSyncTimestamp = ReadStartedAt;
+			return WeakThis->ReconcileMarkerRecords(Records.GetValue(), StaticMarkersOnly, ReadStartedAt);
+		});
+}
+
+void UMarkerManager::ReconcileMarkers(const bool StaticMarkersOnly)
+{
+	ReconcileMarkersAsync(StaticMarkersOnly);
+}
+
+FMarkerReconcileResult UMarkerManager::GetLastReconcileResult() const
+{
+	return LastReconcileResult;
+}
+
+FMarkerReconcileResult UMarkerManager::ReconcileMarkerRecords(const TArray<FMarkerRecord>& Records, const bool StaticMarkersOnly,
+                                                              const FDateTime ReadStartedAt)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	TMap<FString, FSpawnedMarkerState> Spawned;
+	Spawned.Reserve(SpawnedLocationMarkers.Num());
+	for (const TPair<FString, ALocationMarker*>& Pair : SpawnedLocationMarkers)
+	{
+		const ALocationMarker* Marker = Pair.Value;
+		if (Marker == nullptr || Marker->IsActorBeingDestroyed()) continue;
+		FSpawnedMarkerState& State = Spawned.Add(Pair.Key);
+		State.MarkerType = Marker->MarkerType;
+		State.LocationTs = Marker->LocationTs;
+		State.LatestTimestamp = Marker->LocationTs.Timestamp;
+		const ADynamicMarker* DynamicMarker = Cast<ADynamicMarker>(Marker);
+		if (DynamicMarker != nullptr && DynamicMarker->HistoryArr.Num() > 0)
+		{
+			State.LatestTimestamp = DynamicMarker->HistoryArr.Last().Timestamp;
+		}
+	}
+
+	FMarkerReconcilePlan Plan = FMarkerReconcilePlan::Diff(FMarkerRecordBatch::Coalesce(Records), Spawned, StaticMarkersOnly,
+	                                                       ReadStartedAt, GetDefault<ATemporaryMarker>()->DefaultLifeSpan,
+	                                                       GetDefault<ADynamicMarker>()->DefaultLifeSpan);
+
+	FMarkerReconcileResult Result;
+	Result.Success = true;
+	Result.Records = Records.Num();
+	Result.Unchanged = Plan.Unchanged;
+
+	for (const FString& DeviceID : Plan.Removed)
+	{
+		// a queued update may be newer than the read, so leave the marker to it
+		if (PendingBatchIndex.Contains(DeviceID) || ReorderBuffer.IsHolding(DeviceID))
+		{
+			Result.Deferred++;
+			continue;
+		}
+		ALocationMarker** Marker = SpawnedLocationMarkers.Find(DeviceID);
+		if (Marker == nullptr || *Marker == nullptr) continue;
+		// the table no longer has the marker, so there is nothing to delete
+		(*Marker)->DeleteFromDBOnDestroy = false;
+		(*Marker)->Destroy();
+		Result.Removed++;
+	}
+
+	TArray<FMarkerRecordBatch> Queued = MoveTemp(Plan.Added);
+	if (RegionStreaming)
+	{
+		// only the loaded tiles are in view, and their markers are region streaming's to unload
+		Queued.RemoveAll([this](const FMarkerRecordBatch& Batch)
+		{
+			const FLocationTs& Location = Batch.MarkerType == ELocationMarkerType::Dynamic ? Batch.Locations.Last() : Batch.Locations[0];
+			const FString Tile = FGeohash::Encode(Location.Wgs84Coordinate.Y, Location.Wgs84Coordinate.X, TileGeohashPrecision);
+			if (!LoadedTiles.Contains(Tile)) return true;
+			AddTileDevice(Tile, Batch.DeviceID);
+			return false;
+		});
+	}
+	Result.Added = Queued.Num();
+	for (FMarkerRecordBatch& Batch : Plan.Updated)
+	{
+		Result.Updated++;
+		if (Batch.MarkerType == ELocationMarkerType::Dynamic)
+		{
+			Queued.Add(MoveTemp(Batch));
+			continue;
+		}
+		if (ALocationMarker** Marker = SpawnedLocationMarkers.Find(Batch.DeviceID))
+		{
+			if (RecordMarkerHistory) TemporalStore.Add(Batch.DeviceID, Batch.MarkerType, Batch.Locations);
+			RelocateMarker(*Marker, Batch.Locations[0]);
+		}
+	}
+	if (Queued.Num() > 0) EnqueueMarkerRecordBatches(MoveTemp(Queued));
+
+	LastReconcileResult = Result;
+	UE_LOG(LogMarkerManager, Display, TEXT("Reconciled %d records in %.2f ms: %d added, %d updated, %d removed, %d unchanged, %d deferred"),
+	       Result.Records, (FPlatformTime::Seconds() - StartTime) * 1000.0, Result.Added, Result.Updated, Result.Removed,
+	       Result.Unchanged, Result.Deferred);
+	return Result;
+}
+
+void UMarkerManager::RelocateMarker(ALocationMarker* Marker, const FLocationTs& LocationTs)
+{
+	Marker->LocationTs = LocationTs;
+	Marker->SetActorLocation(LocationTs.UECoordinate, false, nullptr, ETeleportType::TeleportPhysics);
+	if (BatchedReanchoring && Georeference != nullptr && UseCesiumGeoreference)
+	{
+		MarkerAnchors.Add(Marker->DeviceID, Marker, LocationTs.EcefCoordinate);
+	}
+	if (PickingGrid.Contains(Marker->DeviceID))
+	{
+		PickingGrid.Update(Marker->DeviceID, Marker, Marker->GetActorLocation(), Marker->DefaultRadius * Marker->GetActorScale3D().GetMax());
+	}
+	ReplicateMarkerUpdate(Marker->DeviceID, Marker->MarkerType, LocationTs);
+	UE_LOG(LogMarkerManager, Display, TEXT("Moved %s"), *Marker->ToString());
+}
+
+void UMarkerManager::TickFullResync()
+{
+	if (FullResyncInterval <= 0.0f || ReconcileRunning || !AwsReady) return;
+	const double Now = FPlatformTime::Seconds();
+	if (LastFullResyncTime == 0.0)
+	{
+		// the first one waits a full interval, since the game usually loads the markers itself
+		LastFullResyncTime = Now;
+		return;
+	}
+	if (Now - LastFullResyncTime < FullResyncInterval) return;
+	LastFullResyncTime = Now;
+	ReconcileMarkersAsync(false);
+}
+
+void UMarkerManager::SetRegionStreaming(const bool Enabled)
+{
+	if (Enabled == RegionStreaming) return;
+	if (Enabled)
+	{
+		if (Georeference == nullptr)
+		{
+			UE_LOG(LogMarkerManager, Warning, TEXT("Region streaming requires a CesiumGeoreference, see UseCesiumGeoreference in Settings.h"));
+			return;
 		}
+		GetWorld()->GetTimerManager().SetTimer(RegionStreamingTimerHandle, this, &UMarkerManager::UpdateRegionStreaming,
+		                                          RegionStreamingInterval, true, 0.0f);
 	}
 	else
 	{
-		UE_LOG(LogMarkerManager, Warning, TEXT("DynamoDB Scan Request failed: %s"),
-		       *FString(Outcome.GetError().GetMessage().c_str()));
+		GetWorld()->GetTimerManager().ClearTimer(RegionStreamingTimerHandle);
+		// reads still running are dropped when they finish
+		TilesInFlight.Reset();
+		TArray<FString> Tiles;
+		LoadedTiles.GetKeys(Tiles);
+		for (const FString& Tile : Tiles)
+		{
+			UnloadTile(Tile);
+		}
+	}
+	RegionStreaming = Enabled;
+}
+
+TArray<FString> UMarkerManager::GetLoadedTiles() const
+{
+	TArray<FString> Tiles;
+	LoadedTiles.GetKeys(Tiles);
+	return Tiles;
+}
+
+void UMarkerManager::UpdateRegionStreaming()
+{
+	FVector CameraLocation;
+	if (Georeference == nullptr || !GetCameraLocation(CameraLocation)) return;
+
+	const glm::dvec3 CameraLonLatHeight = Georeference->TransformUnrealToLongitudeLatitudeHeight(
+		glm::dvec3(CameraLocation.X, CameraLocation.Y, CameraLocation.Z));
+	const TArray<FString> TilesInRange = FGeohash::CoverRadius(
+		CameraLonLatHeight.y, CameraLonLatHeight.x, RegionStreamingRadiusMeters, TileGeohashPrecision);
+	const TSet<FString> TilesInRangeSet(TilesInRange);
+
+	TArray<FString> TilesToUnload;
+	for (const TPair<FString, TSet<FString>>& Loaded : LoadedTiles)
+	{
+		if (!TilesInRangeSet.Contains(Loaded.Key)) TilesToUnload.Add(Loaded.Key);
+	}
+	for (const FString& Tile : TilesToUnload)
+	{
+		UnloadTile(Tile);
+	}
+	// the camera moved on from tiles still being read; their results only go to the cache
+	for (TMap<FString, uint32>::TIterator It = TilesInFlight.CreateIterator(); It; ++It)
+	{
+		if (!TilesInRangeSet.Contains(It.Key())) It.RemoveCurrent();
+	}
+
+	// TilesInRange is ordered nearest first
+	for (const FString& Tile : TilesInRange)
+	{
+		if (!LoadedTiles.Contains(Tile) && !TilesInFlight.Contains(Tile)) LoadTile(Tile);
+	}
+}
+
+void UMarkerManager::LoadTile(const FString& Tile)
+{
+	if (const TArray<FMarkerRecord>* Cached = TileCache.Find(Tile))
+	{
+		if (FPlatformTime::Seconds() - TileCacheTimes.FindRef(Tile) < TileCacheSeconds)
+		{
+			TileCacheOrder.Remove(Tile);
+			TileCacheOrder.Add(Tile);
+			ApplyTile(Tile, *Cached);
+			return;
+		}
+		// rows may have been added or deleted since, so read the tile again
+		RemoveFromTileCache(Tile);
+	}
+
+	const uint32 Generation = ++TileLoadGeneration;
+	TilesInFlight.Add(Tile, Generation);
+	TWeakObjectPtr<UMarkerManager> WeakThis(this);
+	QueryMarkersAsync(FMarkerQuery().WithTiles({Tile})).Next([WeakThis, Tile, Generation](const TOptional<TArray<FMarkerRecord>>& Records)
+	{
+		if (!WeakThis.IsValid()) return;
+		// the camera may have moved on while the query was running, or streaming been turned off, or the tile reloaded
+		const uint32* Current = WeakThis->TilesInFlight.Find(Tile);
+		const bool Stale = Current == nullptr || *Current != Generation;
+		if (!Stale) WeakThis->TilesInFlight.Remove(Tile);
+		if (!Records.IsSet()) return;
+
+		WeakThis->AddToTileCache(Tile, Records.GetValue());
+		if (!Stale && !WeakThis->LoadedTiles.Contains(Tile)) WeakThis->ApplyTile(Tile, Records.GetValue());
+	});
+}
+
+void UMarkerManager::ApplyTile(const FString& Tile, const TArray<FMarkerRecord>& Records)
+{
+	TArray<FMarkerRecordBatch> Batches = FMarkerRecordBatch::Coalesce(Records);
+	LoadedTiles.FindOrAdd(Tile).Reserve(Batches.Num());
+	for (const FMarkerRecordBatch& Batch : Batches)
+	{
+		AddTileDevice(Tile, Batch.DeviceID);
+	}
+	UE_LOG(LogMarkerManager, Display, TEXT("Loading tile %s with %d markers"), *Tile, Batches.Num());
+	EnqueueMarkerRecordBatches(MoveTemp(Batches));
+}
+
+void UMarkerManager::UnloadTile(const FString& Tile)
+{
+	TSet<FString> DeviceIDs;
+	if (!LoadedTiles.RemoveAndCopyValue(Tile, DeviceIDs)) return;
+
+	UE_LOG(LogMarkerManager, Display, TEXT("Unloading tile %s with %d markers"), *Tile, DeviceIDs.Num());
+	for (const FString& DeviceID : DeviceIDs)
+	{
+		int32* Refs = TileDeviceRefs.Find(DeviceID);
+		if (Refs != nullptr && --*Refs > 0) continue;
+		TileDeviceRefs.Remove(DeviceID);
+		// markers spawned by the stream, a listener or a full load are not region streaming's to destroy
+		if (!TileSpawnedDevices.Remove(DeviceID)) continue;
+		RemovePendingBatch(DeviceID);
+		if (ALocationMarker** Marker = SpawnedLocationMarkers.Find(DeviceID))
+		{
+			// the marker leaves the view, not the database
+			(*Marker)->DeleteFromDBOnDestroy = false;
+			(*Marker)->Destroy();
+		}
+	}
+}
+
+void UMarkerManager::AddTileDevice(const FString& Tile, const FString& DeviceID)
+{
+	bool AlreadyListed;
+	LoadedTiles.FindOrAdd(Tile).Add(DeviceID, &AlreadyListed);
+	if (AlreadyListed) return;
+	TileDeviceRefs.FindOrAdd(DeviceID)++;
+	if (!SpawnedLocationMarkers.Contains(DeviceID) && !PendingBatchIndex.Contains(DeviceID) && !ReorderBuffer.IsHolding(DeviceID))
+	{
+		TileSpawnedDevices.Add(DeviceID);
+	}
+}
+
+void UMarkerManager::AddToTileCache(const FString& Tile, const TArray<FMarkerRecord>& Records)
+{
+	TileCacheOrder.Remove(Tile);
+	TileCacheOrder.Add(Tile);
+	TileCache.Add(Tile, Records);
+	TileCacheTimes.Add(Tile, FPlatformTime::Seconds());
+	while (TileCacheOrder.Num() > FMath::Max(TileCacheCapacity, 1))
+	{
+		RemoveFromTileCache(TileCacheOrder[0]);
 	}
 }
 
+void UMarkerManager::RemoveFromTileCache(const FString& Tile)
+{
+	TileCache.Remove(Tile);
+	TileCacheTimes.Remove(Tile);
+	TileCacheOrder.Remove(Tile);
+}
+
 void UMarkerManager::DestroySelectedMarkers()
 {
 	for (auto It = SpawnedLocationMarkers.CreateIterator(); It; ++It)
@@ -534,6 +2179,140 @@ void UMarkerManager::DestroySelectedMarkers()
 	}
 }
 
+void UMarkerManager::RefreshPickingGrid()
+{
+	for (auto It = PickableDynamicMarkers.CreateIterator(); It; ++It)
+	{
+		ALocationMarker** Marker = SpawnedLocationMarkers.Find(*It);
+		if (Marker == nullptr || *Marker == nullptr)
+		{
+			PickingGrid.Remove(*It);
+			It.RemoveCurrent();
+			continue;
+		}
+		PickingGrid.Update(*It, *Marker, (*Marker)->GetActorLocation(), (*Marker)->DefaultRadius * (*Marker)->GetActorScale3D().GetMax());
+	}
+}
+
+bool UMarkerManager::GetPlayerViewProjection(const APlayerController* PlayerController, FMatrix& OutViewProjection, FIntRect& OutViewRect)
+{
+	const ULocalPlayer* LocalPlayer = PlayerController != nullptr ? PlayerController->GetLocalPlayer() : nullptr;
+	if (LocalPlayer == nullptr || LocalPlayer->ViewportClient == nullptr) return false;
+	FSceneViewProjectionData ProjectionData;
+	if (!LocalPlayer->GetProjectionData(LocalPlayer->ViewportClient->Viewport, ProjectionData)) return false;
+	OutViewProjection = ProjectionData.ComputeViewProjectionMatrix();
+	OutViewRect = ProjectionData.GetConstrainedViewRect();
+	return OutViewRect.Width() > 0 && OutViewRect.Height() > 0;
+}
+
+ALocationMarker* UMarkerManager::PickMarkerAtScreenPosition(APlayerController* PlayerController, const FVector2D ScreenPosition)
+{
+	FVector Origin, Direction;
+	if (PlayerController == nullptr ||
+		!PlayerController->DeprojectScreenPositionToWorld(ScreenPosition.X, ScreenPosition.Y, Origin, Direction))
+	{
+		return nullptr;
+	}
+	return PickMarker(Origin, Direction, PickingMaxDistance);
+}
+
+ALocationMarker* UMarkerManager::PickMarker(const FVector Origin, const FVector Direction, const float MaxDistance)
+{
+	RefreshPickingGrid();
+	double Distance;
+	return PickingGrid.Raycast(Origin, Direction.GetSafeNormal(), MaxDistance, Distance);
+}
+
+TArray<ALocationMarker*> UMarkerManager::SelectMarkersInBox(APlayerController* PlayerController, const FVector2D Start, const FVector2D End)
+{
+	TArray<ALocationMarker*> Markers;
+	FMatrix ViewProjection;
+	FIntRect ViewRect;
+	if (!GetPlayerViewProjection(PlayerController, ViewProjection, ViewRect)) return Markers;
+
+	// the rectangle in normalized device coordinates, at least a pixel wide so a click still selects
+	const auto ToNdcX = [&ViewRect](const double X) { return (X - ViewRect.Min.X) / ViewRect.Width() * 2.0 - 1.0; };
+	const auto ToNdcY = [&ViewRect](const double Y) { return 1.0 - (Y - ViewRect.Min.Y) / ViewRect.Height() * 2.0; };
+	const double MinX = ToNdcX(FMath::Min(Start.X, End.X));
+	const double MaxX = FMath::Max(ToNdcX(FMath::Max(Start.X, End.X)), MinX + 2.0 / ViewRect.Width());
+	const double MinY = ToNdcY(FMath::Max(Start.Y, End.Y));
+	const double MaxY = FMath::Max(ToNdcY(FMath::Min(Start.Y, End.Y)), MinY + 2.0 / ViewRect.Height());
+
+	// scale the rectangle up to the whole clip space; the frustum of the result is the rectangle's frustum
+	const double Width = MaxX - MinX;
+	const double Height = MaxY - MinY;
+	const FMatrix RectToClip(FPlane(2.0 / Width, 0.0, 0.0, 0.0),
+	                         FPlane(0.0, 2.0 / Height, 0.0, 0.0),
+	                         FPlane(0.0, 0.0, 1.0, 0.0),
+	                         FPlane(-(MinX + MaxX) / Width, -(MinY + MaxY) / Height, 0.0, 1.0));
+	FConvexVolume Frustum;
+	GetViewFrustumBounds(Frustum, ViewProjection * RectToClip, false);
+
+	RefreshPickingGrid();
+	PickingGrid.Overlap(Frustum, Markers);
+	return Markers;
+}
+
+TArray<ALocationMarker*> UMarkerManager::SelectMarkersInLasso(APlayerController* PlayerController, const TArray<FVector2D>& Points)
+{
+	TArray<ALocationMarker*> Markers;
+	if (Points.Num() < 3) return Markers;
+	FMatrix ViewProjection;
+	FIntRect ViewRect;
+	if (!GetPlayerViewProjection(PlayerController, ViewProjection, ViewRect)) return Markers;
+
+	// the grid narrows the search to the polygon's bounding box, then each candidate's center is tested
+	const FBox2D Bounds(Points);
+	TArray<ALocationMarker*> Candidates = SelectMarkersInBox(PlayerController, Bounds.Min, Bounds.Max);
+	for (ALocationMarker* Marker : Candidates)
+	{
+		FVector2D ScreenPosition;
+		if (!FSceneView::ProjectWorldToScreen(Marker->GetActorLocation(), ViewRect, ViewProjection, ScreenPosition)) continue;
+		// even-odd rule: count the edges crossed by a horizontal ray from the point
+		bool Inside = false;
+		for (int32 i = 0, j = Points.Num() - 1; i < Points.Num(); j = i++)
+		{
+			const FVector2D& A = Points[i];
+			const FVector2D& B = Points[j];
+			if ((A.Y > ScreenPosition.Y) != (B.Y > ScreenPosition.Y) &&
+				ScreenPosition.X < (B.X - A.X) * (ScreenPosition.Y - A.Y) / (B.Y - A.Y) + A.X)
+			{
+				Inside = !Inside;
+			}
+		}
+		if (Inside) Markers.Add(Marker);
+	}
+	return Markers;
+}
+
+void UMarkerManager::SetMarkersSelected(const TArray<ALocationMarker*>& Markers, const bool Selected, const bool ClearOthers)
+{
+	if (ClearOthers) ClearMarkerSelection();
+	for (ALocationMarker* Marker : Markers)
+	{
+		if (Marker != nullptr) Marker->SetSelected(Selected);
+	}
+	UE_LOG(LogMarkerManager, Display, TEXT("%s %d markers"), Selected ? TEXT("Selected") : TEXT("Unselected"), Markers.Num());
+}
+
+void UMarkerManager::ClearMarkerSelection()
+{
+	for (const TPair<FString, ALocationMarker*>& Pair : SpawnedLocationMarkers)
+	{
+		if (Pair.Value != nullptr) Pair.Value->SetSelected(false);
+	}
+}
+
+TArray<ALocationMarker*> UMarkerManager::GetSelectedMarkers() const
+{
+	TArray<ALocationMarker*> Markers;
+	for (const TPair<FString, ALocationMarker*>& Pair : SpawnedLocationMarkers)
+	{
+		if (Pair.Value != nullptr && Pair.Value->Selected) Markers.Add(Pair.Value);
+	}
+	return Markers;
+}
+
 void UMarkerManager::DestroyMarker(const FString DeviceID, const FDateTime Timestamp, const bool DeleteFromDB)
 {
 	UE_LOG(LogMarkerManager, Display, TEXT("Destroying: %s - %s"), *DeviceID, *Timestamp.ToIso8601());
@@ -542,6 +2321,12 @@ void UMarkerManager::DestroyMarker(const FString DeviceID, const FDateTime Times
 		SpawnedLocationMarkers.FindAndRemoveChecked(DeviceID);
 		UE_LOG(LogMarkerManager, Display, TEXT("Removed: %s - %s"), *DeviceID, *Timestamp.ToIso8601());
 	}
+	if (ReplicationServer) InterestGrid.Remove(DeviceID);
+	MarkerAnchors.Remove(DeviceID);
+	PickingGrid.Remove(DeviceID);
+	// a marker spawned again later comes from wherever spawns it then
+	TileSpawnedDevices.Remove(DeviceID);
+	PickableDynamicMarkers.Remove(DeviceID);
 
 	if (DeleteFromDB)
 	{
@@ -551,24 +2336,49 @@ void UMarkerManager::DestroyMarker(const FString DeviceID, const FDateTime Times
 	}
 }
 
-bool UMarkerManager::DeleteMarkerFromDynamoDB(const FString DeviceID, const FDateTime Timestamp) const
+Aws::DynamoDB::Model::DeleteItemRequest UMarkerManager::MakeDeleteItemRequest(const FString& DeviceID, const FDateTime Timestamp)
 {
 	Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue> AttributeValues;
 	Aws::DynamoDB::Model::AttributeValue PartitionKey;
-	PartitionKey.SetS(Aws::String(TCHAR_TO_UTF8(*DeviceID)));
+	PartitionKey.SetS(FStringToAwsString(DeviceID));
 	Aws::DynamoDB::Model::AttributeValue SortKey;
-	SortKey.SetS(Aws::String(TCHAR_TO_UTF8(*FString::FromInt(Timestamp.ToUnixTimestamp()))));
+	SortKey.SetS(AwsStringFromInt64(Timestamp.ToUnixTimestamp()));
 	AttributeValues.emplace(PartitionKeyAttributeNameAws, PartitionKey);
 	AttributeValues.emplace(SortKeyAttributeNameAws, SortKey);
 
-	const Aws::DynamoDB::Model::DeleteItemRequest Request = Aws::DynamoDB::Model::DeleteItemRequest()
-	                                                        .WithTableName(DynamoDBTableNameAws)
-	                                                        .WithKey(AttributeValues);
-	const Aws::DynamoDB::Model::DeleteItemOutcome Outcome = DynamoClient->DeleteItem(Request);
+	return Aws::DynamoDB::Model::DeleteItemRequest()
+	       .WithTableName(DynamoDBTableNameAws)
+	       .WithKey(AttributeValues);
+}
+
+bool UMarkerManager::DeleteMarkerFromDynamoDB(const FString DeviceID, const FDateTime Timestamp) const
+{
+	WaitForAws();
+	const Aws::DynamoDB::Model::DeleteItemOutcome Outcome = DynamoClient->DeleteItem(MakeDeleteItemRequest(DeviceID, Timestamp));
 	const bool Success = Outcome.IsSuccess();
 	return Success;
 }
 
+TFuture<bool> UMarkerManager::DeleteMarkerFromDynamoDBAsync(const FString DeviceID, const FDateTime Timestamp) const
+{
+	const TSharedRef<TPromise<bool>> Promise = MakeShared<TPromise<bool>>();
+	TFuture<bool> Future = Promise->GetFuture();
+	WhenAwsReady([this, Promise, Request = MakeDeleteItemRequest(DeviceID, Timestamp)]()
+	{
+		DynamoClient->DeleteItemAsync(
+			Request,
+			[Promise](const Aws::DynamoDB::DynamoDBClient*,
+			          const Aws::DynamoDB::Model::DeleteItemRequest&,
+			          const Aws::DynamoDB::Model::DeleteItemOutcome& Outcome,
+			          const std::shared_ptr<const Aws::Client::AsyncCallerContext>&)
+			{
+				const bool Success = Outcome.IsSuccess();
+				AsyncTask(ENamedThreads::GameThread, [Promise, Success]() { Promise->SetValue(Success); });
+			});
+	});
+	return Future;
+}
+
 TArray<ALocationMarker*> UMarkerManager::GetActiveMarkers() const
 {
 	TArray<ALocationMarker*> AllMarkers;
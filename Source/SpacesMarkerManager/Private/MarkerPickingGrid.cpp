@@ -0,0 +1,192 @@
+#include "MarkerPickingGrid.h"
+
+#include "ConvexVolume.h"
+#include "LocationMarker.h"
+
+FMarkerPickingGrid::FMarkerPickingGrid(const double InCellSize)
+	: CellSize(FMath::Max(InCellSize, 1.0))
+{
+}
+
+void FMarkerPickingGrid::Reset(const double InCellSize)
+{
+	CellSize = FMath::Max(InCellSize, 1.0);
+	Entries.Reset();
+	Index.Reset();
+	Cells.Reset();
+	Bounds = FBox(ForceInit);
+}
+
+FIntVector FMarkerPickingGrid::GetCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / CellSize),
+	                  FMath::FloorToInt(Location.Y / CellSize),
+	                  FMath::FloorToInt(Location.Z / CellSize));
+}
+
+void FMarkerPickingGrid::Link(const int32 EntryIndex)
+{
+	FEntry& Entry = Entries[EntryIndex];
+	const FVector Extent(Entry.Radius);
+	Entry.MinCell = GetCell(Entry.Location - Extent);
+	Entry.MaxCell = GetCell(Entry.Location + Extent);
+	for (int32 X = Entry.MinCell.X; X <= Entry.MaxCell.X; X++)
+	{
+		for (int32 Y = Entry.MinCell.Y; Y <= Entry.MaxCell.Y; Y++)
+		{
+			for (int32 Z = Entry.MinCell.Z; Z <= Entry.MaxCell.Z; Z++)
+			{
+				Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(EntryIndex);
+			}
+		}
+	}
+	Bounds += FBox(Entry.Location - Extent, Entry.Location + Extent);
+}
+
+void FMarkerPickingGrid::Unlink(const int32 EntryIndex)
+{
+	const FEntry& Entry = Entries[EntryIndex];
+	for (int32 X = Entry.MinCell.X; X <= Entry.MaxCell.X; X++)
+	{
+		for (int32 Y = Entry.MinCell.Y; Y <= Entry.MaxCell.Y; Y++)
+		{
+			for (int32 Z = Entry.MinCell.Z; Z <= Entry.MaxCell.Z; Z++)
+			{
+				const FIntVector Cell(X, Y, Z);
+				TArray<int32>* CellEntries = Cells.Find(Cell);
+				if (CellEntries == nullptr) continue;
+				CellEntries->RemoveSingleSwap(EntryIndex, false);
+				if (CellEntries->Num() == 0) Cells.Remove(Cell);
+			}
+		}
+	}
+}
+
+void FMarkerPickingGrid::Update(const FString& DeviceID, ALocationMarker* Marker, const FVector& Location, const float Radius)
+{
+	if (const int32* Existing = Index.Find(DeviceID))
+	{
+		FEntry& Entry = Entries[*Existing];
+		Entry.Marker = Marker;
+		if (Entry.Location == Location && Entry.Radius == Radius) return;
+		Unlink(*Existing);
+		Entry.Location = Location;
+		Entry.Radius = Radius;
+		Link(*Existing);
+		return;
+	}
+
+	FEntry Entry;
+	Entry.Marker = Marker;
+	Entry.Location = Location;
+	Entry.Radius = Radius;
+	const int32 EntryIndex = Entries.Add(MoveTemp(Entry));
+	Index.Add(DeviceID, EntryIndex);
+	Link(EntryIndex);
+}
+
+void FMarkerPickingGrid::Remove(const FString& DeviceID)
+{
+	int32 EntryIndex;
+	if (!Index.RemoveAndCopyValue(DeviceID, EntryIndex)) return;
+	Unlink(EntryIndex);
+	Entries.RemoveAt(EntryIndex);
+}
+
+ALocationMarker* FMarkerPickingGrid::Raycast(const FVector& Origin, const FVector& Direction, const double MaxDistance,
+                                             double& OutDistance) const
+{
+	if (Index.Num() == 0 || Direction.IsNearlyZero()) return nullptr;
+
+	// only the part of the ray inside the bounds of all markers can hit anything
+	FVector HitLocation, HitNormal;
+	float HitTime;
+	const FVector End = Origin + Direction * MaxDistance;
+	double Start = 0.0;
+	if (!Bounds.IsInsideOrOn(Origin))
+	{
+		if (!FMath::LineExtentBoxIntersection(Bounds, Origin, End, FVector::ZeroVector, HitLocation, HitNormal, HitTime)) return nullptr;
+		Start = HitTime * MaxDistance;
+	}
+
+	// 3D DDA: the next cell boundary along each axis, and the ray distance between boundaries
+	const FVector Entry = Origin + Direction * Start;
+	FIntVector Cell = GetCell(Entry);
+	FIntVector Step;
+	FVector NextBoundary, BoundaryDelta;
+	for (int32 Axis = 0; Axis < 3; Axis++)
+	{
+		const double D = Direction[Axis];
+		Step[Axis] = D > 0.0 ? 1 : (D < 0.0 ? -1 : 0);
+		if (Step[Axis] == 0)
+		{
+			NextBoundary[Axis] = TNumericLimits<double>::Max();
+			BoundaryDelta[Axis] = TNumericLimits<double>::Max();
+			continue;
+		}
+		const double Boundary = (Cell[Axis] + (Step[Axis] > 0 ? 1 : 0)) * CellSize;
+		NextBoundary[Axis] = Start + (Boundary - Entry[Axis]) / D;
+		BoundaryDelta[Axis] = CellSize / FMath::Abs(D);
+	}
+
+	const FBox WalkBounds = Bounds.ExpandBy(CellSize);
+	ALocationMarker* Best = nullptr;
+	double BestDistance = MaxDistance;
+	double CellStart = Start;
+	while (CellStart <= BestDistance)
+	{
+		if (const TArray<int32>* CellEntries = Cells.Find(Cell))
+		{
+			for (const int32 EntryIndex : *CellEntries)
+			{
+				const FEntry& Candidate = Entries[EntryIndex];
+				// ray against sphere: the closest approach, then back along the ray to the surface
+				const FVector ToCenter = Candidate.Location - Origin;
+				const double Along = FVector::DotProduct(ToCenter, Direction);
+				const double MissSquared = ToCenter.SizeSquared() - Along * Along;
+				const double RadiusSquared = FMath::Square(static_cast<double>(Candidate.Radius));
+				if (MissSquared > RadiusSquared) continue;
+				// behind the origin, unless the origin is inside the sphere
+				if (Along < 0.0 && ToCenter.SizeSquared() > RadiusSquared) continue;
+				const double Distance = FMath::Max(Along - FMath::Sqrt(RadiusSquared - MissSquared), 0.0);
+				if (Distance >= BestDistance) continue;
+				ALocationMarker* Marker = Candidate.Marker.Get();
+				if (Marker == nullptr) continue;
+				Best = Marker;
+				BestDistance = Distance;
+			}
+		}
+
+		// step into the neighbour across the nearest boundary
+		const int32 Axis = NextBoundary.X < NextBoundary.Y
+			                   ? (NextBoundary.X < NextBoundary.Z ? 0 : 2)
+			                   : (NextBoundary.Y < NextBoundary.Z ? 1 : 2);
+		CellStart = NextBoundary[Axis];
+		if (CellStart > MaxDistance) break;
+		Cell[Axis] += Step[Axis];
+		NextBoundary[Axis] += BoundaryDelta[Axis];
+		// past the bounds there is nothing left to hit
+		if (!WalkBounds.IsInsideOrOn(Origin + Direction * CellStart)) break;
+	}
+	OutDistance = BestDistance;
+	return Best;
+}
+
+void FMarkerPickingGrid::Overlap(const FConvexVolume& Volume, TArray<ALocationMarker*>& OutMarkers) const
+{
+	const FVector HalfCell(CellSize * 0.5);
+	TBitArray<> Seen(false, Entries.GetMaxIndex());
+	for (const TPair<FIntVector, TArray<int32>>& Pair : Cells)
+	{
+		const FVector CellCenter = (FVector(Pair.Key) + FVector(0.5)) * CellSize;
+		if (!Volume.IntersectBox(CellCenter, HalfCell)) continue;
+		for (const int32 EntryIndex : Pair.Value)
+		{
+			if (Seen[EntryIndex]) continue;
+			Seen[EntryIndex] = true;
+			const FEntry& Entry = Entries[EntryIndex];
+			if (!Volume.IntersectSphere(Entry.Location, Entry.Radius)) continue;
+			if (ALocationMarker* Marker = Entry.Marker.Get()) OutMarkers.Add(Marker);
+		}
+	}
+}
@@ -0,0 +1,229 @@
+#include "MarkerQuery.h"
+
+#include "Geohash.h"
+#include "Settings.h"
+
+namespace
+{
+	// DynamoDB allows at most 100 operands in an IN comparator
+	constexpr int32 MaxInOperands = 100;
+
+	/*
+	 * Expression attribute names and values of a single request.
+	 * DynamoDB rejects requests with unused names or values, so they are only added when an expression uses them.
+	 */
+	class FMarkerExpression
+	{
+	public:
+		Aws::String Filter;
+
+		Aws::String Name(const char* Placeholder, const Aws::String& AttributeName)
+		{
+			Names[Placeholder] = AttributeName;
+			return Placeholder;
+		}
+
+		Aws::String Value(const Aws::String& Value)
+		{
+			const Aws::String Placeholder = ":v" + AwsStringFromInt64(Values.size());
+			Values[Placeholder] = Aws::DynamoDB::Model::AttributeValue().SetS(Value);
+			return Placeholder;
+		}
+
+		void AddFilter(const Aws::String& Condition)
+		{
+			if (Condition.empty()) return;
+			if (!Filter.empty()) Filter += " AND ";
+			Filter += "(" + Condition + ")";
+		}
+
+		/* "#name IN (:v0, ...)", split into groups of MaxInOperands joined with OR */
+		Aws::String In(const Aws::String& NamePlaceholder, const TArray<Aws::String>& Operands)
+		{
+			Aws::String Condition;
+			for (int32 i = 0; i < Operands.Num(); i++)
+			{
+				if (i % MaxInOperands == 0)
+				{
+					if (i > 0) Condition += ") OR ";
+					Condition += NamePlaceholder + " IN (";
+				}
+				else Condition += ", ";
+				Condition += Value(Operands[i]);
+			}
+			if (!Condition.empty()) Condition += ")";
+			return Condition;
+		}
+
+		template <typename RequestType>
+		void ApplyTo(RequestType& Request)
+		{
+			// only the attributes read by UMarkerManager::DecodeItems()
+			Request.SetTableName(DynamoDBTableNameAws);
+			Request.SetProjectionExpression(
+				Name("#pk", PartitionKeyAttributeNameAws) + ", " +
+				Name("#ts", SortKeyAttributeNameAws) + ", " +
+				Name("#lon", PositionXAttributeNameAws) + ", " +
+				Name("#lat", PositionYAttributeNameAws) + ", " +
+				Name("#elev", PositionZAttributeNameAws) + ", " +
+				Name("#type", MarkerTypeAttributeNameAws));
+			if (!Filter.empty()) Request.SetFilterExpression(Filter);
+			Request.SetExpressionAttributeNames(Names);
+			if (!Values.empty()) Request.SetExpressionAttributeValues(Values);
+		}
+
+	private:
+		Aws::Map<Aws::String, Aws::String> Names;
+		Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue> Values;
+	};
+}
+
+FMarkerQuery& FMarkerQuery::WithMarkerTypes(const TArray<ELocationMarkerType>& InMarkerTypes)
+{
+	MarkerTypes = InMarkerTypes;
+	return *this;
+}
+
+FMarkerQuery& FMarkerQuery::WithDeviceIDs(const TArray<FString>& InDeviceIDs)
+{
+	DeviceIDs = InDeviceIDs;
+	return *this;
+}
+
+FMarkerQuery& FMarkerQuery::WithTimeRange(const FDateTime InFrom, const FDateTime InTo)
+{
+	From = InFrom;
+	To = InTo;
+	return *this;
+}
+
+FMarkerQuery& FMarkerQuery::WithTiles(const TArray<FString>& InTiles)
+{
+	Tiles = InTiles;
+	return *this;
+}
+
+int64 FMarkerQuery::GetTimeBucket(const int64 UnixTimestamp)
+{
+	return UnixTimestamp - UnixTimestamp % TimeBucketSeconds;
+}
+
+FCompiledMarkerQuery FMarkerQuery::Compile() const
+{
+	// DynamoDB rejects BETWEEN with the bounds reversed, and nothing can match anyway
+	if (From != FDateTime::MinValue() && To != FDateTime::MaxValue() && From.ToUnixTimestamp() > To.ToUnixTimestamp())
+	{
+		return FCompiledMarkerQuery();
+	}
+
+	// the marker type is written in either case, and rows without one are static markers
+	const bool AllTypes = MarkerTypes.Num() == 0 || (MarkerTypes.Contains(ELocationMarkerType::Static) &&
+		MarkerTypes.Contains(ELocationMarkerType::Temporary) && MarkerTypes.Contains(ELocationMarkerType::Dynamic));
+	TArray<Aws::String> MarkerTypeNames;
+	for (const ELocationMarkerType MarkerType : MarkerTypes)
+	{
+		const Aws::String& MarkerName = MarkerType == ELocationMarkerType::Dynamic
+			                                ? DynamicMarkerNameAws
+			                                : MarkerType == ELocationMarkerType::Temporary
+			                                ? TemporaryMarkerNameAws
+			                                : StaticMarkerNameAws;
+		Aws::String LowerMarkerName = MarkerName;
+		for (char& Character : LowerMarkerName) Character = FCharAnsi::ToLower(Character);
+		MarkerTypeNames.AddUnique(MarkerName);
+		MarkerTypeNames.AddUnique(LowerMarkerName);
+	}
+	const auto AddTypeFilter = [&](FMarkerExpression& Expression)
+	{
+		if (AllTypes) return;
+		Aws::String Condition = Expression.In(Expression.Name("#type", MarkerTypeAttributeNameAws), MarkerTypeNames);
+		if (MarkerTypes.Contains(ELocationMarkerType::Static))
+		{
+			Condition = "attribute_not_exists(" + Expression.Name("#type", MarkerTypeAttributeNameAws) + ") OR " + Condition;
+		}
+		Expression.AddFilter(Condition);
+	};
+
+	// timestamps are stored as strings of equal length, so string comparison orders them correctly
+	const auto TimeCondition = [&](FMarkerExpression& Expression) -> Aws::String
+	{
+		const Aws::String Timestamp = Expression.Name("#ts", SortKeyAttributeNameAws);
+		if (From != FDateTime::MinValue() && To != FDateTime::MaxValue())
+		{
+			return Timestamp + " BETWEEN " + Expression.Value(AwsStringFromInt64(From.ToUnixTimestamp())) +
+				" AND " + Expression.Value(AwsStringFromInt64(To.ToUnixTimestamp()));
+		}
+		if (From != FDateTime::MinValue()) return Timestamp + " >= " + Expression.Value(AwsStringFromInt64(From.ToUnixTimestamp()));
+		return Timestamp + " <= " + Expression.Value(AwsStringFromInt64(To.ToUnixTimestamp()));
+	};
+
+	TArray<Aws::String> TileKeys;
+	TileKeys.Reserve(Tiles.Num());
+	for (const FString& Tile : Tiles)
+	{
+		// a coarser tile from FGeohash::CoverRadius() is read as the index tiles inside it
+		for (const FString& IndexTile : FGeohash::Expand(Tile, TileGeohashPrecision))
+		{
+			TileKeys.Add(FStringToAwsString(IndexTile));
+		}
+	}
+
+	// one Query per partition key value, with the time range as the sort key condition
+	FCompiledMarkerQuery Compiled;
+	const auto AddQuery = [&](const Aws::String& IndexName, const char* KeyPlaceholder, const Aws::String& KeyAttribute,
+	                          const Aws::String& KeyValue, const TFunction<void(FMarkerExpression&)>& AddFilters)
+	{
+		FMarkerExpression Expression;
+		Aws::String KeyCondition = Expression.Name(KeyPlaceholder, KeyAttribute) + " = " + Expression.Value(KeyValue);
+		if (HasTimeRange()) KeyCondition += " AND " + TimeCondition(Expression);
+		AddFilters(Expression);
+
+		Aws::DynamoDB::Model::QueryRequest Request;
+		if (!IndexName.empty()) Request.SetIndexName(IndexName);
+		Request.SetKeyConditionExpression(KeyCondition);
+		Expression.ApplyTo(Request);
+		Compiled.QueryRequests.Add(MoveTemp(Request));
+	};
+
+	if (DeviceIDs.Num() > 0)
+	{
+		for (const FString& DeviceID : DeviceIDs)
+		{
+			AddQuery("", "#pk", PartitionKeyAttributeNameAws, FStringToAwsString(DeviceID), [&](FMarkerExpression& Expression)
+			{
+				AddTypeFilter(Expression);
+				if (TileKeys.Num() > 0) Expression.AddFilter(Expression.In(Expression.Name("#tile", TileAttributeNameAws), TileKeys));
+			});
+		}
+		return Compiled;
+	}
+
+	if (TileKeys.Num() > 0)
+	{
+		for (const Aws::String& Tile : TileKeys)
+		{
+			AddQuery(TileIndexName, "#tile", TileAttributeNameAws, Tile, AddTypeFilter);
+		}
+		return Compiled;
+	}
+
+	if (From != FDateTime::MinValue())
+	{
+		const int64 FirstBucket = GetTimeBucket(From.ToUnixTimestamp());
+		const int64 LastBucket = GetTimeBucket(FMath::Min(To, FDateTime::UtcNow()).ToUnixTimestamp());
+		if ((LastBucket - FirstBucket) / TimeBucketSeconds < MaxTimeBuckets)
+		{
+			for (int64 Bucket = FirstBucket; Bucket <= LastBucket; Bucket += TimeBucketSeconds)
+			{
+				AddQuery(TimeIndexName, "#bucket", TimeBucketAttributeNameAws, AwsStringFromInt64(Bucket), AddTypeFilter);
+			}
+			return Compiled;
+		}
+	}
+
+	FMarkerExpression Expression;
+	AddTypeFilter(Expression);
+	if (HasTimeRange()) Expression.AddFilter(TimeCondition(Expression));
+	Expression.ApplyTo(Compiled.ScanRequest);
+	Compiled.UseScan = true;
+	return Compiled;
+}
@@ -0,0 +1,92 @@
+#include "MarkerReconcile.h"
+
+#include "Algo/BinarySearch.h"
+
+namespace
+{
+	// About a millimeter in degrees, and a millimeter in UE units without a georeference
+	constexpr double Wgs84Tolerance = 1.0e-8;
+	constexpr double UnrealTolerance = 0.1;
+
+	bool IsSameLocation(const FLocationTs& A, const FLocationTs& B)
+	{
+		if (A.Timestamp != B.Timestamp || !A.Wgs84Coordinate.Equals(B.Wgs84Coordinate, Wgs84Tolerance)) return false;
+		// without a georeference the UE coordinate holds the row's coordinates, and re-anchoring never moves it
+		return !A.EcefCoordinate.IsZero() || A.UECoordinate.Equals(B.UECoordinate, UnrealTolerance);
+	}
+}
+
+FMarkerReconcilePlan FMarkerReconcilePlan::Diff(const TArray<FMarkerRecordBatch>& Database,
+                                                const TMap<FString, FSpawnedMarkerState>& Spawned,
+                                                const bool StaticMarkersOnly, const FDateTime ReadStartedAt,
+                                                const float TemporaryLifeSpan, const float DynamicLifeSpan)
+{
+	FMarkerReconcilePlan Plan;
+	const FTimespan TemporaryExpiry = FTimespan::FromSeconds(TemporaryLifeSpan);
+	const FTimespan DynamicExpiry = FTimespan::FromSeconds(DynamicLifeSpan);
+	TSet<FString> Seen;
+	Seen.Reserve(Database.Num());
+
+	for (const FMarkerRecordBatch& Batch : Database)
+	{
+		if (Batch.Locations.Num() == 0) continue;
+		Seen.Add(Batch.DeviceID);
+		const FSpawnedMarkerState* Existing = Spawned.Find(Batch.DeviceID);
+
+		if (Existing != nullptr && Existing->MarkerType != Batch.MarkerType)
+		{
+			// a device that changed type gets a new marker of the right class
+			Plan.Removed.Add(Batch.DeviceID);
+			Existing = nullptr;
+		}
+
+		if (Existing == nullptr)
+		{
+			// a marker that would have expired by now is not brought back
+			const FDateTime Newest = Batch.Locations.Last().Timestamp;
+			const bool Expired =
+				(Batch.MarkerType == ELocationMarkerType::Temporary && Newest + TemporaryExpiry < ReadStartedAt) ||
+				(Batch.MarkerType == ELocationMarkerType::Dynamic && Newest + DynamicExpiry < ReadStartedAt);
+			if (Expired) continue;
+			Plan.Added.Add(Batch);
+			continue;
+		}
+
+		if (Batch.MarkerType == ELocationMarkerType::Dynamic)
+		{
+			// Locations is sorted, so the new ones are a suffix
+			const int32 First = Algo::UpperBoundBy(Batch.Locations, Existing->LatestTimestamp,
+			                                       [](const FLocationTs& Location) { return Location.Timestamp; });
+			if (First == Batch.Locations.Num())
+			{
+				Plan.Unchanged++;
+				continue;
+			}
+			FMarkerRecordBatch& Update = Plan.Updated.AddDefaulted_GetRef();
+			Update.DeviceID = Batch.DeviceID;
+			Update.MarkerType = Batch.MarkerType;
+			Update.Locations.Append(Batch.Locations.GetData() + First, Batch.Locations.Num() - First);
+			continue;
+		}
+
+		// static and temporary markers are placed at their oldest row
+		if (IsSameLocation(Existing->LocationTs, Batch.Locations[0]))
+		{
+			Plan.Unchanged++;
+			continue;
+		}
+		FMarkerRecordBatch& Update = Plan.Updated.AddDefaulted_GetRef();
+		Update.DeviceID = Batch.DeviceID;
+		Update.MarkerType = Batch.MarkerType;
+		Update.Locations.Add(Batch.Locations[0]);
+	}
+
+	for (const TPair<FString, FSpawnedMarkerState>& Pair : Spawned)
+	{
+		if (Seen.Contains(Pair.Key)) continue;
+		if (StaticMarkersOnly && Pair.Value.MarkerType != ELocationMarkerType::Static) continue;
+		if (Pair.Value.LatestTimestamp >= ReadStartedAt) continue;
+		Plan.Removed.Add(Pair.Key);
+	}
+	return Plan;
+}
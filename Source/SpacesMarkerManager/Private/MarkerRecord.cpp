@@ -0,0 +1,62 @@
+#include "MarkerRecord.h"
+
+#include "AwsStringUtils.h"
+#include "Settings.h"
+
+TArray<FMarkerRecordBatch> FMarkerRecordBatch::Coalesce(const TArray<FMarkerRecord>& Records)
+{
+	TArray<FMarkerRecordBatch> Batches;
+	TMap<Aws::String, int32> BatchIndexByDevice;
+	BatchIndexByDevice.Reserve(Records.Num());
+
+	for (const FMarkerRecord& Record : Records)
+	{
+		int32 Index;
+		if (const int32* Existing = BatchIndexByDevice.Find(Record.DeviceID))
+		{
+			Index = *Existing;
+		}
+		else
+		{
+			Index = Batches.AddDefaulted();
+			Batches[Index].DeviceID = AwsStringToFString(Record.DeviceID);
+			Batches[Index].MarkerType = Record.MarkerType;
+			BatchIndexByDevice.Add(Record.DeviceID, Index);
+		}
+		Batches[Index].Locations.Add(Record.LocationTs);
+	}
+
+	for (FMarkerRecordBatch& Batch : Batches)
+	{
+		Batch.Locations.StableSort();
+	}
+	return Batches;
+}
+
+ELocationMarkerType FRawMarkerRecord::ParseMarkerType(const Aws::String& MarkerTypeName)
+{
+	if (AwsStringEqualsIgnoreCase(MarkerTypeName, DynamicMarkerNameAws)) return ELocationMarkerType::Dynamic;
+	if (AwsStringEqualsIgnoreCase(MarkerTypeName, TemporaryMarkerNameAws)) return ELocationMarkerType::Temporary;
+	return ELocationMarkerType::Static;
+}
+
+bool FRawMarkerRecord::FromStreamRecord(const Aws::DynamoDBStreams::Model::StreamRecord& StreamRecord, FRawMarkerRecord& OutRecord)
+{
+	const Aws::Map<Aws::String, Aws::DynamoDBStreams::Model::AttributeValue>& NewImage = StreamRecord.GetNewImage();
+	const auto DeviceIDValue = NewImage.find(PartitionKeyAttributeNameAws);
+	const auto TimestampValue = NewImage.find(SortKeyAttributeNameAws);
+	if (DeviceIDValue == NewImage.end() || TimestampValue == NewImage.end()) return false;
+
+	const auto MarkerTypeValue = NewImage.find(MarkerTypeAttributeNameAws);
+	OutRecord.MarkerType = MarkerTypeValue == NewImage.end() ? ELocationMarkerType::Static : ParseMarkerType(MarkerTypeValue->second.GetS());
+	OutRecord.DeviceID = DeviceIDValue->second.GetS();
+	OutRecord.Timestamp = FDateTime::FromUnixTimestamp(AwsStringToInt64(TimestampValue->second.GetS()));
+
+	const auto LonValue = NewImage.find(PositionXAttributeNameAws);
+	const auto LatValue = NewImage.find(PositionYAttributeNameAws);
+	const auto ElevValue = NewImage.find(PositionZAttributeNameAws);
+	OutRecord.Lon = LonValue == NewImage.end() ? 0.0 : AwsStringToDouble(LonValue->second.GetN());
+	OutRecord.Lat = LatValue == NewImage.end() ? 0.0 : AwsStringToDouble(LatValue->second.GetN());
+	OutRecord.Elev = ElevValue == NewImage.end() ? 0.0 : AwsStringToDouble(ElevValue->second.GetN());
+	return true;
+}
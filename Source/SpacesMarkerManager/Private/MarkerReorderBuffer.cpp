@@ -0,0 +1,131 @@
+#include "MarkerReorderBuffer.h"
+
+#include "Algo/BinarySearch.h"
+
+void FMarkerReorderBuffer::Add(TArray<FMarkerRecordBatch>&& Batches, const double Now, TArray<FMarkerRecordBatch>& OutLate)
+{
+	for (FMarkerRecordBatch& Batch : Batches)
+	{
+		FDevice& Device = Devices.FindOrAdd(Batch.DeviceID);
+		Device.MarkerType = Batch.MarkerType;
+		Device.LastArrivedAt = Now;
+
+		FMarkerRecordBatch* Late = nullptr;
+		for (const FLocationTs& Location : Batch.Locations)
+		{
+			if (Location.Timestamp <= Device.NewestReleased)
+			{
+				if (Late == nullptr)
+				{
+					Late = &OutLate.AddDefaulted_GetRef();
+					Late->DeviceID = Batch.DeviceID;
+					Late->MarkerType = Batch.MarkerType;
+				}
+				Late->Locations.Add(Location);
+				LateCount++;
+				continue;
+			}
+
+			FHeldSample Sample;
+			Sample.Location = Location;
+			Sample.ArrivedAt = Now;
+			if (Device.Held.Num() == 0 || Device.Held.Last().Location < Location)
+			{
+				Device.Held.Add(MoveTemp(Sample));
+			}
+			else
+			{
+				const int32 Index = Algo::LowerBoundBy(Device.Held, Location.Timestamp,
+				                                       [](const FHeldSample& Held) { return Held.Location.Timestamp; });
+				if (Device.Held[Index].Location.Timestamp == Location.Timestamp) continue;
+				Device.Held.Insert(MoveTemp(Sample), Index);
+			}
+			HeldCount++;
+			if (Device.NewestSeen < Location.Timestamp) Device.NewestSeen = Location.Timestamp;
+		}
+		if (Device.Held.Num() > 0) HoldingDevices.Add(Batch.DeviceID);
+	}
+}
+
+void FMarkerReorderBuffer::Release(const double Now, TArray<FMarkerRecordBatch>& OutBatches)
+{
+	const FTimespan Lateness = FTimespan::FromSeconds(LatenessSeconds);
+	for (auto It = HoldingDevices.CreateIterator(); It; ++It)
+	{
+		FDevice& Device = Devices[*It];
+		const FDateTime Watermark = Device.NewestSeen - Lateness;
+
+		// the newest sample that may go; everything before it goes too, to keep the order
+		int32 Count = 0;
+		for (int32 i = Device.Held.Num() - 1; i >= 0; i--)
+		{
+			const FHeldSample& Sample = Device.Held[i];
+			if (Sample.Location.Timestamp <= Watermark || Now - Sample.ArrivedAt >= LatenessSeconds)
+			{
+				Count = i + 1;
+				break;
+			}
+		}
+		if (Count == 0) continue;
+		ReleaseHeld(*It, Device, Count, OutBatches);
+		if (Device.Held.Num() == 0) It.RemoveCurrent();
+	}
+	PruneIdle(Now);
+}
+
+void FMarkerReorderBuffer::PruneIdle(const double Now)
+{
+	// a sweep visits every known device, so run it at most once per lateness window
+	if (Devices.Num() == HoldingDevices.Num() || Now - LastPruneTime < FMath::Max(LatenessSeconds, 1.0)) return;
+	LastPruneTime = Now;
+	for (auto It = Devices.CreateIterator(); It; ++It)
+	{
+		// a sample arriving after this is held again instead of counted late, and merged by the sorted insert all the same
+		if (It.Value().Held.Num() == 0 && Now - It.Value().LastArrivedAt > LatenessSeconds) It.RemoveCurrent();
+	}
+}
+
+void FMarkerReorderBuffer::Flush(TArray<FMarkerRecordBatch>& OutBatches)
+{
+	for (const FString& DeviceID : HoldingDevices)
+	{
+		FDevice& Device = Devices[DeviceID];
+		ReleaseHeld(DeviceID, Device, Device.Held.Num(), OutBatches);
+	}
+	HoldingDevices.Reset();
+}
+
+void FMarkerReorderBuffer::Reanchor(const FMatrix& EcefToUnreal)
+{
+	for (const FString& DeviceID : HoldingDevices)
+	{
+		for (FHeldSample& Sample : Devices[DeviceID].Held)
+		{
+			Sample.Location.UECoordinate = EcefToUnreal.TransformPosition(Sample.Location.EcefCoordinate);
+		}
+	}
+}
+
+void FMarkerReorderBuffer::Remove(const FString& DeviceID)
+{
+	FDevice Device;
+	if (!Devices.RemoveAndCopyValue(DeviceID, Device)) return;
+	HeldCount -= Device.Held.Num();
+	HoldingDevices.Remove(DeviceID);
+}
+
+void FMarkerReorderBuffer::ReleaseHeld(const FString& DeviceID, FDevice& Device, const int32 Count,
+                                       TArray<FMarkerRecordBatch>& OutBatches)
+{
+	FMarkerRecordBatch& Batch = OutBatches.AddDefaulted_GetRef();
+	Batch.DeviceID = DeviceID;
+	Batch.MarkerType = Device.MarkerType;
+	Batch.Locations.Reserve(Count);
+	for (int32 i = 0; i < Count; i++)
+	{
+		Batch.Locations.Add(MoveTemp(Device.Held[i].Location));
+	}
+	Device.Held.RemoveAt(0, Count, false);
+	Device.NewestReleased = Batch.Locations.Last().Timestamp;
+	HeldCount -= Count;
+}
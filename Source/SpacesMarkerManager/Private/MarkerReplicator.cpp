@@ -0,0 +1,289 @@
+#include "MarkerReplicator.h"
+
+#include "MarkerManager.h"
+#include "GameFramework/PlayerController.h"
+#include "Net/UnrealNetwork.h"
+
+void FReplicatedMarker::PreReplicatedRemove(const FReplicatedMarkerList& InArraySerializer)
+{
+	if (InArraySerializer.Owner != nullptr) InArraySerializer.Owner->OnMarkerRemoved(*this);
+}
+
+void FReplicatedMarker::PostReplicatedAdd(const FReplicatedMarkerList& InArraySerializer)
+{
+	if (InArraySerializer.Owner != nullptr) InArraySerializer.Owner->OnMarkerReplicated(*this);
+}
+
+void FReplicatedMarker::PostReplicatedChange(const FReplicatedMarkerList& InArraySerializer)
+{
+	if (InArraySerializer.Owner != nullptr) InArraySerializer.Owner->OnMarkerReplicated(*this);
+}
+
+AMarkerReplicator::AMarkerReplicator()
+{
+	// ticks on the server only, at the net update rate
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	PrimaryActorTick.TickInterval = 0.1f;
+	bReplicates = true;
+	bOnlyRelevantToOwner = true;
+	NetUpdateFrequency = 10.0f;
+	Markers.Owner = this;
+	// send only the properties of an item that changed, rather than the whole item
+	Markers.SetDeltaSerializationEnabled(true);
+	Clusters.SetDeltaSerializationEnabled(true);
+}
+
+void AMarkerReplicator::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(AMarkerReplicator, Markers);
+	DOREPLIFETIME(AMarkerReplicator, Clusters);
+}
+
+void AMarkerReplicator::BeginPlay()
+{
+	Super::BeginPlay();
+	Markers.Owner = this;
+	if (HasAuthority()) SetActorTickEnabled(true);
+	if (UMarkerManager* MarkerManager = GetMarkerManager())
+	{
+		MarkerManager->RegisterMarkerReplicator(this);
+	}
+}
+
+void AMarkerReplicator::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UMarkerManager* MarkerManager = GetMarkerManager())
+	{
+		MarkerManager->UnregisterMarkerReplicator(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+UMarkerManager* AMarkerReplicator::GetMarkerManager() const
+{
+	return Cast<UMarkerManager>(GetGameInstance());
+}
+
+bool AMarkerReplicator::GetViewLocation(FVector& OutLocation) const
+{
+	// the owning client sends its camera to the server, see APlayerController::ServerUpdateCamera()
+	const APlayerController* PlayerController = Cast<APlayerController>(GetOwner());
+	if (PlayerController == nullptr) return false;
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(OutLocation, ViewRotation);
+	return true;
+}
+
+void AMarkerReplicator::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	const UMarkerManager* MarkerManager = GetMarkerManager();
+	FVector ViewLocation;
+	if (MarkerManager == nullptr || !GetViewLocation(ViewLocation)) return;
+
+	const FMarkerInterestGrid& Grid = MarkerManager->GetInterestGrid();
+	const int32 NearRadius = MarkerManager->InterestNearRadiusCells;
+	const int32 MidRadius = FMath::Max(MarkerManager->InterestMidRadiusCells, NearRadius);
+	const FIntVector NewViewCell = Grid.GetCell(ViewLocation);
+	if (!HasViewCell || NewViewCell != ViewCell)
+	{
+		ViewCell = NewViewCell;
+		HasViewCell = true;
+		DropDetailedCellsOutOfRange(MidRadius);
+		// cells that became detailed should lose their cluster right away
+		LastClusterSyncTime = -1.0e9;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 Z = -MidRadius; Z <= MidRadius; Z++)
+	{
+		for (int32 Y = -MidRadius; Y <= MidRadius; Y++)
+		{
+			for (int32 X = -MidRadius; X <= MidRadius; X++)
+			{
+				const FIntVector Cell = ViewCell + FIntVector(X, Y, Z);
+				if (FMath::Max3(FMath::Abs(X), FMath::Abs(Y), FMath::Abs(Z)) > NearRadius)
+				{
+					const double* LastSync = LastCellSyncTime.Find(Cell);
+					if (LastSync != nullptr && Now - *LastSync < MarkerManager->InterestMidUpdateInterval) continue;
+				}
+				LastCellSyncTime.Add(Cell, Now);
+				SyncDetailedCell(Grid, Cell, MidRadius);
+			}
+		}
+	}
+
+	if (Now - LastClusterSyncTime >= MarkerManager->InterestFarUpdateInterval)
+	{
+		LastClusterSyncTime = Now;
+		SyncClusters(Grid, MidRadius);
+	}
+}
+
+void AMarkerReplicator::SyncDetailedCell(const FMarkerInterestGrid& Grid, const FIntVector& Cell, const int32 MidRadius)
+{
+	const FMarkerInterestGrid::FCell* GridCell = Grid.FindCell(Cell);
+	const uint64* SyncedVersion = SyncedCellVersion.Find(Cell);
+	if (GridCell == nullptr && !DetailedCellDevices.Contains(Cell)) return;
+	if (GridCell != nullptr && SyncedVersion != nullptr && *SyncedVersion == GridCell->Version) return;
+
+	// devices that left the cell are removed, unless they moved to another detailed cell
+	TArray<FString> Moved;
+	if (TSet<FString>* Sent = DetailedCellDevices.Find(Cell))
+	{
+		for (auto It = Sent->CreateIterator(); It; ++It)
+		{
+			if (GridCell != nullptr && GridCell->DeviceIDs.Contains(*It)) continue;
+			const FMarkerInterestGrid::FDevice* Device = Grid.FindDevice(*It);
+			if (Device != nullptr && FMarkerInterestGrid::GetCellDistance(Device->Cell, ViewCell) <= MidRadius) Moved.Add(*It);
+			else RemoveItem(*It);
+			It.RemoveCurrent();
+		}
+	}
+	for (const FString& DeviceID : Moved)
+	{
+		const FMarkerInterestGrid::FDevice& Device = *Grid.FindDevice(DeviceID);
+		DetailedCellDevices.FindOrAdd(Device.Cell).Add(DeviceID);
+		UpsertItem(DeviceID, Device);
+	}
+
+	if (GridCell == nullptr)
+	{
+		DetailedCellDevices.Remove(Cell);
+		SyncedCellVersion.Remove(Cell);
+		return;
+	}
+
+	TSet<FString>& Sent = DetailedCellDevices.FindOrAdd(Cell);
+	for (const FString& DeviceID : GridCell->DeviceIDs)
+	{
+		const FMarkerInterestGrid::FDevice& Device = *Grid.FindDevice(DeviceID);
+		if (SyncedVersion != nullptr && Device.Version <= *SyncedVersion && Sent.Contains(DeviceID)) continue;
+		UpsertItem(DeviceID, Device);
+		Sent.Add(DeviceID);
+	}
+	SyncedCellVersion.Add(Cell, GridCell->Version);
+}
+
+void AMarkerReplicator::DropDetailedCellsOutOfRange(const int32 MidRadius)
+{
+	for (auto It = DetailedCellDevices.CreateIterator(); It; ++It)
+	{
+		if (FMarkerInterestGrid::GetCellDistance(It.Key(), ViewCell) <= MidRadius) continue;
+		for (const FString& DeviceID : It.Value())
+		{
+			RemoveItem(DeviceID);
+		}
+		SyncedCellVersion.Remove(It.Key());
+		It.RemoveCurrent();
+	}
+	for (auto It = LastCellSyncTime.CreateIterator(); It; ++It)
+	{
+		if (FMarkerInterestGrid::GetCellDistance(It.Key(), ViewCell) > MidRadius) It.RemoveCurrent();
+	}
+}
+
+void AMarkerReplicator::SyncClusters(const FMarkerInterestGrid& Grid, const int32 MidRadius)
+{
+	bool Removed = false;
+	for (auto It = ClusterIndex.CreateIterator(); It; ++It)
+	{
+		if (Grid.FindCell(It.Key()) != nullptr && FMarkerInterestGrid::GetCellDistance(It.Key(), ViewCell) > MidRadius) continue;
+		SyncedClusterVersion.Remove(It.Key());
+		It.RemoveCurrent();
+		Removed = true;
+	}
+	if (Removed)
+	{
+		// rebuild the list without the removed cells
+		Clusters.Items.RemoveAll([this](const FReplicatedMarkerCluster& Cluster) { return !ClusterIndex.Contains(Cluster.Cell); });
+		for (int32 i = 0; i < Clusters.Items.Num(); i++)
+		{
+			ClusterIndex.Add(Clusters.Items[i].Cell, i);
+		}
+		Clusters.MarkArrayDirty();
+	}
+
+	for (const TPair<FIntVector, FMarkerInterestGrid::FCell>& Pair : Grid.GetCells())
+	{
+		if (FMarkerInterestGrid::GetCellDistance(Pair.Key, ViewCell) <= MidRadius) continue;
+		const uint64* SyncedVersion = SyncedClusterVersion.Find(Pair.Key);
+		if (SyncedVersion != nullptr && *SyncedVersion == Pair.Value.Version) continue;
+		SyncedClusterVersion.Add(Pair.Key, Pair.Value.Version);
+
+		FReplicatedMarkerCluster* Cluster;
+		if (const int32* Index = ClusterIndex.Find(Pair.Key))
+		{
+			Cluster = &Clusters.Items[*Index];
+		}
+		else
+		{
+			ClusterIndex.Add(Pair.Key, Clusters.Items.Num());
+			Cluster = &Clusters.Items.AddDefaulted_GetRef();
+			Cluster->Cell = Pair.Key;
+		}
+		Cluster->Count = Pair.Value.DeviceIDs.Num();
+		Cluster->Centroid = Pair.Value.GetCentroid();
+		Clusters.MarkItemDirty(*Cluster);
+	}
+}
+
+void AMarkerReplicator::UpsertItem(const FString& DeviceID, const FMarkerInterestGrid::FDevice& Device)
+{
+	FReplicatedMarker* Item;
+	if (const int32* Index = ItemIndex.Find(DeviceID))
+	{
+		Item = &Markers.Items[*Index];
+	}
+	else
+	{
+		ItemIndex.Add(DeviceID, Markers.Items.Num());
+		Item = &Markers.Items.AddDefaulted_GetRef();
+		Item->DeviceID = DeviceID;
+	}
+	Item->MarkerType = Device.MarkerType;
+	Item->Location = Device.LocationTs.UECoordinate;
+	Item->Timestamp = Device.LocationTs.Timestamp.ToUnixTimestamp();
+	Markers.MarkItemDirty(*Item);
+}
+
+void AMarkerReplicator::RemoveItem(const FString& DeviceID)
+{
+	int32 Index;
+	if (!ItemIndex.RemoveAndCopyValue(DeviceID, Index)) return;
+	Markers.Items.RemoveAtSwap(Index, 1, false);
+	if (Index < Markers.Items.Num())
+	{
+		ItemIndex.Add(Markers.Items[Index].DeviceID, Index);
+	}
+	Markers.MarkArrayDirty();
+}
+
+int AMarkerReplicator::GetReplicatedMarkerCount() const
+{
+	return Markers.Items.Num();
+}
+
+TArray<FReplicatedMarkerCluster> AMarkerReplicator::GetClusters() const
+{
+	return Clusters.Items;
+}
+
+void AMarkerReplicator::OnMarkerReplicated(const FReplicatedMarker& Item) const
+{
+	if (UMarkerManager* MarkerManager = GetMarkerManager())
+	{
+		MarkerManager->ApplyReplicatedMarker(Item.DeviceID, Item.MarkerType,
+		                                     MarkerManager->WrapUnrealLocationTs(FDateTime::FromUnixTimestamp(Item.Timestamp), Item.Location));
+	}
+}
+
+void AMarkerReplicator::OnMarkerRemoved(const FReplicatedMarker& Item) const
+{
+	if (UMarkerManager* MarkerManager = GetMarkerManager())
+	{
+		MarkerManager->RemoveReplicatedMarker(Item.DeviceID);
+	}
+}
@@ -0,0 +1,683 @@
+#include "MarkerSoakCommandlet.h"
+
+#include "MarkerManager.h"
+#include "MarkerRecord.h"
+#include "Settings.h"
+#include "StreamDeduplicator.h"
+#include "Async/Async.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "aws/core/Aws.h"
+#include "aws/core/auth/AWSCredentials.h"
+#include "aws/core/client/ClientConfiguration.h"
+#include "aws/core/utils/memory/MemorySystemInterface.h"
+#include "aws/dynamodb/DynamoDBClient.h"
+#include "aws/dynamodb/model/BatchWriteItemRequest.h"
+#include "aws/dynamodb/model/PutRequest.h"
+#include "aws/dynamodb/model/WriteRequest.h"
+#include "aws/dynamodbstreams/model/Record.h"
+
+DEFINE_LOG_CATEGORY(LogMarkerSoak);
+
+namespace
+{
+	// BatchWriteItem accepts at most this many items per request
+	constexpr int32 MaxBatchWriteItems = 25;
+	constexpr int32 MaxWriteAttempts = 5;
+	// Give up if the SDK is not up by then
+	constexpr double AwsStartupTimeout = 120.0;
+
+	/* Counts of values in fixed width buckets, for percentiles without keeping every sample */
+	class FSoakHistogram
+	{
+	public:
+		FSoakHistogram(const double InBucketWidth, const int32 NumBuckets)
+			: BucketWidth(InBucketWidth)
+		{
+			Buckets.SetNumZeroed(NumBuckets);
+		}
+
+		void Add(const double Value)
+		{
+			Buckets[FMath::Clamp(static_cast<int32>(Value / BucketWidth), 0, Buckets.Num() - 1)]++;
+			Count++;
+			Sum += Value;
+			Max = FMath::Max(Max, Value);
+		}
+
+		/* Upper edge of the bucket holding the P-th percentile, P in [0, 1] */
+		double Percentile(const double P) const
+		{
+			if (Count == 0) return 0.0;
+			const int64 Rank = FMath::Max<int64>(1, static_cast<int64>(FMath::CeilToDouble(P * Count)));
+			int64 Seen = 0;
+			for (int32 i = 0; i < Buckets.Num(); i++)
+			{
+				Seen += Buckets[i];
+				if (Seen >= Rank) return FMath::Min((i + 1) * BucketWidth, Max);
+			}
+			return Max;
+		}
+
+		double Mean() const { return Count > 0 ? Sum / Count : 0.0; }
+
+		void Reset()
+		{
+			FMemory::Memzero(Buckets.GetData(), Buckets.Num() * sizeof(int64));
+			Count = 0;
+			Sum = 0.0;
+			Max = 0.0;
+		}
+
+		int64 Count = 0;
+		double Sum = 0.0;
+		double Max = 0.0;
+
+	private:
+		double BucketWidth;
+		TArray<int64> Buckets;
+	};
+
+	struct FSoakOptions
+	{
+		int32 Devices = 100;
+		double Rate = 1.0;
+		double Duration = 60.0;
+		int32 Writers = 4;
+		double FrameRate = 60.0;
+		double ReportInterval = 5.0;
+		double Warmup = 5.0;
+		double Drain = 30.0;
+		double PollingInterval = 1.0;
+		bool Listen = false;
+		FString CsvPath;
+		int32 Allocations = 0;
+	};
+
+	/*
+	 * Counts the heap allocations made on one thread, in front of GMalloc.
+	 * Realloc counts as an allocation unless it frees, since growing a container goes through it.
+	 */
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* InInner)
+			: Inner(InInner)
+		{
+		}
+
+		void Begin()
+		{
+			CountingThreadId = FPlatformTLS::GetCurrentThreadId();
+			Count = 0;
+			Counting = true;
+		}
+
+		int64 End()
+		{
+			Counting = false;
+			return Count;
+		}
+
+		virtual void* Malloc(SIZE_T Size, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Size, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Size, uint32 Alignment) override
+		{
+			if (Size > 0) CountAllocation();
+			return Inner->Realloc(Original, Size, Alignment);
+		}
+
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual SIZE_T QuantizeSize(SIZE_T Size, uint32 Alignment) override { return Inner->QuantizeSize(Size, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+	private:
+		void CountAllocation()
+		{
+			if (Counting && FPlatformTLS::GetCurrentThreadId() == CountingThreadId) Count++;
+		}
+
+		FMalloc* Inner;
+		TAtomic<bool> Counting{false};
+		uint32 CountingThreadId = 0;
+		int64 Count = 0;
+	};
+
+	/* Routes the AWS SDK's allocations through FMemory, so FCountingMalloc sees them as well */
+	class FUnrealAwsMemorySystem final : public Aws::Utils::Memory::MemorySystemInterface
+	{
+	public:
+		virtual void Begin() override
+		{
+		}
+
+		virtual void End() override
+		{
+		}
+
+		virtual void* AllocateMemory(std::size_t BlockSize, std::size_t Alignment, const char* AllocationTag) override
+		{
+			return FMemory::Malloc(BlockSize, static_cast<uint32>(Alignment));
+		}
+
+		virtual void FreeMemory(void* MemoryPtr) override
+		{
+			FMemory::Free(MemoryPtr);
+		}
+	};
+
+	/* An INSERT stream record with the attributes CreateMarkerInDB() writes */
+	Aws::DynamoDBStreams::Model::Record MakeInsertRecord(const Aws::String& DeviceID, const int64 UnixTimestamp, const int64 Sequence)
+	{
+		char Buffer[32];
+		FCStringAnsi::Snprintf(Buffer, sizeof(Buffer), "%021lld", Sequence);
+		const Aws::String SequenceNumber(Buffer);
+		const auto S = [](const Aws::String& Value) { return Aws::DynamoDBStreams::Model::AttributeValue().WithS(Value); };
+		const auto N = [](const Aws::String& Value) { return Aws::DynamoDBStreams::Model::AttributeValue().WithN(Value); };
+
+		Aws::Map<Aws::String, Aws::DynamoDBStreams::Model::AttributeValue> Image;
+		Image.emplace(PartitionKeyAttributeNameAws, S(DeviceID));
+		Image.emplace(SortKeyAttributeNameAws, S(AwsStringFromInt64(UnixTimestamp)));
+		Image.emplace(PositionXAttributeNameAws, N("153.02809524536133"));
+		Image.emplace(PositionYAttributeNameAws, N("-27.46794319152832"));
+		Image.emplace(PositionZAttributeNameAws, N("25.5"));
+		Image.emplace(MarkerTypeAttributeNameAws, S(DynamicMarkerNameAws));
+		Image.emplace(TimeBucketAttributeNameAws, S(AwsStringFromInt64(UnixTimestamp - UnixTimestamp % TimeBucketSeconds)));
+		Image.emplace(TileAttributeNameAws, S("r7hg"));
+
+		Aws::DynamoDBStreams::Model::StreamRecord StreamRecord;
+		StreamRecord.SetSequenceNumber(SequenceNumber);
+		StreamRecord.SetApproximateCreationDateTime(Aws::Utils::DateTime(UnixTimestamp * 1000));
+		StreamRecord.SetNewImage(MoveTemp(Image));
+		Aws::DynamoDBStreams::Model::Record Record;
+		Record.SetEventName(Aws::DynamoDBStreams::Model::OperationType::INSERT);
+		Record.SetDynamodb(MoveTemp(StreamRecord));
+		return Record;
+	}
+
+	/**
+	 * Count the heap allocations per record on the stream ingestion path, with pages of synthetic INSERT records
+	 * for Options.Devices devices with 36 character IDs. Runs the same steps as
+	 * UMarkerManager::ProcessDynamoDBStreamRecords(), each counted on its own, and for comparison the record copy and
+	 * Record::Jsonize() the decoder used to go through. Needs no DynamoDB.
+	 * @returns 0, or 1 if the AWS SDK's allocations could not be counted.
+	 **/
+	int32 RunAllocationCount(const FSoakOptions& Options)
+	{
+		// GetRecords returns at most this many records per page
+		constexpr int32 PageSize = 1000;
+		FCountingMalloc* Counter = new FCountingMalloc(GMalloc);
+		FUnrealAwsMemorySystem MemorySystem;
+		Aws::SDKOptions SdkOptions;
+		SdkOptions.memoryManagementOptions.memoryManager = &MemorySystem;
+		Aws::InitAPI(SdkOptions);
+		// not restored: blocks allocated through the counter may be freed through GMalloc at any time after
+		GMalloc = Counter;
+
+		int32 Result = 0;
+		{
+			// an SDK built without custom memory management allocates with malloc, out of the counter's sight
+			Counter->Begin();
+			{
+				const Aws::String Probe(64, 'x');
+			}
+			if (Counter->End() == 0)
+			{
+				UE_LOG(LogMarkerSoak, Error, TEXT("The AWS SDK was built without custom memory management; its allocations cannot be counted"));
+				Result = 1;
+			}
+
+			UMarkerManager* Manager = NewObject<UMarkerManager>(GEngine);
+			Manager->AddToRoot();
+			const int64 BaseUnixTimestamp = FDateTime::UtcNow().ToUnixTimestamp();
+			TArray<Aws::String> DeviceIDs;
+			for (int32 i = 0; i < Options.Devices; i++)
+			{
+				DeviceIDs.Add(FStringToAwsString(FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphens).ToLower()));
+			}
+
+			FStreamDeduplicator Deduplicator;
+			FShardSequenceDeduplicator& ShardDeduplicator = Deduplicator.GetShard("shardId-00000000000000000000-00000000");
+			ShardDeduplicator.BeginRun();
+			int64 Records = 0, Pages = 0, Batches = 0;
+			int64 Deduplicate = 0, Decode = 0, Wrap = 0, Coalesce = 0, Jsonize = 0;
+			while (Records < Options.Allocations)
+			{
+				const int32 Count = static_cast<int32>(FMath::Min<int64>(PageSize, Options.Allocations - Records));
+				Aws::Vector<Aws::DynamoDBStreams::Model::Record> Page;
+				Page.reserve(Count);
+				for (int32 i = 0; i < Count; i++)
+				{
+					const int64 Index = Records + i;
+					Page.push_back(MakeInsertRecord(DeviceIDs[Index % DeviceIDs.Num()], BaseUnixTimestamp + Index / DeviceIDs.Num(), Index + 1));
+				}
+
+				// the same steps as ProcessDynamoDBStreamRecords(), without the queues behind it
+				TArray<FMarkerRecord> Decoded;
+				Decoded.Reserve(Count);
+				FRawMarkerRecord RawRecord;
+				for (const Aws::DynamoDBStreams::Model::Record& Record : Page)
+				{
+					const Aws::DynamoDBStreams::Model::StreamRecord& StreamRecord = Record.GetDynamodb();
+					Counter->Begin();
+					ShardDeduplicator.Accept(StreamRecord.GetSequenceNumber());
+					Deduplicate += Counter->End();
+
+					Counter->Begin();
+					FRawMarkerRecord::FromStreamRecord(StreamRecord, RawRecord);
+					Decode += Counter->End();
+
+					Counter->Begin();
+					Decoded.Emplace(RawRecord.DeviceID, RawRecord.MarkerType,
+					                Manager->WrapLocationTs(RawRecord.Timestamp, RawRecord.Lon, RawRecord.Lat, RawRecord.Elev));
+					Wrap += Counter->End();
+
+					Counter->Begin();
+					{
+						const Aws::DynamoDBStreams::Model::Record Copy = Record;
+						const Aws::Utils::Json::JsonValue Json = Copy.Jsonize();
+					}
+					Jsonize += Counter->End();
+				}
+				Counter->Begin();
+				Batches += FMarkerRecordBatch::Coalesce(Decoded).Num();
+				Coalesce += Counter->End();
+
+				Records += Count;
+				Pages++;
+			}
+
+			const double PerRecord = 1.0 / FMath::Max<int64>(Records, 1);
+			UE_LOG(LogMarkerSoak, Display, TEXT("Heap allocations per record, %lld records in %lld pages of %d devices (%lld batches):"),
+			       Records, Pages, DeviceIDs.Num(), Batches);
+			UE_LOG(LogMarkerSoak, Display, TEXT("  deduplicate %.2f, decode %.2f, wrap %.2f, coalesce %.2f, total %.2f"),
+			       Deduplicate * PerRecord, Decode * PerRecord, Wrap * PerRecord, Coalesce * PerRecord,
+			       (Deduplicate + Decode + Wrap + Coalesce) * PerRecord);
+			UE_LOG(LogMarkerSoak, Display, TEXT("  record copy and Jsonize(), no longer on the path: %.2f"), Jsonize * PerRecord);
+			Manager->RemoveFromRoot();
+		}
+		Aws::ShutdownAPI(SdkOptions);
+		return Result;
+	}
+
+	/* Records written and not yet applied, shared by the writer threads and the game thread */
+	struct FSoakLedger
+	{
+		FCriticalSection Lock;
+		// Record key -> FPlatformTime::Seconds() when its write was sent
+		TMap<FString, double> Outstanding;
+		TAtomic<int64> Written{0};
+		TAtomic<int64> Failed{0};
+		TAtomic<bool> Stop{false};
+	};
+
+	FString MakeRecordKey(const FString& DeviceID, const int64 UnixTimestamp)
+	{
+		return FString::Printf(TEXT("%s/%lld"), *DeviceID, UnixTimestamp);
+	}
+
+	FString MakeRecordKey(const Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue>& Item)
+	{
+		return FString::Printf(TEXT("%s/%s"), *AwsStringToFString(Item.at(PartitionKeyAttributeNameAws).GetS()),
+		                       *AwsStringToFString(Item.at(SortKeyAttributeNameAws).GetS()));
+	}
+
+	/**
+	 * Write records of the devices [FirstDevice, EndDevice) at Rate records per second each, until EndTime.
+	 * Each device moves in a straight line from a random start near Brisbane. Its timestamps advance 1 / Rate seconds
+	 * per record from BaseUnixTimestamp, rounded down to whole seconds, which is what the sort key holds.
+	 * Rate must be at most 1, so that they stay unique.
+	 **/
+	void RunWriter(Aws::DynamoDB::DynamoDBClient* Client, const FString& RunID, const int32 FirstDevice, const int32 EndDevice,
+	               const double Rate, const int64 BaseUnixTimestamp, const double EndTime, FSoakLedger& Ledger)
+	{
+		const int32 NumDevices = EndDevice - FirstDevice;
+		if (NumDevices <= 0) return;
+
+		FRandomStream Random(FirstDevice);
+		TArray<FString> DeviceIDs;
+		TArray<FVector> Positions, Velocities;
+		TArray<int64> Clocks;
+		for (int32 i = 0; i < NumDevices; i++)
+		{
+			DeviceIDs.Add(FString::Printf(TEXT("soak-%s-%d"), *RunID, FirstDevice + i));
+			Positions.Add(FVector(153.0 + Random.FRandRange(-0.5f, 0.5f), -27.5 + Random.FRandRange(-0.5f, 0.5f), Random.FRandRange(0.0f, 100.0f)));
+			Velocities.Add(FVector(Random.FRandRange(-1.0e-4f, 1.0e-4f), Random.FRandRange(-1.0e-4f, 1.0e-4f), 0.0));
+			Clocks.Add(0);
+		}
+
+		Aws::DynamoDB::Model::AttributeValue MarkerType;
+		MarkerType.SetS(DynamicMarkerNameAws);
+		const double WriteRate = NumDevices * Rate;
+		const double StartTime = FPlatformTime::Seconds();
+		int64 Sent = 0;
+		int32 NextDevice = 0;
+		while (!Ledger.Stop && FPlatformTime::Seconds() < EndTime)
+		{
+			const int64 Due = static_cast<int64>((FPlatformTime::Seconds() - StartTime) * WriteRate) - Sent;
+			if (Due <= 0)
+			{
+				FPlatformProcess::Sleep(0.001f);
+				continue;
+			}
+
+			const int32 Count = static_cast<int32>(FMath::Min<int64>(Due, MaxBatchWriteItems));
+			Aws::Vector<Aws::DynamoDB::Model::WriteRequest> Writes;
+			TArray<FString> Keys;
+			for (int32 i = 0; i < Count; i++)
+			{
+				const int32 Device = NextDevice;
+				NextDevice = (NextDevice + 1) % NumDevices;
+				const int64 UnixTimestamp = BaseUnixTimestamp + static_cast<int64>(Clocks[Device]++ / Rate);
+				Positions[Device] += Velocities[Device];
+				const FLocationTs Location(FDateTime::FromUnixTimestamp(UnixTimestamp), FVector::ZeroVector, Positions[Device], FVector::ZeroVector);
+				Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue> Item = UMarkerManager::MakeMarkerItem(DeviceIDs[Device], Location);
+				Item.emplace(MarkerTypeAttributeNameAws, MarkerType);
+				Writes.push_back(Aws::DynamoDB::Model::WriteRequest().WithPutRequest(Aws::DynamoDB::Model::PutRequest().WithItem(Item)));
+				Keys.Add(MakeRecordKey(DeviceIDs[Device], UnixTimestamp));
+			}
+			Sent += Count;
+
+			// latency counts from before the write, so it covers the whole path to the marker
+			const double SentAt = FPlatformTime::Seconds();
+			{
+				FScopeLock ScopeLock(&Ledger.Lock);
+				for (const FString& Key : Keys) Ledger.Outstanding.Add(Key, SentAt);
+			}
+
+			// unprocessed items are retried with backoff; what is still left after that is counted as failed
+			Aws::DynamoDB::Model::BatchWriteItemRequest Request;
+			Request.AddRequestItems(DynamoDBTableNameAws, Writes);
+			bool Done = false;
+			for (int32 Attempt = 0; Attempt < MaxWriteAttempts && !Done; Attempt++)
+			{
+				if (Attempt > 0) FPlatformProcess::Sleep(0.05f * (1 << Attempt));
+				const Aws::DynamoDB::Model::BatchWriteItemOutcome Outcome = Client->BatchWriteItem(Request);
+				if (!Outcome.IsSuccess())
+				{
+					UE_LOG(LogMarkerSoak, Warning, TEXT("BatchWriteItem error: %s"), UTF8_TO_TCHAR(Outcome.GetError().GetMessage().c_str()));
+					continue;
+				}
+				const auto& Unprocessed = Outcome.GetResult().GetUnprocessedItems();
+				Done = Unprocessed.empty();
+				if (!Done) Request.SetRequestItems(Unprocessed);
+			}
+
+			int32 Failed = 0;
+			if (!Done)
+			{
+				FScopeLock ScopeLock(&Ledger.Lock);
+				for (const Aws::DynamoDB::Model::WriteRequest& Write : Request.GetRequestItems().at(DynamoDBTableNameAws))
+				{
+					Ledger.Outstanding.Remove(MakeRecordKey(Write.GetPutRequest().GetItem()));
+					Failed++;
+				}
+			}
+			Ledger.Written += Count - Failed;
+			Ledger.Failed += Failed;
+		}
+	}
+}
+
+UMarkerSoakCommandlet::UMarkerSoakCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 UMarkerSoakCommandlet::Main(const FString& Params)
+{
+	FSoakOptions Options;
+	FParse::Value(*Params, TEXT("Devices="), Options.Devices);
+	FParse::Value(*Params, TEXT("Rate="), Options.Rate);
+	FParse::Value(*Params, TEXT("Duration="), Options.Duration);
+	FParse::Value(*Params, TEXT("Writers="), Options.Writers);
+	FParse::Value(*Params, TEXT("FrameRate="), Options.FrameRate);
+	FParse::Value(*Params, TEXT("ReportInterval="), Options.ReportInterval);
+	FParse::Value(*Params, TEXT("Warmup="), Options.Warmup);
+	FParse::Value(*Params, TEXT("Drain="), Options.Drain);
+	FParse::Value(*Params, TEXT("PollingInterval="), Options.PollingInterval);
+	FParse::Value(*Params, TEXT("Csv="), Options.CsvPath);
+	Options.Listen = FParse::Param(*Params, TEXT("Listen"));
+	FParse::Value(*Params, TEXT("Allocations="), Options.Allocations);
+	Options.Devices = FMath::Max(Options.Devices, 1);
+	Options.Writers = FMath::Clamp(Options.Writers, 1, Options.Devices);
+	Options.FrameRate = FMath::Max(Options.FrameRate, 1.0);
+	Options.ReportInterval = FMath::Max(Options.ReportInterval, 1.0);
+	if (Options.Rate > 1.0)
+	{
+		// sort keys are whole seconds, so a faster device would overwrite its own records
+		UE_LOG(LogMarkerSoak, Warning, TEXT("-Rate=%.2f is above one record per second per device, using 1"), Options.Rate);
+		Options.Rate = 1.0;
+	}
+	Options.Rate = FMath::Max(Options.Rate, 0.001);
+	if (Options.Allocations > 0) return RunAllocationCount(Options);
+
+	if (!UseDynamoDBLocal)
+	{
+		UE_LOG(LogMarkerSoak, Error, TEXT("The soak test writes to DynamoDB Local; set UseDynamoDBLocal in Settings.h"));
+		return 1;
+	}
+	UE_LOG(LogMarkerSoak, Display, TEXT("Soak test: %d devices at %.2f records/s for %.0f s, %d writers, %s, %s"),
+	       Options.Devices, Options.Rate, Options.Duration, Options.Writers, Options.Listen ? TEXT("listen mode") : TEXT("marker feed"),
+	       *AwsStringToFString(DynamoDBLocalEndpoint));
+
+	// a manager in its own headless world, ticked by the loop below
+	UMarkerManager* Manager = NewObject<UMarkerManager>(GEngine);
+	Manager->AddToRoot();
+	Manager->InitializeStandalone();
+	UWorld* World = Manager->GetWorld();
+	World->SetGameMode(FURL());
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	FSoakLedger Ledger;
+	// 1 ms latency buckets up to 2 minutes, 0.1 ms frame time buckets up to a second
+	FSoakHistogram IntervalLatency(0.001, 120000), TotalLatency(0.001, 120000);
+	FSoakHistogram IntervalFrames(0.0001, 10000), TotalFrames(0.0001, 10000);
+	int64 Applied = 0;
+	double LastApplyTime = 0.0;
+	const FDelegateHandle AppliedHandle = Manager->OnMarkerBatchApplied.AddLambda([&](const FMarkerRecordBatch& Batch)
+	{
+		const double Now = FPlatformTime::Seconds();
+		FScopeLock ScopeLock(&Ledger.Lock);
+		for (const FLocationTs& Location : Batch.Locations)
+		{
+			double SentAt;
+			if (!Ledger.Outstanding.RemoveAndCopyValue(MakeRecordKey(Batch.DeviceID, Location.Timestamp.ToUnixTimestamp()), SentAt)) continue;
+			IntervalLatency.Add(Now - SentAt);
+			TotalLatency.Add(Now - SentAt);
+			Applied++;
+			LastApplyTime = Now;
+		}
+	});
+
+	if (Options.Listen)
+	{
+		Manager->PollingInterval = Options.PollingInterval;
+		Manager->DynamoDBStreamsListen();
+	}
+	else
+	{
+		FMarkerFeedConfig Config;
+		Config.Name = TEXT("soak");
+		Config.TableName = AwsStringToFString(DynamoDBTableNameAws);
+		Config.PollingInterval = static_cast<float>(Options.PollingInterval);
+		Manager->MarkerFeedConfigs = {Config};
+		Manager->StartMarkerFeeds();
+	}
+
+	if (!Options.CsvPath.IsEmpty())
+	{
+		FFileHelper::SaveStringToFile(TEXT("elapsed_s,written_per_s,applied_per_s,latency_p50_ms,latency_p90_ms,latency_p99_ms,latency_max_ms,")
+		                              TEXT("frame_mean_ms,frame_p99_ms,frame_max_ms,used_physical_mb,markers,pending_locations,outstanding_records\n"),
+		                              *Options.CsvPath);
+	}
+
+	const FString RunID = FString::Printf(TEXT("%lld"), FDateTime::UtcNow().ToUnixTimestamp());
+	const double RunStart = FPlatformTime::Seconds();
+	double AwsReadyTime = 0.0, WritersStart = 0.0, WritersEnd = 0.0, NextReport = 0.0, LastFrame = RunStart;
+	int64 LastWritten = 0, LastApplied = 0;
+	double PeakMemoryMB = 0.0;
+	Aws::DynamoDB::DynamoDBClient* Client = nullptr;
+	TArray<TFuture<void>> Writers;
+
+	const auto Report = [&](const double Now)
+	{
+		const double Elapsed = Now - WritersStart;
+		const double Interval = Options.ReportInterval;
+		const int64 Written = Ledger.Written;
+		const double MemoryMB = FPlatformMemory::GetStats().UsedPhysical / 1048576.0;
+		PeakMemoryMB = FMath::Max(PeakMemoryMB, MemoryMB);
+		const FMarkerIngestStatus Ingest = Manager->GetIngestStatus();
+		int32 Outstanding;
+		double WrittenPerSecond, AppliedPerSecond, P50, P90, P99, LatencyMax;
+		{
+			FScopeLock ScopeLock(&Ledger.Lock);
+			Outstanding = Ledger.Outstanding.Num();
+			WrittenPerSecond = (Written - LastWritten) / Interval;
+			AppliedPerSecond = (Applied - LastApplied) / Interval;
+			P50 = IntervalLatency.Percentile(0.5) * 1000.0;
+			P90 = IntervalLatency.Percentile(0.9) * 1000.0;
+			P99 = IntervalLatency.Percentile(0.99) * 1000.0;
+			LatencyMax = IntervalLatency.Max * 1000.0;
+			IntervalLatency.Reset();
+			LastApplied = Applied;
+		}
+		LastWritten = Written;
+
+		UE_LOG(LogMarkerSoak, Display,
+		       TEXT("[%5.0f s] written %.0f/s, applied %.0f/s, latency p50 %.0f p90 %.0f p99 %.0f max %.0f ms, ")
+		       TEXT("frame mean %.2f p99 %.2f max %.2f ms, memory %.0f MB, %d markers, %d pending, %d outstanding"),
+		       Elapsed, WrittenPerSecond, AppliedPerSecond, P50, P90, P99, LatencyMax,
+		       IntervalFrames.Mean() * 1000.0, IntervalFrames.Percentile(0.99) * 1000.0, IntervalFrames.Max * 1000.0,
+		       MemoryMB, Manager->GetSpawnedMarkerCount(), Ingest.PendingLocations + Ingest.FeedQueuedRecords, Outstanding);
+		if (!Options.CsvPath.IsEmpty())
+		{
+			FFileHelper::SaveStringToFile(
+				FString::Printf(TEXT("%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.3f,%.3f,%.3f,%.1f,%d,%d,%d\n"),
+				                Elapsed, WrittenPerSecond, AppliedPerSecond, P50, P90, P99, LatencyMax,
+				                IntervalFrames.Mean() * 1000.0, IntervalFrames.Percentile(0.99) * 1000.0, IntervalFrames.Max * 1000.0,
+				                MemoryMB, Manager->GetSpawnedMarkerCount(), Ingest.PendingLocations + Ingest.FeedQueuedRecords, Outstanding),
+				*Options.CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+		}
+		IntervalFrames.Reset();
+	};
+
+	while (!IsEngineExitRequested())
+	{
+		const double FrameStart = FPlatformTime::Seconds();
+		const float DeltaSeconds = static_cast<float>(FrameStart - LastFrame);
+		LastFrame = FrameStart;
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		FTSTicker::GetCoreTicker().Tick(DeltaSeconds);
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+		GFrameCounter++;
+		const double FrameTime = FPlatformTime::Seconds() - FrameStart;
+		IntervalFrames.Add(FrameTime);
+		TotalFrames.Add(FrameTime);
+
+		if (AwsReadyTime == 0.0)
+		{
+			if (Manager->IsAwsReady()) AwsReadyTime = FrameStart;
+			else if (FrameStart - RunStart > AwsStartupTimeout)
+			{
+				UE_LOG(LogMarkerSoak, Error, TEXT("AWS SDK did not start within %.0f s"), AwsStartupTimeout);
+				break;
+			}
+		}
+		else if (WritersStart == 0.0 && FrameStart - AwsReadyTime >= Options.Warmup)
+		{
+			// the readers have had Warmup seconds to reach the end of the stream
+			Aws::Client::ClientConfiguration Config;
+			Config.region = SpacesAwsRegion;
+			Config.endpointOverride = DynamoDBLocalEndpoint;
+			Config.maxConnections = Options.Writers;
+			Client = new Aws::DynamoDB::DynamoDBClient(Aws::Auth::AWSCredentials(AWSAccessKeyId, AWSSecretKey), Config);
+
+			WritersStart = FrameStart;
+			WritersEnd = FrameStart + Options.Duration;
+			NextReport = FrameStart + Options.ReportInterval;
+			const int64 BaseUnixTimestamp = FDateTime::UtcNow().ToUnixTimestamp();
+			for (int32 i = 0; i < Options.Writers; i++)
+			{
+				const int32 FirstDevice = Options.Devices * i / Options.Writers;
+				const int32 EndDevice = Options.Devices * (i + 1) / Options.Writers;
+				Writers.Add(Async(EAsyncExecution::Thread, [Client, RunID, FirstDevice, EndDevice, &Options, BaseUnixTimestamp, WritersEnd, &Ledger]()
+				{
+					RunWriter(Client, RunID, FirstDevice, EndDevice, Options.Rate, BaseUnixTimestamp, WritersEnd, Ledger);
+				}));
+			}
+			IntervalFrames.Reset();
+		}
+		else if (WritersStart > 0.0)
+		{
+			if (FrameStart >= NextReport)
+			{
+				Report(FrameStart);
+				NextReport += Options.ReportInterval;
+			}
+			if (FrameStart >= WritersEnd && Writers.FindByPredicate([](const TFuture<void>& Writer) { return !Writer.IsReady(); }) == nullptr)
+			{
+				bool Drained;
+				{
+					FScopeLock ScopeLock(&Ledger.Lock);
+					Drained = Ledger.Outstanding.Num() == 0;
+				}
+				if (Drained || FrameStart >= WritersEnd + Options.Drain) break;
+			}
+		}
+
+		const double Remaining = 1.0 / Options.FrameRate - (FPlatformTime::Seconds() - FrameStart);
+		if (Remaining > 0.0) FPlatformProcess::Sleep(static_cast<float>(Remaining));
+	}
+
+	Ledger.Stop = true;
+	for (TFuture<void>& Writer : Writers) Writer.Wait();
+	const double MemoryMB = FPlatformMemory::GetStats().UsedPhysical / 1048576.0;
+	PeakMemoryMB = FMath::Max(PeakMemoryMB, MemoryMB);
+	const FMarkerIngestStatus Ingest = Manager->GetIngestStatus();
+	const int64 Written = Ledger.Written;
+	const int64 Failed = Ledger.Failed;
+	const int64 NotApplied = Ledger.Outstanding.Num();
+	const double ApplySeconds = LastApplyTime > WritersStart ? LastApplyTime - WritersStart : 0.0;
+
+	UE_LOG(LogMarkerSoak, Display, TEXT("Soak test finished: %lld written, %lld failed writes, %lld applied, %lld not applied"),
+	       Written, Failed, Applied, NotApplied);
+	UE_LOG(LogMarkerSoak, Display, TEXT("Sustained throughput %.0f records/s (offered %.0f records/s)"),
+	       ApplySeconds > 0.0 ? Applied / ApplySeconds : 0.0, Options.Devices * Options.Rate);
+	UE_LOG(LogMarkerSoak, Display, TEXT("Latency p50 %.0f p90 %.0f p99 %.0f p99.9 %.0f max %.0f ms"),
+	       TotalLatency.Percentile(0.5) * 1000.0, TotalLatency.Percentile(0.9) * 1000.0, TotalLatency.Percentile(0.99) * 1000.0,
+	       TotalLatency.Percentile(0.999) * 1000.0, TotalLatency.Max * 1000.0);
+	UE_LOG(LogMarkerSoak, Display, TEXT("Frame time mean %.2f p99 %.2f max %.2f ms, memory %.0f MB (peak %.0f MB), %d markers"),
+	       TotalFrames.Mean() * 1000.0, TotalFrames.Percentile(0.99) * 1000.0, TotalFrames.Max * 1000.0,
+	       MemoryMB, PeakMemoryMB, Manager->GetSpawnedMarkerCount());
+	UE_LOG(LogMarkerSoak, Display, TEXT("Shed under load: %d locations coalesced, %d temporary and %d farthest batches dropped"),
+	       Ingest.LocationsCoalesced, Ingest.TemporaryBatchesDropped, Ingest.FarthestBatchesDropped);
+
+	if (Options.Listen && Manager->Listening) Manager->DynamoDBStreamsListen();
+	Manager->OnMarkerBatchApplied.Remove(AppliedHandle);
+	delete Client;
+	Manager->Shutdown();
+	Manager->RemoveFromRoot();
+	return Failed == 0 && NotApplied == 0 && Written > 0 ? 0 : 1;
+}
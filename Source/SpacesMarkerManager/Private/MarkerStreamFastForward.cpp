@@ -0,0 +1,316 @@
+#include "MarkerStreamFastForward.h"
+
+#include "MarkerManager.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "aws/dynamodbstreams/DynamoDBStreamsErrors.h"
+#include "aws/dynamodbstreams/model/DescribeStreamRequest.h"
+#include "aws/dynamodbstreams/model/GetRecordsRequest.h"
+#include "aws/dynamodbstreams/model/GetShardIteratorRequest.h"
+#include "aws/dynamodbstreams/model/ListStreamsRequest.h"
+
+namespace
+{
+	// Attempts per request that fails with a retryable error, with exponential backoff
+	constexpr int32 MaxRetries = 5;
+
+	// Threads reading shards at once; reads block on the network and back off with sleeps, so they get their own threads
+	constexpr int32 MaxReaderThreads = 8;
+
+	struct FDeviceLocation
+	{
+		FDateTime Timestamp;
+		double Lon = 0.0;
+		double Lat = 0.0;
+		double Elev = 0.0;
+		ELocationMarkerType MarkerType = ELocationMarkerType::Static;
+	};
+
+	/* What the records of one device reduce to */
+	struct FDeviceState
+	{
+		bool HasLocation = false;
+		FDeviceLocation Oldest;
+		FDeviceLocation Latest;
+		// Every location, only when the history is kept
+		TArray<FDeviceLocation> History;
+
+		void Add(const FDeviceLocation& Location, const bool KeepHistory)
+		{
+			if (!HasLocation || Location.Timestamp < Oldest.Timestamp) Oldest = Location;
+			if (!HasLocation || Location.Timestamp > Latest.Timestamp) Latest = Location;
+			HasLocation = true;
+			if (KeepHistory) History.Add(Location);
+		}
+
+		void Merge(FDeviceState&& Other)
+		{
+			if (!Other.HasLocation) return;
+			if (!HasLocation || Other.Oldest.Timestamp < Oldest.Timestamp) Oldest = Other.Oldest;
+			if (!HasLocation || Other.Latest.Timestamp > Latest.Timestamp) Latest = Other.Latest;
+			HasLocation = true;
+			History.Append(MoveTemp(Other.History));
+		}
+	};
+
+	/* WrapLocationTs() without the georeference object, so it can run on any thread */
+	FLocationTs ToLocationTs(const FDeviceLocation& Location, const TOptional<FMatrix>& EcefToUnreal)
+	{
+		const FVector Wgs84(Location.Lon, Location.Lat, Location.Elev);
+		if (!EcefToUnreal.IsSet()) return FLocationTs(Location.Timestamp, Wgs84, FVector::ZeroVector, FVector::ZeroVector);
+
+		// geodetic to ECEF on the WGS84 ellipsoid, in meters
+		constexpr double SemiMajorAxis = 6378137.0;
+		constexpr double Flattening = 1.0 / 298.257223563;
+		constexpr double EccentricitySquared = Flattening * (2.0 - Flattening);
+		const double Lon = FMath::DegreesToRadians(Location.Lon);
+		const double Lat = FMath::DegreesToRadians(Location.Lat);
+		const double SinLat = FMath::Sin(Lat);
+		const double CosLat = FMath::Cos(Lat);
+		const double PrimeVertical = SemiMajorAxis / FMath::Sqrt(1.0 - EccentricitySquared * SinLat * SinLat);
+		const FVector Ecef((PrimeVertical + Location.Elev) * CosLat * FMath::Cos(Lon),
+		                   (PrimeVertical + Location.Elev) * CosLat * FMath::Sin(Lon),
+		                   (PrimeVertical * (1.0 - EccentricitySquared) + Location.Elev) * SinLat);
+		return FLocationTs(Location.Timestamp, EcefToUnreal->TransformPosition(Ecef), Wgs84, Ecef);
+	}
+}
+
+struct FMarkerStreamFastForward::FShard
+{
+	Aws::String ShardId;
+	FShardSequenceDeduplicator Deduplicator;
+	TMap<Aws::String, FDeviceState> Devices;
+	int64 RecordsRead = 0;
+	int64 DuplicateRecordsDropped = 0;
+};
+
+FMarkerStreamFastForward::FMarkerStreamFastForward(Aws::DynamoDBStreams::DynamoDBStreamsClient* InClient,
+                                                   const FStreamDeduplicator& InDeduplicator,
+                                                   const TOptional<FMatrix>& InEcefToUnreal)
+	: Client(InClient), Deduplicator(InDeduplicator), EcefToUnreal(InEcefToUnreal)
+{
+}
+
+bool FMarkerStreamFastForward::Run(const Aws::String& TableName, const FDateTime From, const bool KeepHistory,
+                                   const int32 MaxEmptyPages, TArray<FMarkerRecordBatch>& OutBatches)
+{
+	// records the stream receives from now on are left to the listener
+	const FDateTime Until = FDateTime::UtcNow();
+
+	const Aws::DynamoDBStreams::Model::ListStreamsOutcome ListStreamsOutcome = Client->ListStreams(
+		Aws::DynamoDBStreams::Model::ListStreamsRequest().WithTableName(TableName));
+	if (!ListStreamsOutcome.IsSuccess())
+	{
+		UE_LOG(LogMarkerManager, Warning, TEXT("Fast-forward: ListStreams error: %s"),
+		       UTF8_TO_TCHAR(ListStreamsOutcome.GetError().GetMessage().c_str()));
+		return false;
+	}
+
+	// a table has at most one enabled stream, while disabled streams stay listed for 24 hours
+	Aws::String StreamArn;
+	Aws::Vector<Aws::DynamoDBStreams::Model::Shard> StreamShards;
+	for (const Aws::DynamoDBStreams::Model::Stream& Stream : ListStreamsOutcome.GetResult().GetStreams())
+	{
+		Aws::DynamoDBStreams::Model::DescribeStreamRequest Request;
+		Request.SetStreamArn(Stream.GetStreamArn());
+		bool Enabled = false;
+		StreamShards.clear();
+		do
+		{
+			const Aws::DynamoDBStreams::Model::DescribeStreamOutcome Outcome = Client->DescribeStream(Request);
+			if (!Outcome.IsSuccess())
+			{
+				UE_LOG(LogMarkerManager, Warning, TEXT("Fast-forward: DescribeStream error: %s"),
+				       UTF8_TO_TCHAR(Outcome.GetError().GetMessage().c_str()));
+				return false;
+			}
+			const Aws::DynamoDBStreams::Model::StreamDescription& Description = Outcome.GetResult().GetStreamDescription();
+			Enabled = Description.GetStreamStatus() == Aws::DynamoDBStreams::Model::StreamStatus::ENABLED;
+			StreamShards.insert(StreamShards.end(), Description.GetShards().begin(), Description.GetShards().end());
+			Request.SetExclusiveStartShardId(Description.GetLastEvaluatedShardId());
+		}
+		while (Enabled && !Request.GetExclusiveStartShardId().empty());
+		if (!Enabled) continue;
+		StreamArn = Stream.GetStreamArn();
+		break;
+	}
+	if (StreamArn.empty())
+	{
+		UE_LOG(LogMarkerManager, Warning, TEXT("Fast-forward: table %s has no enabled stream"), UTF8_TO_TCHAR(TableName.c_str()));
+		return false;
+	}
+
+	// every shard at once: parents and children overlap in time, but the reduction does not depend on the order
+	TArray<FShard> Shards;
+	Shards.SetNum(StreamShards.size());
+	for (int32 i = 0; i < Shards.Num(); i++)
+	{
+		Shards[i].ShardId = StreamShards[i].GetShardId();
+		Shards[i].Deduplicator = Deduplicator.GetShard(Shards[i].ShardId);
+	}
+	UE_LOG(LogMarkerManager, Display, TEXT("Fast-forward: reading %d shards of %s"), Shards.Num(), UTF8_TO_TCHAR(StreamArn.c_str()));
+	TAtomic<int32> NextShard(0);
+	TArray<TFuture<void>> Readers;
+	for (int32 Thread = 0; Thread < FMath::Min(Shards.Num(), MaxReaderThreads); Thread++)
+	{
+		Readers.Add(Async(EAsyncExecution::Thread, [this, &Shards, &NextShard, &StreamArn, From, Until, KeepHistory, MaxEmptyPages]()
+		{
+			for (int32 i = NextShard++; i < Shards.Num(); i = NextShard++)
+			{
+				ReadShard(StreamArn, Shards[i], From, Until, KeepHistory, MaxEmptyPages);
+			}
+		}));
+	}
+	for (TFuture<void>& Reader : Readers) Reader.Wait();
+
+	TMap<Aws::String, FDeviceState> Devices;
+	for (FShard& Shard : Shards)
+	{
+		Deduplicator.GetShard(Shard.ShardId) = Shard.Deduplicator;
+		RecordsRead += Shard.RecordsRead;
+		DuplicateRecordsDropped += Shard.DuplicateRecordsDropped;
+		for (TPair<Aws::String, FDeviceState>& Pair : Shard.Devices)
+		{
+			if (FDeviceState* Existing = Devices.Find(Pair.Key)) Existing->Merge(MoveTemp(Pair.Value));
+			else Devices.Add(Pair.Key, MoveTemp(Pair.Value));
+		}
+		Shard.Devices.Empty();
+	}
+
+	// the marker type is the one of the device's oldest record, as for the first batch applied live
+	TArray<TPair<Aws::String, FDeviceState>> DeviceStates;
+	DeviceStates.Reserve(Devices.Num());
+	for (TPair<Aws::String, FDeviceState>& Pair : Devices) DeviceStates.Emplace(Pair.Key, MoveTemp(Pair.Value));
+	Devices.Empty();
+	OutBatches.SetNum(DeviceStates.Num());
+	ParallelFor(DeviceStates.Num(), [this, &DeviceStates, &OutBatches, KeepHistory](const int32 i)
+	{
+		FDeviceState& State = DeviceStates[i].Value;
+		FMarkerRecordBatch& Batch = OutBatches[i];
+		Batch.DeviceID = AwsStringToFString(DeviceStates[i].Key);
+		Batch.MarkerType = State.Oldest.MarkerType;
+		Batch.FastForward = true;
+		if (Batch.MarkerType != ELocationMarkerType::Dynamic)
+		{
+			// static and temporary markers never move once spawned
+			Batch.Locations.Add(ToLocationTs(State.Oldest, EcefToUnreal));
+		}
+		else if (!KeepHistory)
+		{
+			Batch.Locations.Add(ToLocationTs(State.Latest, EcefToUnreal));
+		}
+		else
+		{
+			State.History.StableSort([](const FDeviceLocation& A, const FDeviceLocation& B) { return A.Timestamp < B.Timestamp; });
+			Batch.Locations.Reserve(State.History.Num());
+			for (const FDeviceLocation& Location : State.History)
+			{
+				// device ID and timestamp identify a record, so the first of equal timestamps wins
+				if (Batch.Locations.Num() > 0 && Batch.Locations.Last().Timestamp == Location.Timestamp) continue;
+				Batch.Locations.Add(ToLocationTs(Location, EcefToUnreal));
+			}
+		}
+	});
+	return true;
+}
+
+void FMarkerStreamFastForward::ReadShard(const Aws::String& StreamArn, FShard& Shard, const FDateTime From,
+                                         const FDateTime Until, const bool KeepHistory, const int32 MaxEmptyPages) const
+{
+	Aws::DynamoDBStreams::Model::GetShardIteratorRequest IteratorRequest;
+	IteratorRequest.SetStreamArn(StreamArn);
+	IteratorRequest.SetShardId(Shard.ShardId);
+	Aws::String Iterator;
+	// Last record read, to resume after if the iterator expires
+	Aws::String LastSequenceNumber;
+	int32 EmptyPages = 0;
+	int32 Retries = 0;
+	FRawMarkerRecord RawRecord;
+
+	const auto RetryAfter = [&Retries, &Shard](const Aws::Client::AWSError<Aws::DynamoDBStreams::DynamoDBStreamsErrors>& Error)
+	{
+		if (!Error.ShouldRetry() || Retries >= MaxRetries)
+		{
+			UE_LOG(LogMarkerManager, Warning, TEXT("Fast-forward: giving up on shard %s: %s"),
+			       UTF8_TO_TCHAR(Shard.ShardId.c_str()), UTF8_TO_TCHAR(Error.GetMessage().c_str()));
+			return false;
+		}
+		FPlatformProcess::Sleep(0.1f * (1 << Retries));
+		Retries++;
+		return true;
+	};
+
+	while (true)
+	{
+		if (Iterator.empty())
+		{
+			if (LastSequenceNumber.empty())
+			{
+				IteratorRequest.SetShardIteratorType(Aws::DynamoDBStreams::Model::ShardIteratorType::TRIM_HORIZON);
+			}
+			else
+			{
+				IteratorRequest.SetShardIteratorType(Aws::DynamoDBStreams::Model::ShardIteratorType::AFTER_SEQUENCE_NUMBER);
+				IteratorRequest.SetSequenceNumber(LastSequenceNumber);
+			}
+			const Aws::DynamoDBStreams::Model::GetShardIteratorOutcome Outcome = Client->GetShardIterator(IteratorRequest);
+			if (!Outcome.IsSuccess())
+			{
+				if (RetryAfter(Outcome.GetError())) continue;
+				return;
+			}
+			Iterator = Outcome.GetResult().GetShardIterator();
+			Shard.Deduplicator.BeginRun();
+		}
+
+		const Aws::DynamoDBStreams::Model::GetRecordsOutcome Outcome = Client->GetRecords(
+			Aws::DynamoDBStreams::Model::GetRecordsRequest().WithShardIterator(Iterator));
+		if (!Outcome.IsSuccess())
+		{
+			const Aws::DynamoDBStreams::DynamoDBStreamsErrors ErrorType = Outcome.GetError().GetErrorType();
+			if ((ErrorType == Aws::DynamoDBStreams::DynamoDBStreamsErrors::EXPIRED_ITERATOR ||
+				ErrorType == Aws::DynamoDBStreams::DynamoDBStreamsErrors::TRIMMED_DATA_ACCESS) && Retries < MaxRetries)
+			{
+				// resume after the last record read, or from the new trim horizon
+				Iterator.clear();
+				Retries++;
+				continue;
+			}
+			if (RetryAfter(Outcome.GetError())) continue;
+			return;
+		}
+		Retries = 0;
+
+		const Aws::DynamoDBStreams::Model::GetRecordsResult& Result = Outcome.GetResult();
+		for (const Aws::DynamoDBStreams::Model::Record& Record : Result.GetRecords())
+		{
+			const Aws::DynamoDBStreams::Model::StreamRecord& StreamRecord = Record.GetDynamodb();
+			const FDateTime CreatedDateTime = FDateTime::FromUnixTimestamp(StreamRecord.GetApproximateCreationDateTime().Millis() / 1000);
+			if (CreatedDateTime >= Until) return;
+			LastSequenceNumber = StreamRecord.GetSequenceNumber();
+			if (Record.GetEventName() != Aws::DynamoDBStreams::Model::OperationType::INSERT || CreatedDateTime < From) continue;
+			// only records in the window count as seen, since the deduplicator is merged back into the manager's
+			if (!Shard.Deduplicator.Accept(StreamRecord.GetSequenceNumber()))
+			{
+				Shard.DuplicateRecordsDropped++;
+				continue;
+			}
+			if (!FRawMarkerRecord::FromStreamRecord(StreamRecord, RawRecord)) continue;
+
+			FDeviceLocation Location;
+			Location.Timestamp = RawRecord.Timestamp;
+			Location.Lon = RawRecord.Lon;
+			Location.Lat = RawRecord.Lat;
+			Location.Elev = RawRecord.Elev;
+			Location.MarkerType = RawRecord.MarkerType;
+			Shard.Devices.FindOrAdd(RawRecord.DeviceID).Add(Location, KeepHistory);
+			Shard.RecordsRead++;
+		}
+
+		// an empty next iterator means the shard is closed and has been read to the end
+		Iterator = Result.GetNextShardIterator();
+		if (Iterator.empty()) return;
+		EmptyPages = Result.GetRecords().empty() ? EmptyPages + 1 : 0;
+		if (EmptyPages > MaxEmptyPages) return;
+	}
+}
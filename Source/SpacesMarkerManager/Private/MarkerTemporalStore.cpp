@@ -0,0 +1,211 @@
+#include "MarkerTemporalStore.h"
+
+FMarkerTemporalStore::FMarkerTemporalStore(const int64 InBucketSeconds)
+	: BucketTicks(FMath::Max<int64>(InBucketSeconds, 1) * ETimespan::TicksPerSecond)
+{
+}
+
+void FMarkerTemporalStore::Add(const FString& DeviceID, const ELocationMarkerType MarkerType, const TArray<FLocationTs>& Locations)
+{
+	if (Locations.Num() == 0) return;
+
+	int32 Index;
+	if (const int32* Found = TrackIndex.Find(DeviceID))
+	{
+		Index = *Found;
+	}
+	else
+	{
+		Index = Tracks.AddDefaulted();
+		Tracks[Index].DeviceID = DeviceID;
+		Tracks[Index].MarkerType = MarkerType;
+		TrackIndex.Add(DeviceID, Index);
+	}
+
+	FTrack& Track = Tracks[Index];
+	const FLocationTsFromWgs84* Converter = GetConverter();
+	for (const FLocationTs& Location : Locations)
+	{
+		const int64 Ticks = Location.Timestamp.GetTicks();
+		if (!Track.Trajectory.Add(Location, Converter)) continue;
+		RecordCount++;
+		EarliestTicks = FMath::Min(EarliestTicks, Ticks);
+		LatestTicks = FMath::Max(LatestTicks, Ticks);
+		IndexRecord(Index, Ticks);
+	}
+}
+
+void FMarkerTemporalStore::IndexRecord(const int32 Index, const int64 Ticks)
+{
+	FTrack& Track = Tracks[Index];
+	const int64 Bucket = GetBucket(Ticks);
+	if (Bucket == Track.LastIndexedBucket) return;
+	TArray<int32>& Devices = BucketIndex.FindOrAdd(Bucket);
+	if (Bucket > Track.LastIndexedBucket)
+	{
+		// a newer bucket than any before cannot list the track yet
+		Devices.Add(Index);
+		Track.LastIndexedBucket = Bucket;
+	}
+	else
+	{
+		Devices.AddUnique(Index);
+	}
+}
+
+void FMarkerTemporalStore::GetStatesAt(const FDateTime Time, const bool Interpolate, const double MaxAgeSeconds,
+                                       TArray<FMarkerState>& OutStates) const
+{
+	const int64 Ticks = Time.GetTicks();
+	const int64 MinTicks = MaxAgeSeconds > 0.0 ? Ticks - static_cast<int64>(MaxAgeSeconds * ETimespan::TicksPerSecond) : MIN_int64;
+	const FLocationTsFromWgs84* Converter = GetConverter();
+	OutStates.Reserve(OutStates.Num() + Tracks.Num());
+	FLocationTs Latest;
+	TOptional<FLocationTs> Next;
+	for (const FTrack& Track : Tracks)
+	{
+		// the latest record at Time, and the one after it to interpolate towards, from one walk of their block
+		if (!Track.Trajectory.GetAround(Ticks, MinTicks, Converter, Interpolate, Latest, Next)) continue;
+
+		FMarkerState& State = OutStates.AddDefaulted_GetRef();
+		State.DeviceID = Track.DeviceID;
+		State.MarkerType = Track.MarkerType;
+		State.LocationTs = Latest;
+		const int64 LatestTicks = Latest.Timestamp.GetTicks();
+		if (Next.IsSet() && LatestTicks < Ticks)
+		{
+			const FLocationTs& A = Latest;
+			const FLocationTs& B = Next.GetValue();
+			const double Alpha = static_cast<double>(Ticks - LatestTicks) / (B.Timestamp.GetTicks() - LatestTicks);
+			State.LocationTs = FLocationTs(Time,
+			                               FMath::Lerp(A.UECoordinate, B.UECoordinate, Alpha),
+			                               FMath::Lerp(A.Wgs84Coordinate, B.Wgs84Coordinate, Alpha),
+			                               FMath::Lerp(A.EcefCoordinate, B.EcefCoordinate, Alpha));
+		}
+	}
+}
+
+void FMarkerTemporalStore::GetRecordsBetween(const FDateTime From, const FDateTime To, TArray<FMarkerState>& OutRecords) const
+{
+	if (To < From || RecordCount == 0) return;
+	const int64 FromTicks = FMath::Max(From.GetTicks(), EarliestTicks);
+	const int64 ToTicks = FMath::Min(To.GetTicks(), LatestTicks);
+	if (ToTicks < FromTicks) return;
+
+	// devices with records in range, from the bucket index, unless the range covers more buckets than there are
+	TArray<int32> Devices;
+	const int64 FirstBucket = GetBucket(FromTicks);
+	const int64 LastBucket = GetBucket(ToTicks);
+	if (LastBucket - FirstBucket + 1 > BucketIndex.Num())
+	{
+		for (int32 i = 0; i < Tracks.Num(); i++) Devices.Add(i);
+	}
+	else
+	{
+		TBitArray<> Seen(false, Tracks.Num());
+		for (int64 Bucket = FirstBucket; Bucket <= LastBucket; Bucket++)
+		{
+			const TArray<int32>* BucketDevices = BucketIndex.Find(Bucket);
+			if (BucketDevices == nullptr) continue;
+			for (const int32 Index : *BucketDevices)
+			{
+				if (Seen[Index]) continue;
+				Seen[Index] = true;
+				Devices.Add(Index);
+			}
+		}
+		Devices.Sort();
+	}
+
+	const FLocationTsFromWgs84* Converter = GetConverter();
+	TArray<FLocationTs> Locations;
+	for (const int32 Index : Devices)
+	{
+		const FTrack& Track = Tracks[Index];
+		Locations.Reset();
+		Track.Trajectory.GetRange(Track.Trajectory.LowerBound(FromTicks), Track.Trajectory.UpperBound(ToTicks), Converter, Locations);
+		for (FLocationTs& Location : Locations)
+		{
+			FMarkerState& Record = OutRecords.AddDefaulted_GetRef();
+			Record.DeviceID = Track.DeviceID;
+			Record.MarkerType = Track.MarkerType;
+			Record.LocationTs = MoveTemp(Location);
+		}
+	}
+}
+
+bool FMarkerTemporalStore::GetDeviceRecords(const FString& DeviceID, const FDateTime From, const FDateTime To,
+                                            TArray<FLocationTs>& OutLocations) const
+{
+	const int32* Index = TrackIndex.Find(DeviceID);
+	if (Index == nullptr) return false;
+	const FCompactTrajectory& Trajectory = Tracks[*Index].Trajectory;
+	Trajectory.GetRange(Trajectory.LowerBound(From.GetTicks()), Trajectory.UpperBound(To.GetTicks()), GetConverter(), OutLocations);
+	return true;
+}
+
+void FMarkerTemporalStore::TrimBefore(const FDateTime Time)
+{
+	const int64 Ticks = Time.GetTicks();
+	if (RecordCount == 0 || Ticks <= EarliestTicks) return;
+
+	// the latest record before Time is kept, since it is the device's state at Time and at any time after it.
+	// devices that stopped reporting, like static markers, keep their last location this way.
+	int64 Removed = 0;
+	EarliestTicks = MAX_int64;
+	const FLocationTsFromWgs84* Converter = GetConverter();
+	for (FTrack& Track : Tracks)
+	{
+		const int32 Expired = Track.Trajectory.LowerBound(Ticks) - 1;
+		if (Expired > 0)
+		{
+			Track.Trajectory.RemoveFirst(Expired, Converter);
+			Removed += Expired;
+		}
+		EarliestTicks = FMath::Min(EarliestTicks, Track.Trajectory.GetTicks(0));
+	}
+	RecordCount -= Removed;
+	if (Removed == 0) return;
+
+	// the bucket index is rebuilt from the remaining records
+	BucketIndex.Reset();
+	TArray<int64> RecordTicks;
+	for (int32 i = 0; i < Tracks.Num(); i++)
+	{
+		Tracks[i].LastIndexedBucket = MIN_int64;
+		RecordTicks.Reset();
+		Tracks[i].Trajectory.GetAllTicks(RecordTicks);
+		for (const int64 Record : RecordTicks)
+		{
+			IndexRecord(i, Record);
+		}
+	}
+}
+
+void FMarkerTemporalStore::Reset()
+{
+	Tracks.Reset();
+	TrackIndex.Reset();
+	BucketIndex.Reset();
+	RecordCount = 0;
+	EarliestTicks = MAX_int64;
+	LatestTicks = MIN_int64;
+}
+
+SIZE_T FMarkerTemporalStore::GetAllocatedSize() const
+{
+	SIZE_T Size = Tracks.GetAllocatedSize() + TrackIndex.GetAllocatedSize() + BucketIndex.GetAllocatedSize();
+	for (const FTrack& Track : Tracks)
+	{
+		Size += Track.Trajectory.GetAllocatedSize();
+	}
+	return Size;
+}
+
+bool FMarkerTemporalStore::GetTimeRange(FDateTime& OutEarliest, FDateTime& OutLatest) const
+{
+	if (RecordCount == 0) return false;
+	OutEarliest = FDateTime(EarliestTicks);
+	OutLatest = FDateTime(LatestTicks);
+	return true;
+}
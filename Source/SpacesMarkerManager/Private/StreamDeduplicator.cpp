@@ -0,0 +1,170 @@
+#include "StreamDeduplicator.h"
+
+#include "Hash/CityHash.h"
+
+FShardSequenceDeduplicator::FShardSequenceDeduplicator(const int32 InMaxRanges, const int32 InWindowSize)
+	: MaxRanges(FMath::Max(1, InMaxRanges)), WindowSize(FMath::Max(1, InWindowSize))
+{
+}
+
+void FShardSequenceDeduplicator::BeginRun()
+{
+	CurrentRange = INDEX_NONE;
+}
+
+int32 FShardSequenceDeduplicator::CompareSequenceNumbers(const Aws::String& A, const Aws::String& B)
+{
+	// sequence numbers are decimal strings without leading zeros, so a longer string is a larger number
+	if (A.size() != B.size()) return A.size() < B.size() ? -1 : 1;
+	return A.compare(B);
+}
+
+bool FShardSequenceDeduplicator::IsDuplicate(const Aws::String& SequenceNumber) const
+{
+	for (const FSequenceRange& Range : Ranges)
+	{
+		if (CompareSequenceNumbers(Range.First, SequenceNumber) <= 0 &&
+			CompareSequenceNumbers(SequenceNumber, Range.Last) <= 0)
+		{
+			return true;
+		}
+	}
+	return WindowSet.Contains(CityHash64(SequenceNumber.data(), SequenceNumber.size()));
+}
+
+bool FShardSequenceDeduplicator::Accept(const Aws::String& SequenceNumber)
+{
+	if (SequenceNumber.empty()) return true;
+
+	const bool Duplicate = IsDuplicate(SequenceNumber);
+	ExtendCurrentRun(SequenceNumber);
+	if (!Duplicate)
+	{
+		AddToWindow(CityHash64(SequenceNumber.data(), SequenceNumber.size()));
+		if (HighWatermark.empty() || CompareSequenceNumbers(SequenceNumber, HighWatermark) > 0)
+		{
+			HighWatermark = SequenceNumber;
+		}
+	}
+	return !Duplicate;
+}
+
+void FShardSequenceDeduplicator::Merge(const FShardSequenceDeduplicator& Other)
+{
+	const bool Running = CurrentRange != INDEX_NONE;
+	const Aws::String RunLast = Running ? Ranges[CurrentRange].Last : Aws::String();
+
+	// each range of the other side is replayed as a run of its two ends, which merges it with any overlapping range
+	for (const FSequenceRange& Range : Other.Ranges)
+	{
+		CurrentRange = INDEX_NONE;
+		ExtendCurrentRun(Range.First);
+		ExtendCurrentRun(Range.Last);
+	}
+	for (int32 i = 0; i < Other.Window.Num(); i++)
+	{
+		const uint64 Hash = Other.Window[(Other.WindowHead + i) % Other.Window.Num()];
+		if (!WindowSet.Contains(Hash)) AddToWindow(Hash);
+	}
+	if (HighWatermark.empty() || (!Other.HighWatermark.empty() && CompareSequenceNumbers(Other.HighWatermark, HighWatermark) > 0))
+	{
+		HighWatermark = Other.HighWatermark;
+	}
+
+	// the range that now holds the end of the current run continues it
+	CurrentRange = INDEX_NONE;
+	if (!Running) return;
+	for (int32 i = 0; i < Ranges.Num(); i++)
+	{
+		if (CompareSequenceNumbers(Ranges[i].First, RunLast) <= 0 && CompareSequenceNumbers(RunLast, Ranges[i].Last) <= 0)
+		{
+			CurrentRange = i;
+			break;
+		}
+	}
+}
+
+void FShardSequenceDeduplicator::ExtendCurrentRun(const Aws::String& SequenceNumber)
+{
+	if (CurrentRange == INDEX_NONE)
+	{
+		if (Ranges.Num() >= MaxRanges)
+		{
+			Ranges.RemoveAt(0);
+		}
+		CurrentRange = Ranges.Add(FSequenceRange{SequenceNumber, SequenceNumber});
+		return;
+	}
+
+	FSequenceRange& Current = Ranges[CurrentRange];
+	if (CompareSequenceNumbers(SequenceNumber, Current.Last) > 0) Current.Last = SequenceNumber;
+	else if (CompareSequenceNumbers(SequenceNumber, Current.First) < 0) Current.First = SequenceNumber;
+
+	// merge any older range that the current run now overlaps
+	for (int32 i = Ranges.Num() - 1; i >= 0; i--)
+	{
+		if (i == CurrentRange) continue;
+		const FSequenceRange& Other = Ranges[i];
+		if (CompareSequenceNumbers(Other.First, Ranges[CurrentRange].Last) <= 0 &&
+			CompareSequenceNumbers(Ranges[CurrentRange].First, Other.Last) <= 0)
+		{
+			if (CompareSequenceNumbers(Other.First, Ranges[CurrentRange].First) < 0) Ranges[CurrentRange].First = Other.First;
+			if (CompareSequenceNumbers(Other.Last, Ranges[CurrentRange].Last) > 0) Ranges[CurrentRange].Last = Other.Last;
+			Ranges.RemoveAt(i);
+			if (i < CurrentRange) CurrentRange--;
+		}
+	}
+}
+
+void FShardSequenceDeduplicator::AddToWindow(const uint64 Hash)
+{
+	if (Window.Num() < WindowSize)
+	{
+		Window.Add(Hash);
+	}
+	else
+	{
+		WindowSet.Remove(Window[WindowHead]);
+		Window[WindowHead] = Hash;
+		WindowHead = (WindowHead + 1) % WindowSize;
+	}
+	WindowSet.Add(Hash);
+}
+
+FStreamDeduplicator::FStreamDeduplicator(const int32 InMaxTrackedShards)
+	: MaxTrackedShards(FMath::Max(1, InMaxTrackedShards))
+{
+}
+
+FShardSequenceDeduplicator& FStreamDeduplicator::GetShard(const Aws::String& ShardId)
+{
+	if (FShardSequenceDeduplicator* Existing = Shards.Find(ShardId))
+	{
+		ShardOrder.Remove(ShardId);
+		ShardOrder.Add(ShardId);
+		return *Existing;
+	}
+
+	if (ShardOrder.Num() >= MaxTrackedShards)
+	{
+		Shards.Remove(ShardOrder[0]);
+		ShardOrder.RemoveAt(0);
+	}
+	ShardOrder.Add(ShardId);
+	return Shards.Add(ShardId, FShardSequenceDeduplicator());
+}
+
+void FStreamDeduplicator::Merge(const FStreamDeduplicator& Other)
+{
+	// least recently used first, so the other side's order of use carries over
+	for (const Aws::String& ShardId : Other.ShardOrder)
+	{
+		GetShard(ShardId).Merge(Other.Shards.FindChecked(ShardId));
+	}
+}
+
+void FStreamDeduplicator::Reset()
+{
+	Shards.Empty();
+	ShardOrder.Empty();
+}
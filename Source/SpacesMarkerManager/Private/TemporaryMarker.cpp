@@ -1,12 +1,14 @@
 ﻿#include "TemporaryMarker.h"
 
+#include "MarkerManager.h"
+
 
 DEFINE_LOG_CATEGORY(LogTemporaryMarker);
 
 ATemporaryMarker::ATemporaryMarker()
 {
-	PrimaryActorTick.bCanEverTick = true;
-	PrimaryActorTick.TickInterval = 0.1f;
+	// expiry and shrinking are driven by UMarkerManager and the material
+	PrimaryActorTick.bCanEverTick = false;
 	Super::MarkerType = ELocationMarkerType::Temporary;
 	Super::BaseColor = TemporaryMarkerColor;
 	Super::DeleteFromDBOnDestroy = false;
@@ -17,16 +19,50 @@ ATemporaryMarker::ATemporaryMarker()
 void ATemporaryMarker::BeginPlay()
 {
 	Super::BeginPlay();
-	SetLifeSpan(DefaultLifeSpan);
+	ScheduleExpiry(DefaultLifeSpan);
 }
 
-// Called every frame
-void ATemporaryMarker::Tick(const float DeltaTime)
+void ATemporaryMarker::ScheduleExpiry(const float LifeSpan)
 {
-	Super::Tick(DeltaTime);
-	if (GetLifeSpan() > 0)
+	ExpiryGeneration++;
+	ExpiryStartTime = GetWorld()->GetTimeSeconds();
+	ExpiryTime = ExpiryStartTime + LifeSpan;
+	DynamicMaterial->SetScalarParameterValue(TEXT("ExpiryStartTime"), ExpiryStartTime);
+	DynamicMaterial->SetScalarParameterValue(TEXT("ExpiryLifeSpan"), LifeSpan);
+	DynamicMaterial->SetScalarParameterValue(TEXT("MaxScale"), MaxScale);
+
+	if (UMarkerManager* MarkerManager = Cast<UMarkerManager>(GetGameInstance()))
+	{
+		MarkerManager->ScheduleMarkerExpiry(this);
+	}
+	else
 	{
-		const float Scale = FGenericPlatformMath::Min(MaxScale, (GetLifeSpan() + DeltaTime) / InitialLifeSpan);
-		SetActorRelativeScale3D(FVector(Scale, Scale, Scale));
+		// without the manager there is no timing wheel
+		SetLifeSpan(LifeSpan);
 	}
-}
\ No newline at end of file
+}
+
+void ATemporaryMarker::CancelExpiry()
+{
+	if (ExpiryTime == 0.0f) return;
+	ExpiryGeneration++;
+	ExpiryTime = 0.0f;
+	DynamicMaterial->SetScalarParameterValue(TEXT("ExpiryLifeSpan"), 0.0f);
+	SetActorRelativeScale3D(FVector::OneVector);
+	SetLifeSpan(0);
+}
+
+void ATemporaryMarker::SetSignificance(const EMarkerSignificance InSignificance, const int32 UpdateRateDivisor)
+{
+	if (InSignificance == Significance) return;
+	const bool Hidden = InSignificance == EMarkerSignificance::Hidden;
+	if (Hidden != (Significance == EMarkerSignificance::Hidden)) SetActorHiddenInGame(Hidden);
+	Significance = InSignificance;
+}
+
+float ATemporaryMarker::GetExpiryScale(const float Now) const
+{
+	const float LifeSpan = ExpiryTime - ExpiryStartTime;
+	if (ExpiryTime == 0.0f || LifeSpan <= 0.0f) return 1.0f;
+	return FMath::Clamp((ExpiryTime - Now) / LifeSpan, 0.0f, MaxScale);
+}
@@ -0,0 +1,42 @@
+#include "CompactTrajectory.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompactTrajectorySizeTest, "SpacesMarkerManager.CompactTrajectory.BytesPerSample",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FCompactTrajectorySizeTest::RunTest(const FString& Parameters)
+{
+	// the coordinates are derived from WGS84 without a georeference, only the encoding is measured
+	const FLocationTsFromWgs84 FromWgs84 = [](const FDateTime Timestamp, const FVector& Wgs84)
+	{
+		return FLocationTs(Timestamp, FVector::ZeroVector, Wgs84, FVector::ZeroVector);
+	};
+
+	// a day of a vehicle at 10 m/s, sampled once a second, turning slowly and going up and down a little
+	constexpr int32 Samples = 86400;
+	const FDateTime Start(2024, 1, 1);
+	double Lat = 47.6, Lon = -122.3, Height = 30.0, Heading = 0.0;
+	FCompactTrajectory Trajectory;
+	for (int32 i = 0; i < Samples; i++)
+	{
+		Heading += FMath::DegreesToRadians(5.0) * FMath::Sin(i / 37.0);
+		Lat += 10.0 * FMath::Cos(Heading) / 111320.0;
+		Lon += 10.0 * FMath::Sin(Heading) / (111320.0 * FMath::Cos(FMath::DegreesToRadians(Lat)));
+		Height += 0.05 * FMath::Sin(i / 11.0);
+		Trajectory.Add(FLocationTs(Start + FTimespan::FromSeconds(i), FVector::ZeroVector, FVector(Lon, Lat, Height),
+		                           FVector::ZeroVector), &FromWgs84);
+	}
+
+	const double BytesPerSample = static_cast<double>(Trajectory.GetAllocatedSize()) / Trajectory.Num();
+	AddInfo(FString::Printf(TEXT("%.2f bytes per sample, against %d for an int64 timestamp and an FLocationTs"),
+	                        BytesPerSample, static_cast<int32>(sizeof(int64) + sizeof(FLocationTs))));
+	TestEqual(TEXT("every sample is kept"), Trajectory.Num(), Samples);
+	// the figure given in CompactTrajectory.h and the report
+	TestTrue(TEXT("about 8 bytes per sample"), BytesPerSample < 9.0);
+	return true;
+}
+
+#endif
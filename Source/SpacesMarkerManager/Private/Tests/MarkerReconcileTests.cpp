@@ -0,0 +1,138 @@
+#include "MarkerReconcile.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const FDateTime ReadStartedAt(2024, 1, 1, 12);
+	constexpr float TemporaryLifeSpan = 60.0f;
+	constexpr float DynamicLifeSpan = 300.0f;
+
+	FLocationTs MakeLocation(const double SecondsBeforeRead, const double Lon = 10.0)
+	{
+		return FLocationTs(ReadStartedAt - FTimespan::FromSeconds(SecondsBeforeRead), FVector::ZeroVector,
+		                   FVector(Lon, 50.0, 100.0), FVector(1.0, 1.0, 1.0));
+	}
+
+	FMarkerRecordBatch MakeBatch(const FString& DeviceID, const ELocationMarkerType MarkerType, const TArray<FLocationTs>& Locations)
+	{
+		FMarkerRecordBatch Batch;
+		Batch.DeviceID = DeviceID;
+		Batch.MarkerType = MarkerType;
+		Batch.Locations = Locations;
+		return Batch;
+	}
+
+	FSpawnedMarkerState MakeSpawned(const ELocationMarkerType MarkerType, const FLocationTs& Location, const FLocationTs& Latest)
+	{
+		FSpawnedMarkerState State;
+		State.MarkerType = MarkerType;
+		State.LocationTs = Location;
+		State.LatestTimestamp = Latest.Timestamp;
+		return State;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMarkerReconcileTypeChangeTest, "SpacesMarkerManager.Reconcile.TypeChange",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMarkerReconcileTypeChangeTest::RunTest(const FString& Parameters)
+{
+	const FLocationTs Location = MakeLocation(10.0);
+	TMap<FString, FSpawnedMarkerState> Spawned;
+	Spawned.Add(TEXT("a"), MakeSpawned(ELocationMarkerType::Static, Location, Location));
+	const TArray<FMarkerRecordBatch> Database = {MakeBatch(TEXT("a"), ELocationMarkerType::Temporary, {Location})};
+
+	// a device that changed type is removed and added again as a marker of the new class
+	const FMarkerReconcilePlan Plan = FMarkerReconcilePlan::Diff(Database, Spawned, false, ReadStartedAt, TemporaryLifeSpan, DynamicLifeSpan);
+	TestTrue(TEXT("removed"), Plan.Removed == TArray<FString>({TEXT("a")}));
+	TestEqual(TEXT("added"), Plan.Added.Num(), 1);
+	TestTrue(TEXT("added with the new type"), Plan.Added.Num() == 1 && Plan.Added[0].MarkerType == ELocationMarkerType::Temporary);
+	TestEqual(TEXT("not updated"), Plan.Updated.Num(), 0);
+	TestEqual(TEXT("not unchanged"), Plan.Unchanged, 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMarkerReconcileExpiryTest, "SpacesMarkerManager.Reconcile.Expiry",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMarkerReconcileExpiryTest::RunTest(const FString& Parameters)
+{
+	const TArray<FMarkerRecordBatch> Database = {
+		MakeBatch(TEXT("expired-temporary"), ELocationMarkerType::Temporary, {MakeLocation(TemporaryLifeSpan + 1.0)}),
+		MakeBatch(TEXT("live-temporary"), ELocationMarkerType::Temporary, {MakeLocation(TemporaryLifeSpan - 1.0)}),
+		// a dynamic marker expires from the end of its history, not the start
+		MakeBatch(TEXT("expired-dynamic"), ELocationMarkerType::Dynamic,
+		          {MakeLocation(DynamicLifeSpan + 20.0), MakeLocation(DynamicLifeSpan + 10.0)}),
+		MakeBatch(TEXT("live-dynamic"), ELocationMarkerType::Dynamic,
+		          {MakeLocation(DynamicLifeSpan + 10.0), MakeLocation(DynamicLifeSpan - 10.0)}),
+		// static markers never expire
+		MakeBatch(TEXT("static"), ELocationMarkerType::Static, {MakeLocation(86400.0)}),
+	};
+
+	const FMarkerReconcilePlan Plan = FMarkerReconcilePlan::Diff(Database, {}, false, ReadStartedAt, TemporaryLifeSpan, DynamicLifeSpan);
+	TArray<FString> Added;
+	for (const FMarkerRecordBatch& Batch : Plan.Added) Added.Add(Batch.DeviceID);
+	TestTrue(TEXT("only markers that would still be alive are added"),
+	         Added == TArray<FString>({TEXT("live-temporary"), TEXT("live-dynamic"), TEXT("static")}));
+	TestEqual(TEXT("nothing removed"), Plan.Removed.Num(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMarkerReconcileDynamicSuffixTest, "SpacesMarkerManager.Reconcile.DynamicSuffix",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMarkerReconcileDynamicSuffixTest::RunTest(const FString& Parameters)
+{
+	const TArray<FLocationTs> History = {MakeLocation(30.0, 10.0), MakeLocation(20.0, 10.1), MakeLocation(10.0, 10.2)};
+	TMap<FString, FSpawnedMarkerState> Spawned;
+	Spawned.Add(TEXT("behind"), MakeSpawned(ELocationMarkerType::Dynamic, History[0], History[1]));
+	Spawned.Add(TEXT("current"), MakeSpawned(ELocationMarkerType::Dynamic, History[0], History[2]));
+	const TArray<FMarkerRecordBatch> Database = {
+		MakeBatch(TEXT("behind"), ELocationMarkerType::Dynamic, History),
+		MakeBatch(TEXT("current"), ELocationMarkerType::Dynamic, History),
+	};
+
+	const FMarkerReconcilePlan Plan = FMarkerReconcilePlan::Diff(Database, Spawned, false, ReadStartedAt, TemporaryLifeSpan, DynamicLifeSpan);
+	TestEqual(TEXT("one marker updated"), Plan.Updated.Num(), 1);
+	if (Plan.Updated.Num() == 1)
+	{
+		TestEqual(TEXT("the marker behind is updated"), Plan.Updated[0].DeviceID, FString(TEXT("behind")));
+		// rows at or before the end of the history are left out, decimation may have removed them locally
+		TestEqual(TEXT("only the newer rows"), Plan.Updated[0].Locations.Num(), 1);
+		TestTrue(TEXT("the newest row"), Plan.Updated[0].Locations.Num() == 1 && Plan.Updated[0].Locations[0].Timestamp == History[2].Timestamp);
+	}
+	TestEqual(TEXT("the marker at the end of the table is unchanged"), Plan.Unchanged, 1);
+	TestEqual(TEXT("nothing added"), Plan.Added.Num(), 0);
+	TestEqual(TEXT("nothing removed"), Plan.Removed.Num(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMarkerReconcileRemovalTest, "SpacesMarkerManager.Reconcile.Removal",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMarkerReconcileRemovalTest::RunTest(const FString& Parameters)
+{
+	const FLocationTs Old = MakeLocation(10.0);
+	// newer than the read, so it may be missing from it
+	const FLocationTs New = MakeLocation(-10.0);
+	TMap<FString, FSpawnedMarkerState> Spawned;
+	Spawned.Add(TEXT("static"), MakeSpawned(ELocationMarkerType::Static, Old, Old));
+	Spawned.Add(TEXT("temporary"), MakeSpawned(ELocationMarkerType::Temporary, Old, Old));
+	Spawned.Add(TEXT("dynamic"), MakeSpawned(ELocationMarkerType::Dynamic, Old, Old));
+	Spawned.Add(TEXT("new-static"), MakeSpawned(ELocationMarkerType::Static, New, New));
+
+	// a read of only static markers says nothing about the other types
+	FMarkerReconcilePlan Plan = FMarkerReconcilePlan::Diff({}, Spawned, true, ReadStartedAt, TemporaryLifeSpan, DynamicLifeSpan);
+	TestTrue(TEXT("static read removes only static markers"), Plan.Removed == TArray<FString>({TEXT("static")}));
+
+	Plan = FMarkerReconcilePlan::Diff({}, Spawned, false, ReadStartedAt, TemporaryLifeSpan, DynamicLifeSpan);
+	Plan.Removed.Sort();
+	TestTrue(TEXT("full read removes every type, but not markers newer than the read"),
+	         Plan.Removed == TArray<FString>({TEXT("dynamic"), TEXT("static"), TEXT("temporary")}));
+	return true;
+}
+
+#endif
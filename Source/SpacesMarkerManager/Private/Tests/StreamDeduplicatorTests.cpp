@@ -0,0 +1,112 @@
+#include "StreamDeduplicator.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStreamDeduplicatorCompareTest, "SpacesMarkerManager.StreamDeduplicator.CompareSequenceNumbers",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FStreamDeduplicatorCompareTest::RunTest(const FString& Parameters)
+{
+	// a longer number is larger whatever its digits, an equal length compares digit by digit
+	TestTrue(TEXT("9 < 10"), FShardSequenceDeduplicator::CompareSequenceNumbers("9", "10") < 0);
+	TestTrue(TEXT("100 > 99"), FShardSequenceDeduplicator::CompareSequenceNumbers("100", "99") > 0);
+	TestTrue(TEXT("123 < 124"), FShardSequenceDeduplicator::CompareSequenceNumbers("123", "124") < 0);
+	TestEqual(TEXT("equal"), FShardSequenceDeduplicator::CompareSequenceNumbers("4200", "4200"), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStreamDeduplicatorRangeTest, "SpacesMarkerManager.StreamDeduplicator.Ranges",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FStreamDeduplicatorRangeTest::RunTest(const FString& Parameters)
+{
+	FShardSequenceDeduplicator Deduplicator;
+	Deduplicator.BeginRun();
+	TestTrue(TEXT("first record is new"), Deduplicator.Accept("100"));
+	TestTrue(TEXT("next record is new"), Deduplicator.Accept("102"));
+	TestFalse(TEXT("same record again is a duplicate"), Deduplicator.Accept("102"));
+	TestTrue(TEXT("a run covers the numbers between its records"), Deduplicator.IsDuplicate("101"));
+	TestFalse(TEXT("numbers after the run are new"), Deduplicator.IsDuplicate("103"));
+
+	// a second run that starts inside the first merges with it
+	Deduplicator.BeginRun();
+	TestFalse(TEXT("re-read record is a duplicate"), Deduplicator.Accept("101"));
+	TestTrue(TEXT("record past the first run is new"), Deduplicator.Accept("200"));
+	TestTrue(TEXT("merged range covers both runs"), Deduplicator.IsDuplicate("150"));
+	TestTrue(TEXT("merged range keeps the first run's start"), Deduplicator.IsDuplicate("100"));
+	TestEqual(TEXT("high watermark"), AwsStringToFString(Deduplicator.GetHighWatermark()), FString(TEXT("200")));
+
+	// a run that starts after a gap stays separate
+	Deduplicator.BeginRun();
+	TestTrue(TEXT("record after a gap is new"), Deduplicator.Accept("300"));
+	TestFalse(TEXT("the gap is not covered"), Deduplicator.IsDuplicate("250"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStreamDeduplicatorEvictionTest, "SpacesMarkerManager.StreamDeduplicator.MaxRanges",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FStreamDeduplicatorEvictionTest::RunTest(const FString& Parameters)
+{
+	// two ranges and a window of one, so an evicted range is not caught by the window either
+	FShardSequenceDeduplicator Deduplicator(2, 1);
+	for (const char* SequenceNumber : {"10", "20", "30"})
+	{
+		Deduplicator.BeginRun();
+		Deduplicator.Accept(SequenceNumber);
+	}
+	TestFalse(TEXT("oldest range is evicted"), Deduplicator.IsDuplicate("10"));
+	TestTrue(TEXT("second range is kept"), Deduplicator.IsDuplicate("20"));
+	TestTrue(TEXT("newest range is kept"), Deduplicator.IsDuplicate("30"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStreamDeduplicatorMergeTest, "SpacesMarkerManager.StreamDeduplicator.Merge",
+                                 EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FStreamDeduplicatorMergeTest::RunTest(const FString& Parameters)
+{
+	FShardSequenceDeduplicator Listener;
+	Listener.BeginRun();
+	Listener.Accept("100");
+	Listener.Accept("200");
+
+	FShardSequenceDeduplicator Replay;
+	Replay.BeginRun();
+	Replay.Accept("150");
+	Replay.Accept("300");
+	Replay.BeginRun();
+	Replay.Accept("500");
+
+	Listener.Merge(Replay);
+	TestTrue(TEXT("overlapping runs merge"), Listener.IsDuplicate("250"));
+	TestTrue(TEXT("start of the own run is kept"), Listener.IsDuplicate("120"));
+	TestTrue(TEXT("separate run is added"), Listener.IsDuplicate("500"));
+	TestFalse(TEXT("gap between runs is not covered"), Listener.IsDuplicate("400"));
+	TestEqual(TEXT("high watermark is the larger one"), AwsStringToFString(Listener.GetHighWatermark()), FString(TEXT("500")));
+
+	// the listener's run carries on from the merged range
+	TestTrue(TEXT("next record is new"), Listener.Accept("350"));
+	TestTrue(TEXT("current run extends the merged range"), Listener.IsDuplicate("340"));
+	TestFalse(TEXT("current run does not reach the separate run"), Listener.IsDuplicate("400"));
+
+	FStreamDeduplicator Stream;
+	Stream.GetShard("shard-a").BeginRun();
+	Stream.GetShard("shard-a").Accept("10");
+	FStreamDeduplicator Other;
+	Other.GetShard("shard-a").BeginRun();
+	Other.GetShard("shard-a").Accept("20");
+	Other.GetShard("shard-b").BeginRun();
+	Other.GetShard("shard-b").Accept("30");
+	Stream.Merge(Other);
+	TestEqual(TEXT("shards of both sides"), Stream.Num(), 2);
+	TestTrue(TEXT("shard a keeps its own record"), Stream.GetShard("shard-a").IsDuplicate("10"));
+	TestTrue(TEXT("shard a gains the other's record"), Stream.GetShard("shard-a").IsDuplicate("20"));
+	TestFalse(TEXT("shards are merged separately"), Stream.GetShard("shard-a").IsDuplicate("30"));
+	TestTrue(TEXT("shard b is added"), Stream.GetShard("shard-b").IsDuplicate("30"));
+	return true;
+}
+
+#endif
@@ -0,0 +1,183 @@
+#include "TrajectoryRenderer.h"
+
+#include "DynamicMarker.h"
+#include "EngineUtils.h"
+#include "MarkerManager.h"
+#include "Algo/BinarySearch.h"
+#include "Components/LineBatchComponent.h"
+
+ATrajectoryRenderer::ATrajectoryRenderer()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+void ATrajectoryRenderer::BeginPlay()
+{
+	Super::BeginPlay();
+	if (GetNetMode() == NM_DedicatedServer)
+	{
+		SetActorTickEnabled(false);
+		return;
+	}
+	// the drawn lines are at positions of the old origin; the histories have been converted, so redraw from them
+	if (UMarkerManager* MarkerManager = Cast<UMarkerManager>(GetGameInstance()))
+	{
+		ReanchoredHandle = MarkerManager->OnMarkersReanchored.AddUObject(this, &ATrajectoryRenderer::ClearTrajectories);
+	}
+}
+
+void ATrajectoryRenderer::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UMarkerManager* MarkerManager = Cast<UMarkerManager>(GetGameInstance()))
+	{
+		MarkerManager->OnMarkersReanchored.Remove(ReanchoredHandle);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void ATrajectoryRenderer::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (Now - LastSampleTime < SampleInterval) return;
+	LastSampleTime = Now;
+	SampleMarkers(Now);
+	TrimAndFade(Now);
+}
+
+ATrajectoryRenderer::FChunk& ATrajectoryRenderer::GetChunkForAppend(const double Now)
+{
+	if (Chunks.Num() > 0 && Now - Chunks.Last().StartTime < ChunkSeconds) return Chunks.Last();
+
+	ULineBatchComponent* Lines;
+	if (FreeLineBatches.Num() > 0)
+	{
+		Lines = FreeLineBatches.Pop(false);
+	}
+	else
+	{
+		Lines = NewObject<ULineBatchComponent>(this);
+		// lines are permanent, so the component has nothing to expire
+		Lines->PrimaryComponentTick.bCanEverTick = false;
+		Lines->SetupAttachment(RootComponent);
+		Lines->RegisterComponent();
+	}
+	UsedLineBatches.Add(Lines);
+
+	FChunk& Chunk = Chunks.AddDefaulted_GetRef();
+	Chunk.Lines = Lines;
+	Chunk.StartTime = Now;
+	Chunk.EndTime = Now;
+	return Chunk;
+}
+
+void ATrajectoryRenderer::SampleMarkers(const double Now)
+{
+	TArray<FBatchedLine> NewLines;
+	TArray<FLinearColor> NewColors;
+	const float MinLengthSquared = MinSegmentLength * MinSegmentLength;
+	for (TActorIterator<ADynamicMarker> It(GetWorld()); It; ++It)
+	{
+		ADynamicMarker* Marker = *It;
+		const TArray<FLocationTs>& History = Marker->HistoryArr;
+		// the marker is on its way to LocationTs, so the history before it has been passed
+		const FDateTime Target = Marker->LocationTs.Timestamp;
+		FTrail* Trail = Trails.Find(Marker);
+		if (Trail == nullptr)
+		{
+			Trail = &Trails.Add(Marker);
+			Trail->LastTimestamp = Target - FTimespan::FromSeconds(TrailSeconds);
+		}
+
+		const FLinearColor Color = Marker->DynamicMarkerColor;
+		const auto AddPoint = [&](const FVector& Point)
+		{
+			if (!Trail->HasPoint)
+			{
+				Trail->LastPoint = Point;
+				Trail->HasPoint = true;
+				return;
+			}
+			if (FVector::DistSquared(Trail->LastPoint, Point) < MinLengthSquared) return;
+			NewLines.Emplace(Trail->LastPoint, Point, Color, 0.0f, LineThickness, SDPG_World);
+			NewColors.Add(Color);
+			Trail->LastPoint = Point;
+		};
+
+		int32 Next = Algo::UpperBoundBy(History, Trail->LastTimestamp, [](const FLocationTs& Location) { return Location.Timestamp; });
+		for (; Next < History.Num() && History[Next].Timestamp < Target; Next++)
+		{
+			AddPoint(History[Next].UECoordinate);
+			Trail->LastTimestamp = History[Next].Timestamp;
+		}
+		// CurrentLocation rather than the actor, which stands still while the marker is hidden
+		AddPoint(Marker->CurrentLocation);
+	}
+
+	// forget destroyed markers
+	for (auto It = Trails.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid()) It.RemoveCurrent();
+	}
+
+	if (NewLines.Num() == 0) return;
+	FChunk& Chunk = GetChunkForAppend(Now);
+	Chunk.Lines->DrawLines(NewLines);
+	Chunk.BaseColors.Append(NewColors);
+	Chunk.EndTime = Now;
+}
+
+void ATrajectoryRenderer::TrimAndFade(const double Now)
+{
+	// chunks are ordered by time, so expired ones are at the front
+	int32 Expired = 0;
+	while (Expired < Chunks.Num() && Now - Chunks[Expired].EndTime > TrailSeconds)
+	{
+		Chunks[Expired].Lines->Flush();
+		UsedLineBatches.RemoveSingleSwap(Chunks[Expired].Lines, false);
+		FreeLineBatches.Add(Chunks[Expired].Lines);
+		Expired++;
+	}
+	if (Expired > 0) Chunks.RemoveAt(0, Expired, false);
+
+	if (!FadeByAge || FadeSteps <= 0 || TrailSeconds <= 0.0f) return;
+	for (FChunk& Chunk : Chunks)
+	{
+		// fade by the age of the middle of the chunk, a few times per chunk life
+		const double Age = Now - 0.5 * (Chunk.StartTime + Chunk.EndTime);
+		const int32 FadeStep = FMath::Clamp(FMath::FloorToInt(Age / TrailSeconds * FadeSteps), 0, FadeSteps);
+		if (FadeStep == Chunk.FadeStep) continue;
+		Chunk.FadeStep = FadeStep;
+
+		const float Alpha = static_cast<float>(FadeStep) / FadeSteps;
+		TArray<FBatchedLine>& Lines = Chunk.Lines->BatchedLines;
+		for (int32 i = 0; i < Lines.Num() && i < Chunk.BaseColors.Num(); i++)
+		{
+			Lines[i].Color = FMath::Lerp(Chunk.BaseColors[i], FadeColor, Alpha);
+		}
+		Chunk.Lines->MarkRenderStateDirty();
+	}
+}
+
+void ATrajectoryRenderer::ClearTrajectories()
+{
+	for (const FChunk& Chunk : Chunks)
+	{
+		Chunk.Lines->Flush();
+		FreeLineBatches.Add(Chunk.Lines);
+	}
+	Chunks.Reset();
+	UsedLineBatches.Reset();
+	Trails.Reset();
+}
+
+int ATrajectoryRenderer::GetSegmentCount() const
+{
+	int Count = 0;
+	for (const FChunk& Chunk : Chunks)
+	{
+		Count += Chunk.BaseColors.Num();
+	}
+	return Count;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Hash/CityHash.h"
+#include "aws/core/utils/memory/stl/AWSString.h"
+#include <cstdio>
+#include <cstdlib>
+
+
+/*
+ * Strings that come from or go to DynamoDB stay UTF-8 Aws::String from the SDK to the marker records,
+ * and are only converted to FString where they reach actors, Blueprints or logs.
+ * Numbers are formatted into and parsed from Aws::String in place. Timestamps and coordinates
+ * are shorter than the small string buffer of Aws::String, so formatting them does not allocate.
+ */
+
+namespace Aws
+{
+	// Allows Aws::String as a TMap or TSet key. Found by argument-dependent lookup.
+	inline uint32 GetTypeHash(const Aws::String& String)
+	{
+		return CityHash32(String.data(), String.size());
+	}
+}
+
+inline Aws::String FStringToAwsString(const FString& String)
+{
+	return Aws::String(TCHAR_TO_UTF8(*String));
+}
+
+inline FString AwsStringToFString(const Aws::String& String)
+{
+	return FString(UTF8_TO_TCHAR(String.c_str()));
+}
+
+inline Aws::String AwsStringFromInt64(const int64 Value)
+{
+	char Buffer[24];
+	const int Length = std::snprintf(Buffer, sizeof(Buffer), "%lld", static_cast<long long>(Value));
+	return Aws::String(Buffer, Length);
+}
+
+/* Fixed 8 decimals, about 1 mm for degrees of latitude and longitude */
+inline Aws::String AwsStringFromDouble(const double Value)
+{
+	char Buffer[48];
+	const int Length = std::snprintf(Buffer, sizeof(Buffer), "%.8f", Value);
+	return Aws::String(Buffer, FMath::Clamp(Length, 0, static_cast<int>(sizeof(Buffer)) - 1));
+}
+
+inline int64 AwsStringToInt64(const Aws::String& String)
+{
+	return std::strtoll(String.c_str(), nullptr, 10);
+}
+
+inline double AwsStringToDouble(const Aws::String& String)
+{
+	return std::strtod(String.c_str(), nullptr);
+}
+
+inline bool AwsStringEqualsIgnoreCase(const Aws::String& A, const Aws::String& B)
+{
+	return A.size() == B.size() && FCStringAnsi::Strnicmp(A.c_str(), B.c_str(), A.size()) == 0;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LocationTs.h"
+
+/* Derives the UE and ECEF coordinates of a WGS84 location, as UMarkerManager::WrapLocationTs() does */
+using FLocationTsFromWgs84 = TFunction<FLocationTs(const FDateTime, const FVector&)>;
+
+
+/*
+ * A device's locations sorted by timestamp, stored in encoded blocks of BlockSize samples instead of FLocationTs.
+ * Each block keeps only the timestamps and one coordinate per sample, since the other two can be derived:
+ * - timestamps as zigzag varint delta-of-deltas, in the coarsest of seconds, ms, us or ticks that is exact for the block
+ * - WGS84 as varint deltas of 1e-8 degree and millimeter fixed point, or the UE coordinates at the same steps without
+ *   a georeference, where they hold the WGS84 location as read
+ * Samples are decoded on access, and WGS84 blocks derive the UE and ECEF coordinates with the given FLocationTsFromWgs84.
+ * Quantization stays around a millimeter on either path; blocks whose samples fit neither form keep plain FLocationTs.
+ * The newest samples wait in a plain tail until there are two blocks' worth, so late arrivals rarely touch an encoded block.
+ * About 8 bytes per sample for a day of once a second samples, against 88 for an int64 timestamp and an FLocationTs;
+ * see the BytesPerSample automation test.
+ */
+class SPACESMARKERMANAGER_API FCompactTrajectory
+{
+public:
+	static constexpr int32 BlockSize = 128;
+
+	/**
+	 * Add a location, in timestamp order or not.
+	 * @param Location
+	 * @param FromWgs84 Null when there is no georeference; blocks then keep UE coordinates.
+	 * @returns False if a location with the same timestamp is already stored.
+	 **/
+	bool Add(const FLocationTs& Location, const FLocationTsFromWgs84* FromWgs84);
+
+	/* Index of the first location at or after Ticks, or after Ticks for UpperBound() */
+	int32 LowerBound(const int64 Ticks) const;
+	int32 UpperBound(const int64 Ticks) const;
+
+	int64 GetTicks(const int32 Index) const;
+	FLocationTs Get(const int32 Index, const FLocationTsFromWgs84* FromWgs84) const;
+
+	/**
+	 * The latest location at or before Ticks, and the first one after it, walking the block that holds them once.
+	 * @param Ticks
+	 * @param MinTicks The latest location must be at or after this, or nothing is decoded.
+	 * @param FromWgs84
+	 * @param WithNext Also decode the location after Ticks, if there is one.
+	 * @param OutLatest
+	 * @param OutNext
+	 * @returns False if there is no location in [MinTicks, Ticks].
+	 **/
+	bool GetAround(const int64 Ticks, const int64 MinTicks, const FLocationTsFromWgs84* FromWgs84, const bool WithNext,
+	               FLocationTs& OutLatest, TOptional<FLocationTs>& OutNext) const;
+
+	/* Decode the locations [First, End), each block once */
+	void GetRange(const int32 First, const int32 End, const FLocationTsFromWgs84* FromWgs84, TArray<FLocationTs>& OutLocations) const;
+	void GetAllTicks(TArray<int64>& OutTicks) const;
+
+	/* Drop the Count oldest locations */
+	void RemoveFirst(const int32 Count, const FLocationTsFromWgs84* FromWgs84);
+	void Reset();
+
+	int32 Num() const { return SealedCount + Tail.Num(); }
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	enum class EEncoding : uint8
+	{
+		Geodetic,
+		Unreal,
+		Plain
+	};
+
+	struct FBlock
+	{
+		int64 FirstTicks = 0;
+		int64 LastTicks = 0;
+		// Index of the block's first location in the trajectory
+		int32 Start = 0;
+		int32 Count = 0;
+		EEncoding Encoding = EEncoding::Plain;
+		// Index into the time units, coarsest first
+		uint8 TimeUnit = 0;
+		int64 Origin[3] = {0, 0, 0};
+		TArray<uint8> Data;
+		// Only for EEncoding::Plain
+		TArray<FLocationTs> Locations;
+	};
+
+	struct FReader;
+
+	static void Encode(FBlock& Block, const FLocationTs* Locations, const int32 Count, const FLocationTsFromWgs84* FromWgs84);
+	static void Decode(const FBlock& Block, const FLocationTsFromWgs84* FromWgs84, const int32 First, const int32 End,
+	                   TArray<FLocationTs>& OutLocations);
+	/* Index in the block of the first location at or after Ticks, or after it if After is set */
+	static int32 FindInBlock(const FBlock& Block, const int64 Ticks, const bool After);
+	int32 FindBlock(const int32 Index) const;
+	void UpdateStarts(const int32 FirstBlock);
+	void SealTail(const FLocationTsFromWgs84* FromWgs84);
+
+	TArray<FBlock> Blocks;
+	int32 SealedCount = 0;
+	// Newer than every encoded location, sorted
+	TArray<FLocationTs> Tail;
+};
@@ -25,8 +25,35 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Spaces|Marker|Dynamic")
 	float InterpolationsPerSecond = 500.0f;
 
+	/* Seconds between ticks at the Near significance; farther tiers tick at a multiple of this */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Spaces|Marker|Dynamic")
+	float BaseTickInterval = 0.01f;
+
+	/* Where the marker is along its history. The actor follows it unless the marker is Hidden. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Spaces|Marker|Dynamic")
+	FVector CurrentLocation = FVector::ZeroVector;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Marker|Dynamic")
-	TArray<FLocationTs> HistoryArr; // heap
+	TArray<FLocationTs> HistoryArr; // sorted by timestamp, which also makes it a valid heap
+
+	/* Locations within this distance of the simplified path are dropped from the history. 0 keeps every location. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Marker|Dynamic|Decimation")
+	float DecimationToleranceMeters = 1.0f;
+
+	/*
+	 * Locations this recent, relative to the latest one, are kept at full resolution.
+	 * Each doubling of age beyond this doubles the tolerance, up to 16 times DecimationToleranceMeters.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Marker|Dynamic|Decimation")
+	float DecimationFullResolutionSeconds = 600.0f;
+
+	/* Number of added locations between two decimation passes */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Marker|Dynamic|Decimation")
+	int DecimationInterval = 64;
+
+	/* Replicate this actor and its movement. False while an AMarkerReplicator replicates all markers instead. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Spaces|Marker|Dynamic")
+	bool ReplicateAsActor = true;
 
 protected:
 	virtual void BeginPlay() override;
@@ -36,7 +63,44 @@ public:
 	virtual TSharedRef<FJsonObject> ToJsonObject() const override;
 	virtual FString ToString() const override;
 	virtual FString ToJsonString() const override;
+	virtual void SetSignificance(const EMarkerSignificance InSignificance, const int32 UpdateRateDivisor) override;
 
 	UFUNCTION(BlueprintCallable, Category="Spaces|Marker|Dynamic")
 	void AddLocationTs(const FLocationTs Location);
+
+	/**
+	* Append several locations at once. Cheaper than calling AddLocationTs() per location,
+	* since the history is only re-ordered when the new locations are older than the latest one.
+	* @param Locations Expected to be sorted by timestamp.
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|Marker|Dynamic")
+	void AddLocationTsBatch(const TArray<FLocationTs>& Locations);
+
+	/* Jump to the latest location of the history, as if the marker had followed all of it, and schedule its expiry */
+	UFUNCTION(BlueprintCallable, Category="Spaces|Marker|Dynamic")
+	void SkipToLatestLocation();
+
+	/**
+	* Thin out the history with Douglas-Peucker, leaving recent locations at full resolution
+	* and using a larger tolerance the older a location is. The current target location is always kept.
+	* Called automatically every DecimationInterval added locations.
+	* @returns Number of locations removed
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|Marker|Dynamic|Decimation")
+	int DecimateHistory();
+
+protected:
+	// Locations added since the last decimation pass
+	int32 LocationsSinceDecimation = 0;
+
+	void OnLocationsAdded(const int32 Count);
+
+	/* Move CurrentLocation along the history by DeltaTime worth of interpolation, across as many locations as it covers */
+	void AdvanceLocation(const float DeltaTime);
+
+	/**
+	* Make the next history location the target, or the previous one for a negative DeltaTime.
+	* @returns False at the end of the history.
+	**/
+	bool StepHistory(const float DeltaTime);
 };
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "DynamoDBAsyncAction.generated.h"
+
+class ALocationMarker;
+class UMarkerManager;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FDynamoDBAsyncActionResult, bool, Success, FVector, Location);
+
+/*
+ * Blueprint async nodes for the DynamoDB functions of UMarkerManager.
+ * Each node returns immediately, and fires OnSuccess or OnFailure on the game thread when the request completes.
+ * Location is only set by GetLatestRecordAsync, and is a zero vector otherwise.
+ */
+UCLASS()
+class SPACESMARKERMANAGER_API UDynamoDBAsyncAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintAssignable)
+	FDynamoDBAsyncActionResult OnSuccess;
+
+	UPROPERTY(BlueprintAssignable)
+	FDynamoDBAsyncActionResult OnFailure;
+
+	/* Asynchronous version of UMarkerManager::CreateMarkerInDB() */
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Async", meta=(BlueprintInternalUseOnly="true", WorldContext="WorldContextObject"))
+	static UDynamoDBAsyncAction* CreateMarkerInDBAsync(UObject* WorldContextObject, const ALocationMarker* Marker);
+
+	/* Asynchronous version of UMarkerManager::DeleteMarkerFromDynamoDB() */
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Async", meta=(BlueprintInternalUseOnly="true", WorldContext="WorldContextObject"))
+	static UDynamoDBAsyncAction* DeleteMarkerFromDynamoDBAsync(UObject* WorldContextObject, const FString DeviceID, const FDateTime Timestamp);
+
+	/* Asynchronous version of UMarkerManager::GetLatestRecord(). Fails if there is no location newer than LastKnownTimestamp. */
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Async", meta=(BlueprintInternalUseOnly="true", WorldContext="WorldContextObject"))
+	static UDynamoDBAsyncAction* GetLatestRecordAsync(UObject* WorldContextObject, const FString DeviceID, const FDateTime LastKnownTimestamp);
+
+	/* Asynchronous version of UMarkerManager::GetAllMarkersFromDynamoDB(). Succeeds once the markers are queued for spawning. */
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Async", meta=(BlueprintInternalUseOnly="true", WorldContext="WorldContextObject"))
+	static UDynamoDBAsyncAction* GetAllMarkersFromDynamoDBAsync(UObject* WorldContextObject, const bool StaticMarkersOnly = true);
+
+	virtual void Activate() override;
+
+private:
+	static UDynamoDBAsyncAction* Create(UObject* WorldContextObject, TFunction<void(UMarkerManager*, UDynamoDBAsyncAction*)>&& InOperation);
+
+	void Finish(const bool Success, const FVector Location);
+
+	UPROPERTY()
+	UObject* WorldContext;
+
+	TFunction<void(UMarkerManager*, UDynamoDBAsyncAction*)> Operation;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ATemporaryMarker;
+
+
+/*
+ * Hierarchical timing wheel that expires temporary markers in batches, instead of one lifespan timer per actor.
+ * Time is divided into ticks of TickSeconds. Level 0 has one slot per tick for the next 64 ticks,
+ * and each higher level has 64 slots that each cover all of the level below. When a level wraps,
+ * the next slot of the level above is cascaded down, so scheduling and expiring are O(1) per marker.
+ * With the default 0.1 s tick, the four levels reach about 19 days ahead; later expiries are clamped.
+ * Cancelled markers are not looked up: each entry carries the marker's expiry generation,
+ * and entries whose generation no longer matches are dropped when they fire.
+ */
+class SPACESMARKERMANAGER_API FExpiryTimingWheel
+{
+public:
+	struct FEntry
+	{
+		TWeakObjectPtr<ATemporaryMarker> Marker;
+		uint32 Generation = 0;
+		uint64 ExpireTick = 0;
+	};
+
+	explicit FExpiryTimingWheel(const double InTickSeconds = 0.1);
+
+	/* Drop every entry and restart at Now, for example when a new world starts its clock at zero */
+	void Reset(const double Now);
+
+	/**
+	 * @param Marker
+	 * @param Generation The marker's expiry generation, see ATemporaryMarker::ScheduleExpiry()
+	 * @param ExpireAt World time in seconds. Times in the past expire on the next tick.
+	 **/
+	void Schedule(ATemporaryMarker* Marker, const uint32 Generation, const double ExpireAt);
+
+	/**
+	 * Advance to Now and collect the entries that expired on the way.
+	 * @param Now World time in seconds
+	 * @param OutExpired Appended with expired entries, including stale ones
+	 **/
+	void Advance(const double Now, TArray<FEntry>& OutExpired);
+
+	/* Visit every scheduled entry, including stale ones */
+	void ForEach(const TFunctionRef<void(const FEntry&)> Visitor) const;
+
+	/* World time the wheel has advanced to */
+	double GetTime() const { return CurrentTick * TickSeconds; }
+
+	int32 Num() const { return Count; }
+
+private:
+	static constexpr int32 NumLevels = 4;
+	static constexpr int32 SlotBits = 6;
+	static constexpr int32 NumSlots = 1 << SlotBits;
+	static constexpr uint64 SlotMask = NumSlots - 1;
+
+	void Insert(FEntry&& Entry);
+
+	double TickSeconds;
+	uint64 CurrentTick = 0;
+	int32 Count = 0;
+	TArray<FEntry> Slots[NumLevels][NumSlots];
+};
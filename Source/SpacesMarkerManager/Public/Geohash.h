@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/*
+ * Geohash encoding of WGS84 coordinates, used as the tile key for region streaming.
+ * A geohash of precision P is a cell of 5 * P bits, alternating longitude and latitude,
+ * so every character added divides a cell into 32 smaller cells.
+ * Precision 4 is about 39 km x 20 km at the equator, precision 5 is about 5 km x 5 km.
+ */
+class SPACESMARKERMANAGER_API FGeohash
+{
+public:
+	/**
+	 * @param Lat Latitude in degrees
+	 * @param Lon Longitude in degrees
+	 * @param Precision Number of characters
+	 * @returns Geohash of the cell containing the coordinate
+	 **/
+	static FString Encode(const double Lat, const double Lon, const int32 Precision);
+
+	/* Size of a cell of the given precision in degrees */
+	static void GetCellSize(const int32 Precision, double& OutLatDegrees, double& OutLonDegrees);
+
+	/**
+	 * @param Hash Geohash of a cell
+	 * @param Precision Number of characters, at least the length of Hash
+	 * @returns Geohashes of all the cells of the given precision inside the cell
+	 **/
+	static TArray<FString> Expand(const FString& Hash, const int32 Precision);
+
+	/**
+	 * Find all cells that overlap a square of RadiusMeters around a coordinate.
+	 * Near the poles and for large radii the square spans many cells, so the precision is lowered one
+	 * character at a time until at most MaxCells cells cover it. The result can hence be coarser than Precision.
+	 * @param Lat Latitude in degrees
+	 * @param Lon Longitude in degrees
+	 * @param RadiusMeters
+	 * @param Precision
+	 * @param MaxCells The result is truncated to this many cells, nearest first, if even precision 1 needs more.
+	 * @returns Geohashes of the overlapping cells
+	 **/
+	static TArray<FString> CoverRadius(const double Lat, const double Lon, const double RadiusMeters,
+	                                   const int32 Precision, const int32 MaxCells = 1024);
+};
@@ -113,6 +113,10 @@ public:
 	**/
 	UFUNCTION(BlueprintCallable, Category="Spaces|Marker")
 	bool ToggleSelection();
+
+	/* Select or unselect this marker without logging, for selecting many markers at once */
+	UFUNCTION(BlueprintCallable, Category="Spaces|Marker")
+	void SetSelected(const bool InSelected);
 	
 	UFUNCTION(BlueprintCallable, Category="Spaces|Marker")
 	FLinearColor GetColor() const;
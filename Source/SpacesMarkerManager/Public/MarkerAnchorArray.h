@@ -0,0 +1,38 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ALocationMarker;
+
+
+/*
+ * ECEF coordinates of the markers that stay where they were spawned, in one contiguous array.
+ * When the georeference origin moves, UMarkerManager converts all of them to UE coordinates
+ * with one parallel pass over the array, instead of every marker's globe anchor doing its own transform.
+ * Removal swaps the last entry into the gap, so the array stays dense.
+ * Game thread only, apart from the read-only Transform().
+ */
+class SPACESMARKERMANAGER_API FMarkerAnchorArray
+{
+public:
+	void Add(const FString& DeviceID, ALocationMarker* Marker, const FVector& EcefCoordinate);
+	void Remove(const FString& DeviceID);
+	void Reset();
+
+	/**
+	 * Convert every ECEF coordinate to UE coordinates, in parallel.
+	 * @param EcefToUnreal Affine transform from ECEF meters to UE world coordinates.
+	 * @param OutLocations Same order as GetMarkers().
+	 **/
+	void Transform(const FMatrix& EcefToUnreal, TArray<FVector>& OutLocations) const;
+
+	const TArray<TWeakObjectPtr<ALocationMarker>>& GetMarkers() const { return Markers; }
+	int32 Num() const { return EcefCoordinates.Num(); }
+
+private:
+	TArray<FVector> EcefCoordinates;
+	// Same order as EcefCoordinates
+	TArray<TWeakObjectPtr<ALocationMarker>> Markers;
+	TArray<FString> DeviceIDs;
+	TMap<FString, int32> Index;
+};
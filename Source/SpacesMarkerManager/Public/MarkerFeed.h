@@ -0,0 +1,222 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "MarkerRecord.h"
+#include "StreamDeduplicator.h"
+#include "aws/core/auth/AWSCredentials.h"
+#include "aws/dynamodbstreams/DynamoDBStreamsClient.h"
+#include "MarkerFeed.generated.h"
+
+class FRunnableThread;
+class FEvent;
+
+
+/*
+ * A DynamoDB table whose stream is followed by a marker feed.
+ */
+USTRUCT(BlueprintType)
+struct SPACESMARKERMANAGER_API FMarkerFeedConfig
+{
+	GENERATED_BODY()
+
+	/* Used in logs and in UMarkerManager::GetMarkerFeedStatus() */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Feed")
+	FString Name;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Feed")
+	FString TableName;
+
+	/* AWS region of the table, for example "us-west-2". Empty uses SpacesAwsRegion from Settings.h. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Feed")
+	FString Region;
+
+	/* Seconds between polls of every shard */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Feed")
+	float PollingInterval = 2.0f;
+
+	/* Seconds between DescribeStream calls that pick up new and closed shards */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Feed")
+	float TopologyRefreshInterval = 60.0f;
+
+	/* Start at the oldest record of each shard, which replays the last 24 hours, instead of at the latest */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Feed")
+	bool StartFromTrimHorizon = false;
+
+	/* GetRecords calls per shard per poll, so one busy shard cannot starve the others */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Feed")
+	int MaxPagesPerShard = 8;
+
+	/* Decoded records the feed may hold for the game thread. Shard reads pause while the queue is this full. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Feed")
+	int MaxQueuedRecords = 100000;
+};
+
+
+USTRUCT(BlueprintType)
+struct SPACESMARKERMANAGER_API FMarkerFeedStatus
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Feed")
+	FString Name;
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Feed")
+	FString TableName;
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Feed")
+	bool Running = false;
+
+	/* Open shards currently being read */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Feed")
+	int ShardCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Feed")
+	int RecordsReceived = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Feed")
+	int DuplicateRecordsDropped = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Feed")
+	int Errors = 0;
+
+	/* Decoded records waiting for the game thread */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Feed")
+	int QueuedRecords = 0;
+
+	/* Shard polls skipped because the queue was full */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Feed")
+	int PausedShardReads = 0;
+};
+
+
+/*
+ * Occupancy of the ingest queues and what overload shedding has dropped, see UMarkerManager::GetIngestStatus().
+ */
+USTRUCT(BlueprintType)
+struct SPACESMARKERMANAGER_API FMarkerIngestStatus
+{
+	GENERATED_BODY()
+
+	/* Decoded records waiting in the queues of all marker feeds */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Overload")
+	int FeedQueuedRecords = 0;
+
+	/* Devices with updates waiting to be applied */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Overload")
+	int PendingBatches = 0;
+
+	/* Stream locations held by the reorder buffer */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Overload")
+	int ReorderHeldLocations = 0;
+
+	/* Stream locations that arrived behind what their device had already released */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Overload")
+	int LateLocations = 0;
+
+	/* Locations waiting to be applied, out of MaxPendingLocations */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Overload")
+	int PendingLocations = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Overload")
+	int MaxPendingLocations = 0;
+
+	/* True while stream reads are paused because the apply queue is full */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Overload")
+	bool ReadsPaused = false;
+
+	/* Queued locations dropped by keeping only one location per device */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Overload")
+	int LocationsCoalesced = 0;
+
+	/* Queued temporary marker updates dropped */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Overload")
+	int TemporaryBatchesDropped = 0;
+
+	/* Queued updates of the devices farthest from the camera dropped as a last resort */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Overload")
+	int FarthestBatchesDropped = 0;
+};
+
+
+/*
+ * Follows the stream of one DynamoDB table on a worker thread of its own.
+ * A feed has its own client, stream topology, shard iterators and per-shard checkpoints.
+ * Shards are read one after the other on that thread, so the blocking AWS calls never occupy task graph workers;
+ * ingest scales by running one feed per table.
+ * Decoded records are queued for the game thread, which converts them with the georeference
+ * and merges them into the marker registry of UMarkerManager. See UMarkerManager::StartMarkerFeeds().
+ * The checkpoints live only as long as the feed: a feed started again begins at StartFromTrimHorizon or at the latest
+ * record, so records written while no feed ran are only picked up by a replay or fast-forward.
+ */
+class SPACESMARKERMANAGER_API FMarkerFeed : public FRunnable
+{
+public:
+	FMarkerFeed(const FMarkerFeedConfig& InConfig, const Aws::Auth::AWSCredentials& Credentials);
+	virtual ~FMarkerFeed() override;
+
+	/* Start the worker thread */
+	void Start();
+
+	/* Stop the worker thread and wait for it to exit */
+	void Shutdown();
+
+	/**
+	 * Take the next decoded record. Call from the game thread only.
+	 * @param OutRecord
+	 * @returns False if the queue is empty.
+	 **/
+	bool Dequeue(FRawMarkerRecord& OutRecord);
+
+	FMarkerFeedStatus GetStatus() const;
+
+	const FMarkerFeedConfig& GetConfig() const { return Config; }
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	struct FShardState
+	{
+		Aws::String ShardId;
+		Aws::String Iterator;
+		// Sequence numbers already seen, and the checkpoint to resume from when the iterator expires
+		FShardSequenceDeduplicator Deduplicator;
+		// Where to start if the iterator has to be recreated before anything was read
+		Aws::DynamoDBStreams::Model::ShardIteratorType InitialIteratorType = Aws::DynamoDBStreams::Model::ShardIteratorType::TRIM_HORIZON;
+		// Set once a closed shard has been read to the end
+		bool Finished = false;
+	};
+
+	void RefreshTopology();
+	void PollShard(FShardState& Shard);
+	bool CreateIterator(FShardState& Shard, const Aws::DynamoDBStreams::Model::ShardIteratorType IteratorType);
+
+	FMarkerFeedConfig Config;
+	Aws::String TableName;
+	TUniquePtr<Aws::DynamoDBStreams::DynamoDBStreamsClient> Client;
+
+	// Worker thread state
+	Aws::String StreamArn;
+	TArray<TUniquePtr<FShardState>> Shards;
+	TSet<Aws::String> FinishedShards;
+	double LastTopologyRefresh = 0.0;
+	bool TopologyKnown = false;
+
+	// Written by the worker thread, read by the game thread
+	TQueue<FRawMarkerRecord, EQueueMode::Spsc> Records;
+	FThreadSafeCounter RecordsReceived;
+	FThreadSafeCounter DuplicateRecordsDropped;
+	FThreadSafeCounter Errors;
+	FThreadSafeCounter ShardCount;
+	FThreadSafeCounter QueuedRecords;
+	FThreadSafeCounter PausedShardReads;
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeEvent = nullptr;
+	FThreadSafeBool Stopping = false;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LocationMarker.h"
+#include "LocationTs.h"
+
+
+/*
+ * Latest location of every replicated device, bucketed into cubic cells of UE space.
+ * With a georeference, UE space is a Cartesian frame around the origin, not a projection of WGS84, and the globe curves
+ * away in Z, so cells are 3D: places on the far side of the globe, or at another height, never share a cell with the view.
+ * Every change bumps a version counter, stored on the device and on the cells it left and entered,
+ * so a client replicator can find what changed in a cell since it last looked without scanning every device.
+ * Owned by UMarkerManager on the server and read by every AMarkerReplicator.
+ */
+class SPACESMARKERMANAGER_API FMarkerInterestGrid
+{
+public:
+	struct FDevice
+	{
+		ELocationMarkerType MarkerType = ELocationMarkerType::Static;
+		FLocationTs LocationTs;
+		FIntVector Cell = FIntVector::ZeroValue;
+		uint64 Version = 0;
+	};
+
+	struct FCell
+	{
+		TSet<FString> DeviceIDs;
+		// Sum of the UE coordinates of the devices, for the centroid of aggregated cells
+		FVector LocationSum = FVector::ZeroVector;
+		uint64 Version = 0;
+
+		FVector GetCentroid() const { return DeviceIDs.Num() > 0 ? LocationSum / DeviceIDs.Num() : FVector::ZeroVector; }
+	};
+
+	explicit FMarkerInterestGrid(const double InCellSize = 500000.0);
+
+	/* Remove every device, and change the cell size */
+	void Reset(const double InCellSize);
+
+	FIntVector GetCell(const FVector& UECoordinate) const;
+
+	/* Chebyshev distance between two cells over all three axes, in cells */
+	static int32 GetCellDistance(const FIntVector& A, const FIntVector& B);
+
+	/**
+	 * Add a device, or move it to a newer location. Older locations are ignored.
+	 * @param DeviceID
+	 * @param MarkerType
+	 * @param LocationTs
+	 **/
+	void Upsert(const FString& DeviceID, const ELocationMarkerType MarkerType, const FLocationTs& LocationTs);
+
+	void Remove(const FString& DeviceID);
+
+	/* Recompute every device's UE coordinates from its ECEF coordinates, after the georeference moved, and rebuild the cells */
+	void Reanchor(const FMatrix& EcefToUnreal);
+
+	const FDevice* FindDevice(const FString& DeviceID) const { return Devices.Find(DeviceID); }
+	const FCell* FindCell(const FIntVector& Cell) const { return Cells.Find(Cell); }
+
+	/* Non-empty cells */
+	const TMap<FIntVector, FCell>& GetCells() const { return Cells; }
+
+	int32 GetDeviceCount() const { return Devices.Num(); }
+
+private:
+	uint64 NextVersion() { return ++Version; }
+
+	double CellSize;
+	TMap<FString, FDevice> Devices;
+	TMap<FIntVector, FCell> Cells;
+	uint64 Version = 0;
+};
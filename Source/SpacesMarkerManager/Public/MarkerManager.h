@@ -2,16 +2,43 @@
 
 #include "CoreMinimal.h"
 #include "CesiumGeoreference.h"
+#include "Containers/Ticker.h"
+#include "Async/Future.h"
 #include "LocationMarker.h"
 #include "Utils.h"
+#include "ExpiryTimingWheel.h"
+#include "MarkerAnchorArray.h"
 #include "LocationTs.h"
+#include "MarkerFeed.h"
+#include "MarkerPickingGrid.h"
+#include "MarkerInterestGrid.h"
+#include "MarkerQuery.h"
+#include "MarkerReconcile.h"
+#include "MarkerRecord.h"
+#include "MarkerReorderBuffer.h"
+#include "MarkerReplicator.h"
+#include "MarkerTemporalStore.h"
+#include "StreamDeduplicator.h"
+#include "TemporaryMarker.h"
 #include "aws/dynamodb/DynamoDBClient.h"
+#include "aws/dynamodb/model/DeleteItemRequest.h"
+#include "aws/dynamodb/model/PutItemRequest.h"
+#include "aws/dynamodb/model/QueryRequest.h"
+#include "aws/dynamodb/model/ScanRequest.h"
 #include "aws/dynamodbstreams/DynamoDBStreamsClient.h"
 #include "MarkerManager.generated.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogMarkerManager, Display, All);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FMarkerManagerAwsReady);
+DECLARE_MULTICAST_DELEGATE_OneParam(FMarkerManagerBatchApplied, const FMarkerRecordBatch&);
+DECLARE_MULTICAST_DELEGATE(FMarkerManagerReanchored);
 
 class ALocationMarker;
+class ATemporaryMarker;
+class AGameModeBase;
+class AController;
+class APlayerController;
+class FUnrealAwsExecutor;
 
 UCLASS(Blueprintable, BlueprintType)
 class SPACESMARKERMANAGER_API UMarkerManager : public UGameInstance
@@ -19,6 +46,10 @@ class SPACESMARKERMANAGER_API UMarkerManager : public UGameInstance
 	GENERATED_BODY()
 	
 public:
+	/* Copy of the current shard iterator for Blueprints, updated once per page read. Reads use ShardIteratorAws. */
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category="Spaces|MarkerManager")
+	FString ShardIterator = "";
+
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category="Spaces|MarkerManager")
 	int NumberOfEmptyShards = 0;
 
@@ -28,8 +59,9 @@ public:
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category="Spaces|MarkerManager")
 	bool Listening = false;
 	
+	/* Number of stream records dropped because their sequence number had already been processed */
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category="Spaces|MarkerManager")
-	FString ShardIterator = "";
+	int DuplicateRecordsDropped = 0;
 
 	/* Length between each successive call to DynamoDBStreamsListen() */
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="Spaces|MarkerManager")
@@ -41,20 +73,441 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Spaces|MarkerManager")
 	ACesiumGeoreference* Georeference;
 
+	/*
+	 * Re-anchor markers from the manager when the georeference origin changes, in one parallel pass,
+	 * instead of giving every marker a UCesiumGlobeAnchorComponent that updates on its own.
+	 * Applies to markers spawned while it is set.
+	 */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="Spaces|MarkerManager")
+	bool BatchedReanchoring = true;
+
+	/* Send a cheap DescribeTable as soon as the clients exist, so the first real request finds an open connection */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="Spaces|MarkerManager")
+	bool WarmAwsConnections = true;
+
+	/* Time up to which markers have been loaded by GetAllMarkersFromDynamoDB() or SyncMarkersSince() */
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category="Spaces|MarkerManager")
+	FDateTime LastSyncTimestamp = FDateTime::MinValue();
+
+	/* When true, only markers in tiles around the camera are loaded. See SetRegionStreaming() */
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category="Spaces|MarkerManager|Region")
+	bool RegionStreaming = false;
+
+	/* Tiles within this distance of the camera's WGS84 position are loaded */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Region")
+	float RegionStreamingRadiusMeters = 50000.0f;
+
+	/* Seconds between checks of which tiles are in range */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="Spaces|MarkerManager|Region")
+	float RegionStreamingInterval = 1.0f;
+
+	/* Number of tiles whose query results are kept in memory after being unloaded */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="Spaces|MarkerManager|Region")
+	int TileCacheCapacity = 256;
+
+	/* Seconds a tile's cached query result is reused. Older results are read from DynamoDB again. */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="Spaces|MarkerManager|Region")
+	float TileCacheSeconds = 300.0f;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Spaces|MarkerManager|Region")
+	FTimerHandle RegionStreamingTimerHandle;
+
+	/* Time in milliseconds that may be spent per frame on spawning and updating queued markers. At least one queued update is applied per frame. */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager")
+	float SpawnBudgetMilliseconds = 2.0f;
+
+	/* Distance the camera has to move before queued markers are re-prioritized by distance to the camera */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager")
+	float ReprioritizeDistance = 10000.0f;
+
+	/* Tables followed by StartMarkerFeeds(). If empty, a single feed follows the table in Settings.h. */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Feed")
+	TArray<FMarkerFeedConfig> MarkerFeedConfigs;
+
+	/* Records taken from the feed queues per frame. The rest stay queued on the feeds until the next frame. */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Feed")
+	int MaxFeedRecordsPerFrame = 20000;
+
+	/*
+	 * Seconds stream locations are held to be put in timestamp order per device, see FMarkerReorderBuffer.
+	 * Larger values absorb more disorder between shards, at the cost of as much delay. 0 applies locations as they arrive.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Feed")
+	float ReorderLatenessSeconds = 1.0f;
+
+	/*
+	 * Locations that may wait to be applied. When a stream enqueue goes over it, queued stream updates are shed:
+	 * first down to one location per device, then temporary markers, then the devices farthest from the camera.
+	 * Reads the caller asked for, like full loads, syncs, reconciles, tiles and fast-forwards, are never shed,
+	 * and are applied in full over as many frames as they take.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Overload")
+	int MaxPendingLocations = 200000;
+
+	/* Stop reading the streams while the apply queue is full, rather than shedding what they deliver */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Overload")
+	bool PauseReadsUnderLoad = true;
+
+	/* When shedding, keep only the latest location of each dynamic marker */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Overload")
+	bool KeepLatestLocationUnderLoad = true;
+
+	/* When shedding, drop queued temporary markers before any static or dynamic marker */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Overload")
+	bool DropTemporaryMarkersUnderLoad = true;
+
+	/*
+	 * When true, temporary markers only get material parameters and the material shrinks them.
+	 * When false, the manager rescales them every TemporaryMarkerShrinkInterval seconds in one pass,
+	 * for materials without the ExpiryStartTime / ExpiryLifeSpan world position offset.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Expiry")
+	bool ShrinkTemporaryMarkersInMaterial = false;
+
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Expiry")
+	float TemporaryMarkerShrinkInterval = 0.1f;
+
+	/*
+	 * True while markers are replicated by an AMarkerReplicator rather than as individual actors.
+	 * Set on the server by StartServerReplication(), and on clients once the replicator arrives.
+	 */
+	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category="Spaces|MarkerManager|Replication")
+	bool ServerAuthoritativeReplication = false;
+
+	/* Size of the interest grid cells in UE units. Changes apply on the next StartServerReplication(). */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Replication")
+	float InterestCellSize = 500000.0f;
+
+	/* Markers up to this many cells from a client's view are sent at the net update rate */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Replication")
+	int InterestNearRadiusCells = 1;
+
+	/* Markers up to this many cells from a client's view are sent individually; farther cells are aggregated */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Replication")
+	int InterestMidRadiusCells = 4;
+
+	/* Seconds between updates of markers beyond InterestNearRadiusCells */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Replication")
+	float InterestMidUpdateInterval = 2.0f;
+
+	/* Seconds between updates of the aggregated cells beyond InterestMidRadiusCells */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Replication")
+	float InterestFarUpdateInterval = 10.0f;
+
+	/*
+	 * Spawn markers without collision, and select them with PickMarkerAtScreenPosition(), SelectMarkersInBox()
+	 * and SelectMarkersInLasso() against the manager's picking grid instead of line traces.
+	 * Applies to markers spawned while it is set.
+	 */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category="Spaces|MarkerManager|Picking")
+	bool CollisionFreePicking = false;
+
+	/* Size of the picking grid cells in UE units, a few marker diameters. Changes apply when the grid is empty. */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Picking")
+	float PickingCellSize = 10000.0f;
+
+	/* How far PickMarkerAtScreenPosition() looks along the cursor ray, in UE units */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Picking")
+	float PickingMaxDistance = 100000000.0f;
+
+	/* Keep every applied location in the temporal store, for GetMarkerStatesAt() and GetMarkerRecordsBetween() */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|History")
+	bool RecordMarkerHistory = true;
+
+	/* Hours of history kept, counted back from the newest record. 0 keeps everything. */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|History")
+	float MarkerHistoryRetentionHours = 24.0f;
+
+	/*
+	 * Make GetAllMarkersFromDynamoDB() reconcile the spawned markers with the table, see ReconcileMarkersAsync(),
+	 * instead of queueing every row again. Markers the table no longer has are then destroyed.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Reconcile")
+	bool ReconcileFullSyncs = true;
+
+	/* Seconds between reconciles of all marker types in the background. 0 turns them off. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="Spaces|MarkerManager|Reconcile")
+	float FullResyncInterval = 0.0f;
+
+	/* Make DynamoDBStreamsReplay() fast-forward to the final state instead of applying every event in turn */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Replay")
+	bool FastForwardReplay = true;
+
+	/* Give fast-forwarded dynamic markers every replayed location as history, rather than only the latest */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Replay")
+	bool FastForwardKeepHistory = true;
+
+	/*
+	 * Sort temporary and dynamic markers into update tiers by their distance to the camera, the view frustum
+	 * and the selection, see EMarkerSignificance. Off on servers, whose markers are replicated with their transforms.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Significance")
+	bool MarkerSignificance = true;
+
+	/* Seconds between two significance passes */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Significance")
+	float SignificanceUpdateInterval = 0.2f;
+
+	/* Markers up to this distance from the camera, in UE units, are Near; selected markers always are */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Significance")
+	float SignificanceNearDistance = 500000.0f;
+
+	/* Markers up to this distance are Mid, farther ones Far */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Significance")
+	float SignificanceMidDistance = 5000000.0f;
+
+	/* Markers beyond this distance are Hidden, as are those outside the view or behind the globe. 0 for no limit. */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Significance")
+	float SignificanceHiddenDistance = 200000000.0f;
+
+	/* Added to the marker radius for the frustum test, so markers are revealed before they come into view */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Significance")
+	float SignificanceFrustumMargin = 50000.0f;
+
+	/* Mid markers are moved and rescaled at 1/SignificanceMidRateDivisor of the full rate */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Significance")
+	int SignificanceMidRateDivisor = 4;
+
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Significance")
+	int SignificanceFarRateDivisor = 16;
+
+	/* Hidden dynamic markers tick this many times less often, and keep their pace along their history without moving */
+	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly, Category="Spaces|MarkerManager|Significance")
+	int SignificanceHiddenRateDivisor = 32;
+
 protected:
 	// Maps from DeviceID to LocationMarker
 	TMap<FString, ALocationMarker*> SpawnedLocationMarkers;
 	
-	Aws::DynamoDB::DynamoDBClient* DynamoClient;
-	Aws::DynamoDBStreams::DynamoDBStreamsClient* DynamoDBStreamsClient;
+	// Created in the background by Init(), valid once AwsReady is set or WaitForAws() returns
+	Aws::DynamoDB::DynamoDBClient* DynamoClient = nullptr;
+	Aws::DynamoDBStreams::DynamoDBStreamsClient* DynamoDBStreamsClient = nullptr;
+
+	// The clients' executor, which Shutdown() drains before the SDK goes away
+	std::shared_ptr<FUnrealAwsExecutor> AwsExecutor;
+	// Tasks of ours that use the clients off the game thread, such as QueryMarkersAsync() and the fast-forward
+	FThreadSafeCounter BackgroundAwsTasks;
+
+	// AWS SDK and client creation, started by Init() on the thread pool
+	TFuture<void> AwsStartup;
+	bool AwsReady = false;
+	// Calls made before AwsReady, run in order once it is set
+	mutable TArray<TUniqueFunction<void()>> PendingAwsCalls;
+
+	/* Mark AWS as ready, run the queued calls and broadcast OnAwsReady. Game thread. */
+	void FinishAwsStartup();
+
+	/* Run Call now if AWS is ready, or queue it until it is. Game thread. */
+	void WhenAwsReady(TUniqueFunction<void()>&& Call) const;
+
+	/* Block until the clients exist. For the synchronous functions, which cannot be queued. */
+	void WaitForAws() const;
+
+	// Markers spawned while CollisionFreePicking was set, and the dynamic ones among them, which move between queries
+	FMarkerPickingGrid PickingGrid;
+	TSet<FString> PickableDynamicMarkers;
+
+	/* Move the dynamic markers to where they are now in the picking grid. Called before each query. */
+	void RefreshPickingGrid();
+
+	/**
+	* View and projection of a player's viewport, for converting between screen and world.
+	* @param PlayerController
+	* @param OutViewProjection
+	* @param OutViewRect
+	* @returns False if the player has no viewport.
+	**/
+	static bool GetPlayerViewProjection(const APlayerController* PlayerController, FMatrix& OutViewProjection, FIntRect& OutViewRect);
+
+	// Markers re-anchored by ReanchorMarkers(), and the transform their UE coordinates were computed with
+	FMarkerAnchorArray MarkerAnchors;
+	FMatrix AnchoredEcefToUnreal = FMatrix::Identity;
+
+	/* The georeference's ECEF to UE transform as a matrix, recovered from its affine TransformEcefToUnreal() */
+	FMatrix GetEcefToUnrealTransform() const;
+
+	UFUNCTION()
+	void OnGeoreferenceUpdated();
 
 	// DynamoDB Streams
+	Aws::String ShardIteratorAws;
+	/* Set the shard iterator, and its Blueprint copy */
+	void SetShardIterator(const Aws::String& Iterator);
+	// Shard that ShardIteratorAws reads, so the iterator of one shard is never used for the next
+	Aws::String ShardIteratorShardId;
 	Aws::String LastEvaluatedShardId;
 	Aws::String LastEvaluatedSequenceNumber;
 	Aws::String LastEvaluatedStreamArn;
 
+	// Sequence numbers already processed, per shard, shared by replay and listen
+	FStreamDeduplicator StreamDeduplicator;
+
+	// Marker updates waiting to be applied, ordered farthest from the camera first so the nearest is popped from the back
+	TArray<FMarkerRecordBatch> PendingBatches;
+	TMap<FString, int32> PendingBatchIndex;
+	bool PendingBatchesNeedSort = false;
+	FVector LastPrioritizedCameraLocation = FVector::ZeroVector;
+	// Stream locations waiting to be released in timestamp order, ahead of PendingBatches
+	FMarkerReorderBuffer ReorderBuffer;
+	// Locations in PendingBatches, bounded by MaxPendingLocations
+	int32 PendingLocationCount = 0;
+	FMarkerIngestStatus ShedCounters;
+	FTSTicker::FDelegateHandle ApplyQueueTickerHandle;
+
+	// Moving average of the time it takes to apply one batch, and the length of the last frame
+	double AverageBatchApplySeconds = 0.0;
+	float LastFrameSeconds = 1.0f / 60.0f;
+
 	virtual void Init() override;
+	virtual void OnStart() override;
 	virtual void Shutdown() override;
+
+	/* Drains PendingBatches for at most SpawnBudgetMilliseconds. Registered with the core ticker. */
+	bool TickApplyQueue(float DeltaTime);
+
+	/* Order PendingBatches farthest from the camera first, and rebuild PendingBatchIndex */
+	void SortPendingBatches(const FVector& CameraLocation);
+
+	/* Drop queued stream updates until PendingLocationCount is within MaxPendingLocations, or none are left */
+	void ShedPendingBatches();
+
+	/* True while stream reads should wait for the apply queue to drain */
+	bool ShouldPauseReads() const;
+
+	/* Release the reorder buffer and apply every pending batch now, ignoring the frame budget */
+	void DrainApplyQueue();
+
+	// Expiry of temporary markers, see ScheduleMarkerExpiry()
+	FExpiryTimingWheel ExpiryWheel;
+	double LastShrinkTime = 0.0;
+
+	/* Destroy the markers whose expiry has passed, and shrink the rest. Called from TickApplyQueue(). */
+	void TickExpiry();
+
+	// Significance of temporary and dynamic markers, see MarkerSignificance
+	double LastSignificanceTime = 0.0;
+	uint32 ShrinkPassCount = 0;
+	// Markers per EMarkerSignificance as of the last pass
+	int32 SignificanceCounts[4] = {0, 0, 0, 0};
+	// Whether any marker may be in a tier other than Near
+	bool SignificanceApplied = false;
+
+	/* Re-tier temporary and dynamic markers every SignificanceUpdateInterval. Called from TickApplyQueue(). */
+	void UpdateMarkerSignificance();
+
+	/* Put every temporary and dynamic marker back to Near, when significance is turned off */
+	void ResetMarkerSignificance();
+
+	int32 GetSignificanceRateDivisor(const EMarkerSignificance Significance) const;
+
+	// History of every applied location, see GetMarkerStatesAt()
+	FMarkerTemporalStore TemporalStore;
+	double LastHistoryTrimTime = 0.0;
+
+	/* Drop history older than MarkerHistoryRetentionHours, except the last record of each device before it, at most once a minute. Called from TickApplyQueue(). */
+	void TrimMarkerHistory();
+
+	// Set while ReconcileMarkersAsync() reads the table
+	bool ReconcileRunning = false;
+	double LastFullResyncTime = 0.0;
+	FMarkerReconcileResult LastReconcileResult;
+
+	/**
+	* Diff a full read against the spawned markers and apply the changes: destroy the removed markers
+	* without deleting them from DynamoDB, move updated static and temporary markers in place,
+	* and queue the added devices and the new locations of dynamic markers.
+	* @param Records
+	* @param StaticMarkersOnly Whether the read covered only static markers
+	* @param ReadStartedAt
+	**/
+	FMarkerReconcileResult ReconcileMarkerRecords(const TArray<FMarkerRecord>& Records, const bool StaticMarkersOnly,
+	                                              const FDateTime ReadStartedAt);
+
+	/* Move a static or temporary marker to a new location, and update everything that indexes it */
+	void RelocateMarker(ALocationMarker* Marker, const FLocationTs& LocationTs);
+
+	/* Start a background reconcile every FullResyncInterval. Called from TickApplyQueue(). */
+	void TickFullResync();
+
+	// Set while DynamoDBStreamsFastForwardAsync() reads the stream
+	bool FastForwardRunning = false;
+
+	/* Bring the UE coordinates up to date if the georeference moved during the read, and queue the batches */
+	void ApplyFastForward(TArray<FMarkerRecordBatch>&& Batches, const TOptional<FMatrix>& EcefToUnreal);
+
+	// Feeds started by StartMarkerFeeds(), each with its own worker thread
+	TArray<TUniquePtr<FMarkerFeed>> MarkerFeeds;
+
+	/* Move decoded records from the feeds into PendingBatches. Called from TickApplyQueue(). */
+	void DrainMarkerFeeds();
+
+	bool GetCameraLocation(FVector& OutLocation) const;
+
+	// Region streaming: tiles currently loaded, mapped to the device IDs loaded from them
+	TMap<FString, TSet<FString>> LoadedTiles;
+	// Tiles being read, mapped to the generation of their load. A result is only applied if its load is still the current one.
+	TMap<FString, uint32> TilesInFlight;
+	uint32 TileLoadGeneration = 0;
+	// Number of loaded tiles listing each device, since a dynamic device can have rows in several
+	TMap<FString, int32> TileDeviceRefs;
+	// Devices whose marker was spawned by region streaming, and is destroyed when the last of their tiles unloads
+	TSet<FString> TileSpawnedDevices;
+	// Decoded query results of recently used tiles, least recently used first in TileCacheOrder
+	TMap<FString, TArray<FMarkerRecord>> TileCache;
+	// FPlatformTime::Seconds() at which each cached tile was read
+	TMap<FString, double> TileCacheTimes;
+	TArray<FString> TileCacheOrder;
+
+	void UpdateRegionStreaming();
+	void LoadTile(const FString& Tile);
+	void UnloadTile(const FString& Tile);
+	void ApplyTile(const FString& Tile, const TArray<FMarkerRecord>& Records);
+	void AddToTileCache(const FString& Tile, const TArray<FMarkerRecord>& Records);
+	void RemoveFromTileCache(const FString& Tile);
+	/* List a device under a loaded tile. It is owned by region streaming if nothing else has spawned or queued it. */
+	void AddTileDevice(const FString& Tile, const FString& DeviceID);
+
+	// Replicators of this world: one per remote player on the server, and the client's own on a client
+	TArray<TWeakObjectPtr<AMarkerReplicator>> MarkerReplicators;
+
+	// Server: latest location of every marker, read by the replicators
+	FMarkerInterestGrid InterestGrid;
+	bool ReplicationServer = false;
+	FDelegateHandle PostLoginHandle;
+	FDelegateHandle LogoutHandle;
+
+	/* Pass a device's latest location to the interest grid, if this is the server of a replicated world. */
+	void ReplicateMarkerUpdate(const FString& DeviceID, const ELocationMarkerType MarkerType, const FLocationTs& LocationTs);
+
+	void SpawnMarkerReplicator(APlayerController* PlayerController);
+	void OnPostLogin(AGameModeBase* GameMode, APlayerController* PlayerController);
+	void OnLogout(AGameModeBase* GameMode, AController* Controller);
+
+	/* Remove a device's queued update and reorder buffer samples, if any. */
+	void RemovePendingBatch(const FString& DeviceID);
+
+	// Requests and result decoding shared by the synchronous and asynchronous DynamoDB functions
+	static Aws::DynamoDB::Model::PutItemRequest MakePutItemRequest(const ALocationMarker* Marker);
+	static Aws::DynamoDB::Model::DeleteItemRequest MakeDeleteItemRequest(const FString& DeviceID, const FDateTime Timestamp);
+	static Aws::DynamoDB::Model::QueryRequest MakeLatestRecordRequest(const FString& DeviceID);
+	static FVector DecodeLatestRecord(const Aws::DynamoDB::Model::QueryOutcome& Outcome, const FDateTime LastKnownTimestamp);
+	TArray<FMarkerRecord> DecodeItems(const Aws::Vector<Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue>>& Items) const;
+
+	/* Run every request of a compiled query, following LastEvaluatedKey. Blocks the calling thread. */
+	static bool FetchItems(const Aws::DynamoDB::DynamoDBClient* Client, const FCompiledMarkerQuery& Query,
+	                       Aws::Vector<Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue>>& OutItems);
+
+	// UTF-8 versions of the Blueprint stream functions, used internally so IDs are not converted to FString
+	TArray<Aws::String> GetStreamArns(const Aws::String& TableName);
+	TArray<Aws::String> GetShardIds(const Aws::String& StreamArn) const;
+	void ScanStreamArn(const Aws::String& StreamArn, const FDateTime TReplayStartFrom);
+	/* With DrainWhenFull a full apply queue is applied in place rather than pausing the read, so the shard is read to its end */
+	void ReadShard(const Aws::String& StreamArn, const Aws::String& ShardId,
+	               const FDynamoDBStreamShardIteratorType ShardIteratorType, const FDateTime TReplayStartFrom,
+	               const bool DrainWhenFull = false);
+
+	/* Query filter equivalent to the StaticMarkersOnly parameter of the functions below */
+	static FMarkerQuery MakeMarkerTypeQuery(const bool StaticMarkersOnly);
 	
 public:
 
@@ -69,8 +522,65 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager")
 	ALocationMarker* SpawnAndInitializeMarker(const FLocationTs LocationTs, const ELocationMarkerType MarkerType, const FString DeviceID);
 
+	/**
+	* Add a temporary or dynamic marker to the expiry timing wheel, at its ExpiryTime.
+	* Called by ATemporaryMarker::ScheduleExpiry(). Earlier entries of the marker are ignored when they fire.
+	* @param Marker
+	**/
+	void ScheduleMarkerExpiry(ATemporaryMarker* Marker);
+
+	/**
+	* @returns Number of entries in the expiry timing wheel, including cancelled ones that have not fired yet.
+	**/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|Expiry")
+	int GetScheduledExpiryCount() const;
+
+	/**
+	* @param Significance
+	* @returns Number of temporary and dynamic markers in the tier as of the last significance pass.
+	**/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|Significance")
+	int GetMarkerSignificanceCount(const EMarkerSignificance Significance) const;
+
 	/****************   DynamoDB   ******************/
 
+	/* Broadcast on the game thread once the AWS SDK and clients have been created */
+	UPROPERTY(BlueprintAssignable, Category="Spaces|MarkerManager")
+	FMarkerManagerAwsReady OnAwsReady;
+
+	/* Broadcast for every batch of locations as it is applied to the markers, e.g. to measure ingest latency */
+	FMarkerManagerBatchApplied OnMarkerBatchApplied;
+
+	/* Broadcast after ReanchorMarkers() has moved the markers to the new georeference origin */
+	FMarkerManagerReanchored OnMarkersReanchored;
+
+	/**
+	* DynamoDB item of a location, with the time bucket and geohash tile attributes of the secondary indices.
+	* The marker type attribute is left to the caller.
+	* @param DeviceID
+	* @param LocationTs
+	* @returns Attribute values by attribute name.
+	**/
+	static Aws::Map<Aws::String, Aws::DynamoDB::Model::AttributeValue> MakeMarkerItem(const FString& DeviceID, const FLocationTs& LocationTs);
+
+	/**
+	* The AWS SDK and clients are created in the background while the first level loads.
+	* Asynchronous and fire-and-forget calls made before then are queued, and synchronous ones wait.
+	* @returns True once the clients exist.
+	**/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager")
+	bool IsAwsReady() const { return AwsReady; }
+
+	/**
+	* Recompute the UE coordinates of every marker, of queued and held updates, of cached tile records and of the
+	* replication grid, from their ECEF coordinates.
+	* Markers that do not move are converted in one parallel pass over a contiguous array and moved in one loop,
+	* and dynamic markers have their histories converted in parallel.
+	* Called when the georeference changes, if BatchedReanchoring is set.
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager")
+	void ReanchorMarkers();
+
 	/**
 	* Given a reference to a LocationMarker instance, insert it into DynamoDB table.
 	* This function was written with the assumption that within the game,
@@ -88,9 +598,10 @@ public:
 	* Fetch all markers from DynamoDB and spawn them in the world.
 	* Caution: Because this method retrieves all rows from DynamoDB table,
 	* this is the most expensive function. It's recommended to use a local
-	* DynamoDB instance to not accumulate charges.
-	* @param StaticMarkersOnly [bool] If set to true, only static markers will be spawned.
-	* Otherwise, static and dynamic markers are spawned.
+	* DynamoDB instance to not accumulate charges. Use LoadMarkers() to load a subset instead.
+	* Calling it again reconciles the spawned markers with the table if ReconcileFullSyncs is set.
+	* @param StaticMarkersOnly [bool] If set to true, only static markers are read from the table.
+	* Otherwise, markers of all types are spawned.
 	**/
 	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager")
 	void GetAllMarkersFromDynamoDB(const bool StaticMarkersOnly = true);
@@ -105,6 +616,60 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Spaces|Marker")
 	FVector GetLatestRecord(const FString DeviceID, const FDateTime LastKnownTimestamp);
 
+	/**
+	* Marker under a screen position, from the picking grid. Requires CollisionFreePicking.
+	* @param PlayerController
+	* @param ScreenPosition In viewport pixels, as from GetMousePosition().
+	* @returns Nearest marker along the cursor ray, or nullptr.
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Picking")
+	ALocationMarker* PickMarkerAtScreenPosition(APlayerController* PlayerController, const FVector2D ScreenPosition);
+
+	/**
+	* Nearest marker hit by a world space ray, from the picking grid. Requires CollisionFreePicking.
+	* @param Origin
+	* @param Direction
+	* @param MaxDistance
+	* @returns Marker, or nullptr.
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Picking")
+	ALocationMarker* PickMarker(const FVector Origin, const FVector Direction, const float MaxDistance);
+
+	/**
+	* Markers that appear inside a screen rectangle, from the picking grid. Requires CollisionFreePicking.
+	* The rectangle is turned into a frustum, so nothing is projected until a cell of the grid falls inside it.
+	* @param PlayerController
+	* @param Start One corner, in viewport pixels.
+	* @param End The opposite corner.
+	* @returns Markers
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Picking")
+	TArray<ALocationMarker*> SelectMarkersInBox(APlayerController* PlayerController, const FVector2D Start, const FVector2D End);
+
+	/**
+	* Markers whose centers appear inside a screen polygon, from the picking grid. Requires CollisionFreePicking.
+	* @param PlayerController
+	* @param Points Polygon in viewport pixels, implicitly closed.
+	* @returns Markers
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Picking")
+	TArray<ALocationMarker*> SelectMarkersInLasso(APlayerController* PlayerController, const TArray<FVector2D>& Points);
+
+	/**
+	* Select or unselect many markers at once, without a log line per marker.
+	* @param Markers
+	* @param Selected
+	* @param ClearOthers Unselect every other marker first.
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Picking")
+	void SetMarkersSelected(const TArray<ALocationMarker*>& Markers, const bool Selected = true, const bool ClearOthers = false);
+
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Picking")
+	void ClearMarkerSelection();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|Picking")
+	TArray<ALocationMarker*> GetSelectedMarkers() const;
+
 	/**
 	* Destroy all the spawned markers that are currently selected.
 	**/
@@ -133,6 +698,241 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager")
 	bool DeleteMarkerFromDynamoDB(const FString DeviceID, const FDateTime Timestamp) const;
 
+	/****************   DynamoDB (asynchronous)   ******************/
+
+	/*
+	 * Non-blocking versions of the DynamoDB functions above. Requests run on the engine thread pool,
+	 * and the returned futures are fulfilled on the game thread, so continuations attached with
+	 * TFuture::Next() can safely touch actors. Blueprints can use UDynamoDBAsyncAction instead.
+	 */
+
+	/**
+	* Asynchronous version of CreateMarkerInDB().
+	* The marker's attributes are read immediately, so the marker may be destroyed before the request completes.
+	* @param Marker
+	* @returns Future that is set to True if the insert succeeded.
+	**/
+	TFuture<bool> CreateMarkerInDBAsync(const ALocationMarker* Marker) const;
+
+	/**
+	* Asynchronous version of DeleteMarkerFromDynamoDB().
+	* @param DeviceID
+	* @param Timestamp
+	* @returns Future that is set to True if the delete succeeded.
+	**/
+	TFuture<bool> DeleteMarkerFromDynamoDBAsync(const FString DeviceID, const FDateTime Timestamp) const;
+
+	/**
+	* Asynchronous version of GetLatestRecord().
+	* @param DeviceID
+	* @param LastKnownTimestamp
+	* @returns Future that is set to the latest location, or zero vector if there is no newer location.
+	**/
+	TFuture<FVector> GetLatestRecordAsync(const FString DeviceID, const FDateTime LastKnownTimestamp) const;
+
+	/**
+	* Asynchronous version of GetAllMarkersFromDynamoDB().
+	* The markers are queued to be spawned over the following frames, or reconciled if ReconcileFullSyncs is set.
+	* @param StaticMarkersOnly
+	* @returns Future that is set to the number of records read, or -1 if the scan failed.
+	**/
+	TFuture<int> GetAllMarkersFromDynamoDBAsync(const bool StaticMarkersOnly = true);
+
+	/**
+	* Read the marker table and reconcile the spawned markers with it, applying only what changed:
+	* devices without a marker are queued to be spawned, static and temporary markers whose row changed are moved,
+	* dynamic markers get the locations newer than their history, and markers the table no longer has are destroyed.
+	* Markers created after the read started are kept. Running it again when nothing changed touches no marker.
+	* @param StaticMarkersOnly Read and reconcile only static markers, leaving the others alone
+	* @returns Future that is set to what changed, with Success unset if the read failed or a reconcile is already running.
+	**/
+	TFuture<FMarkerReconcileResult> ReconcileMarkersAsync(const bool StaticMarkersOnly = false);
+
+	/**
+	* Blueprint version of ReconcileMarkersAsync(). Returns immediately; see GetLastReconcileResult().
+	* @param StaticMarkersOnly
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Reconcile")
+	void ReconcileMarkers(const bool StaticMarkersOnly = false);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|Reconcile")
+	FMarkerReconcileResult GetLastReconcileResult() const;
+
+	/**
+	* Fetch the markers matching a query. The query runs on the thread pool, and the rows are decoded on the game thread.
+	* Filtering and projection happen in DynamoDB, so only matching rows and the attributes that are decoded are transferred.
+	* @param Query
+	* @returns Future that is set to the decoded records, or unset if a request failed.
+	**/
+	TFuture<TOptional<TArray<FMarkerRecord>>> QueryMarkersAsync(const FMarkerQuery& Query);
+
+	/**
+	* Fetch the markers matching a query and queue them to be spawned or merged into existing markers.
+	* @param Query
+	* @returns Future that is set to the number of records queued, or -1 if a request failed.
+	**/
+	TFuture<int> LoadMarkersAsync(const FMarkerQuery& Query);
+
+	/**
+	* Blueprint version of LoadMarkersAsync(). Returns immediately.
+	* For example, a Query with DeviceIDs and From set loads the recent history of a few devices.
+	* @param Query
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager")
+	void LoadMarkers(const FMarkerQuery& Query);
+
+	/**
+	* Fetch only the markers created at or after Since, and merge them into the existing markers.
+	* Uses the TimeIndexName global secondary index, querying one time bucket at a time,
+	* so the cost is proportional to the number of new rows rather than the size of the table.
+	* Ranges longer than FMarkerQuery::MaxTimeBuckets fall back to a filtered Scan.
+	* Locations that a dynamic marker already has are not added again.
+	* @param Since
+	* @param StaticMarkersOnly If set to true, only static markers will be spawned.
+	* @returns Future that is set to the number of records queued, or -1 if a query failed.
+	**/
+	TFuture<int> SyncMarkersSinceAsync(const FDateTime Since, const bool StaticMarkersOnly = false);
+
+	/**
+	* Blueprint version of SyncMarkersSinceAsync(). Returns immediately.
+	* @param Since
+	* @param StaticMarkersOnly
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager")
+	void SyncMarkersSince(const FDateTime Since, const bool StaticMarkersOnly = false);
+
+	/**
+	* Call SyncMarkersSince() with LastSyncTimestamp, for example after the client was offline
+	* for longer than the 24 hour retention of DynamoDB Streams.
+	* @param StaticMarkersOnly
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager")
+	void SyncMarkersSinceLastSync(const bool StaticMarkersOnly = false);
+
+	/**
+	* Turn region streaming on or off. While on, markers are loaded by geohash tile with Query
+	* for every tile within RegionStreamingRadiusMeters of the camera. When tiles fall out of range, the markers
+	* they spawned are destroyed (but not deleted from DynamoDB) once no loaded tile lists them.
+	* Markers spawned in other ways are left alone.
+	* Requires the Cesium georeference, to convert the camera position to WGS84,
+	* and the TileIndexName global secondary index.
+	* @param Enabled
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Region")
+	void SetRegionStreaming(const bool Enabled);
+
+	/**
+	* @returns Geohashes of the tiles currently loaded by region streaming.
+	**/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|Region")
+	TArray<FString> GetLoadedTiles() const;
+
+	/****************   Marker feeds   ******************/
+
+	/**
+	 * Follow the streams of every table in MarkerFeedConfigs, each on its own worker thread.
+	 * All feeds spawn and update markers in the same registry as the rest of the manager,
+	 * so device IDs are expected to be unique across tables.
+	 * Feeds that are already running are restarted.
+	 **/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Feed")
+	void StartMarkerFeeds();
+
+	/**
+	 * Stop all feeds and wait for their worker threads to exit. Markers already spawned are kept.
+	 **/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Feed")
+	void StopMarkerFeeds();
+
+	/**
+	 * @returns Shard and record counters of every feed.
+	 **/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|Feed")
+	TArray<FMarkerFeedStatus> GetMarkerFeedStatus() const;
+
+	/****************   Replication   ******************/
+
+	/**
+	 * Server-authoritative mode for a dedicated or listen server. Spawns an AMarkerReplicator for every
+	 * remote player, now and as they log in, which replicates the markers around that player's view
+	 * as compact delta lists, and stops marker actors from replicating on their own. The server runs ingestion
+	 * (feeds, Listen, Replay, queries) as usual; clients should not, and spawn local markers from the lists instead.
+	 * Markers that already exist are added to the interest grid. Does nothing on a client.
+	 **/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Replication")
+	void StartServerReplication();
+
+	/**
+	 * Destroy the replicators. Clients destroy their replicated markers.
+	 **/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Replication")
+	void StopServerReplication();
+
+	// Called by AMarkerReplicator when it begins and ends play
+	void RegisterMarkerReplicator(AMarkerReplicator* Replicator);
+	void UnregisterMarkerReplicator(AMarkerReplicator* Replicator);
+
+	/**
+	 * Client side of the replicator: spawn a local marker for a device, or pass a new location to its dynamic marker.
+	 * @param DeviceID
+	 * @param MarkerType
+	 * @param LocationTs
+	 **/
+	void ApplyReplicatedMarker(const FString& DeviceID, const ELocationMarkerType MarkerType, const FLocationTs& LocationTs);
+
+	/**
+	 * Client side of the replicator: destroy the local marker of a device, without deleting it from DynamoDB.
+	 * @param DeviceID
+	 **/
+	void RemoveReplicatedMarker(const FString& DeviceID);
+
+	const FMarkerInterestGrid& GetInterestGrid() const { return InterestGrid; }
+
+	/**
+	 * Client side: aggregated cells far from the view, for drawing density instead of markers.
+	 * @returns Marker count and centroid per cell, or an empty array if no replicator has arrived.
+	 **/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|Replication")
+	TArray<FReplicatedMarkerCluster> GetReplicatedClusters() const;
+
+	/****************   History   ******************/
+
+	/**
+	 * Where every device was at a point in time, from the locations applied so far.
+	 * @param Time
+	 * @param Interpolate Interpolate between the records around Time, instead of taking the latest before it.
+	 * @param MaxAgeSeconds Leave out devices with no record in the MaxAgeSeconds before Time. 0 includes them all.
+	 * @returns One state per device that had a location at Time.
+	 **/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|History")
+	TArray<FMarkerState> GetMarkerStatesAt(const FDateTime Time, const bool Interpolate = false, const float MaxAgeSeconds = 0.0f) const;
+
+	/**
+	 * Every applied location with a timestamp in [From, To].
+	 * @param From
+	 * @param To
+	 * @returns Records grouped by device, in timestamp order within a device.
+	 **/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|History")
+	TArray<FMarkerState> GetMarkerRecordsBetween(const FDateTime From, const FDateTime To) const;
+
+	/**
+	 * Timestamps of the oldest and newest location in the history.
+	 * @returns False if the history is empty.
+	 **/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|History")
+	bool GetMarkerHistoryRange(FDateTime& Earliest, FDateTime& Latest) const;
+
+	/**
+	 * Memory held by the location history, which is stored as compact trajectories.
+	 * @param Bytes Allocated by the history.
+	 * @param UncompressedBytes What the same records would take as FLocationTs.
+	 **/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|History")
+	void GetMarkerHistoryMemory(int64& Bytes, int64& UncompressedBytes) const;
+
+	const FMarkerTemporalStore& GetTemporalStore() const { return TemporalStore; }
+
 	/****************   DynamoDB Streams   ******************/
 
 	/**
@@ -157,12 +957,31 @@ public:
 	/**
 	 * Given a DynamoDB table, which may be associated with one or more streams,
 	 * replay all the insert events in the last 24 hours.
-	 * Internally this calls ScanStreams() on each Stream associated with a given table.
+	 * Internally this calls ScanStreams() on each Stream associated with a given table,
+	 * or DynamoDBStreamsFastForward() if FastForwardReplay is set.
 	 * @param TableName
 	 **/
 	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager")
 	void DynamoDBStreamsReplay(FString TableName);
 
+	/**
+	 * Replay the last 24 hours of a table's stream in one pass, see DynamoDBStreamsFastForwardAsync().
+	 * @param TableName Empty for the marker table
+	 **/
+	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager|Replay")
+	void DynamoDBStreamsFastForward(const FString TableName);
+
+	/**
+	 * Read every shard of the table's stream on worker threads, reduce the records to the final state per device,
+	 * and queue one update per device: static and temporary markers at their first location, dynamic markers
+	 * at their latest location, with the earlier ones as history if FastForwardKeepHistory is set.
+	 * Records received after the call are left to the listener, and applied records are remembered for it.
+	 * @param TableName Empty for the marker table
+	 * @param From Records the stream received before this UTC time are skipped
+	 * @returns Number of devices queued, or -1 if the stream could not be read or a fast-forward is already running.
+	 **/
+	TFuture<int> DynamoDBStreamsFastForwardAsync(const FString& TableName, const FDateTime From);
+
 	/**
 	 * @param TableName
 	 * @returns List of stream ARNs for the given DynamoDB table.
@@ -190,6 +1009,12 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Spaces|MarkerManager")
 	TArray<FAwsString> GetShards(const FAwsString StreamArn) const;
 
+	/**
+	 * @returns Current shard iterator, or an empty string if none has been created.
+	 **/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager")
+	FString GetShardIterator() const;
+
 	/**
 	* Given a shard, create shard iterator with the specified ShardIteratorType
 	* and use that to iterate through the shard.
@@ -204,10 +1029,65 @@ public:
 	                  const FDynamoDBStreamShardIteratorType ShardIteratorType,
 	                  const FDateTime TReplayStartFrom);
 
-	void ProcessDynamoDBStreamRecords(Aws::Vector<Aws::DynamoDBStreams::Model::Record> Records,
+	/**
+	* Spawn or update markers from a page of stream records.
+	* Records whose sequence number was already processed on ShardId are dropped before decoding.
+	* @param Records
+	* @param ShardId Shard the records were read from.
+	* @param TReplayStartFrom Records created before this timestamp are skipped.
+	*/
+	void ProcessDynamoDBStreamRecords(const Aws::Vector<Aws::DynamoDBStreams::Model::Record>& Records,
+	                                  const Aws::String& ShardId,
 	                                  FDateTime TReplayStartFrom);
 
 
+	/**
+	* Spawn or update markers from records that have been grouped by device.
+	* Each device's marker is looked up once. Dynamic markers receive all of their new locations
+	* in a single append, and static and temporary markers are spawned at most once.
+	* @param Batches
+	*/
+	void ApplyMarkerRecordBatches(const TArray<FMarkerRecordBatch>& Batches);
+	void ApplyMarkerRecordBatch(const FMarkerRecordBatch& Batch);
+
+	/**
+	* Queue batches to be applied over the next frames within SpawnBudgetMilliseconds per frame,
+	* nearest to the camera first. A batch for a device that is already queued is merged into it.
+	* @param Batches
+	* @param Live Whether the batches come from a live stream, and may be shed when the queue is over MaxPendingLocations
+	*/
+	void EnqueueMarkerRecordBatches(TArray<FMarkerRecordBatch>&& Batches, const bool Live = false);
+
+	/**
+	* Queue batches read from a stream, through the reorder buffer, so each device's locations are applied in timestamp order.
+	* Snapshots such as query results are already ordered and go to EnqueueMarkerRecordBatches() directly.
+	* @param Batches
+	*/
+	void EnqueueStreamRecordBatches(TArray<FMarkerRecordBatch>&& Batches);
+
+	/**
+	* @returns Number of devices with marker updates still waiting to be applied.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager")
+	int GetPendingMarkerUpdateCount() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager")
+	int GetSpawnedMarkerCount() const;
+
+	/**
+	* Estimate how long it will take to apply all queued marker updates,
+	* based on the average cost of an update, the frame budget and the current frame time.
+	* @returns Seconds
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager")
+	float GetEstimatedDrainSeconds() const;
+
+	/**
+	* @returns Occupancy of the feed and apply queues, and the number of updates shed since startup.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|Overload")
+	FMarkerIngestStatus GetIngestStatus() const;
+
 	/**
 	* Given timestamp and lon, lat, elevation in WGS84, return a wrapper object
 	* that contains WGS84, UE, ECEF coordinates, and the timestamp.
@@ -224,6 +1104,15 @@ public:
 	FLocationTs WrapLocationTs(const FDateTime Timestamp, const double Lon, const double Lat, const double Elev) const;
 	FLocationTs WrapLocationTs(FDateTime Timestamp, FVector Coordinate) const;
 
+	/**
+	* Inverse of WrapLocationTs(): given a UE coordinate, return the FLocationTs that WrapLocationTs() would have made
+	* from the corresponding WGS84 coordinate. Used for locations replicated in UE coordinates.
+	* @param Timestamp [FDateTime]
+	* @param UECoordinate [FVector]
+	* @return FLocationTs
+	*/
+	FLocationTs WrapUnrealLocationTs(const FDateTime Timestamp, const FVector& UECoordinate) const;
+
 	/**
 	* Return a list of location markers currently existing in the UE World.
 	* @return TArray<ALocationMarker*>
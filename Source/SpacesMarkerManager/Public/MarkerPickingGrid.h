@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ALocationMarker;
+struct FConvexVolume;
+
+
+/*
+ * Spheres of the pickable markers in a sparse 3D hash grid, for selecting markers without physics bodies.
+ * A marker is listed in every cell its bounding box overlaps, so a query only has to look at the cells it touches:
+ * - Raycast(): walks the cells along the ray (3D DDA) and stops at the first cell beyond the nearest hit
+ * - Overlap(): tests the cells, then the spheres, against a convex volume such as a selection frustum
+ * Used by UMarkerManager when CollisionFreePicking is set. Game thread only.
+ */
+class SPACESMARKERMANAGER_API FMarkerPickingGrid
+{
+public:
+	explicit FMarkerPickingGrid(const double InCellSize = 10000.0);
+
+	/* Remove every marker, and change the cell size */
+	void Reset(const double InCellSize);
+
+	/* Add a marker, or move it if it is already in the grid */
+	void Update(const FString& DeviceID, ALocationMarker* Marker, const FVector& Location, const float Radius);
+	void Remove(const FString& DeviceID);
+
+	/**
+	 * Nearest marker hit by a ray.
+	 * @param Origin
+	 * @param Direction Normalized.
+	 * @param MaxDistance
+	 * @param OutDistance Distance along the ray to the hit.
+	 * @returns Nullptr if nothing was hit.
+	 **/
+	ALocationMarker* Raycast(const FVector& Origin, const FVector& Direction, const double MaxDistance, double& OutDistance) const;
+
+	/* Markers whose sphere intersects Volume */
+	void Overlap(const FConvexVolume& Volume, TArray<ALocationMarker*>& OutMarkers) const;
+
+	bool Contains(const FString& DeviceID) const { return Index.Contains(DeviceID); }
+	int32 Num() const { return Index.Num(); }
+
+private:
+	struct FEntry
+	{
+		TWeakObjectPtr<ALocationMarker> Marker;
+		FVector Location = FVector::ZeroVector;
+		float Radius = 0.0f;
+		FIntVector MinCell = FIntVector::ZeroValue;
+		FIntVector MaxCell = FIntVector::ZeroValue;
+	};
+
+	FIntVector GetCell(const FVector& Location) const;
+	void Link(const int32 EntryIndex);
+	void Unlink(const int32 EntryIndex);
+
+	double CellSize;
+	TSparseArray<FEntry> Entries;
+	TMap<FString, int32> Index;
+	TMap<FIntVector, TArray<int32>> Cells;
+	// Grows to cover every marker added, so rays can be clipped before walking the grid
+	FBox Bounds = FBox(ForceInit);
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LocationMarker.h"
+#include "aws/dynamodb/model/QueryRequest.h"
+#include "aws/dynamodb/model/ScanRequest.h"
+#include "MarkerQuery.generated.h"
+
+
+/*
+ * DynamoDB requests compiled from an FMarkerQuery.
+ * Either a list of Query requests, one per device, tile or time bucket, or a single Scan.
+ */
+struct FCompiledMarkerQuery
+{
+	bool UseScan = false;
+	Aws::DynamoDB::Model::ScanRequest ScanRequest;
+	TArray<Aws::DynamoDB::Model::QueryRequest> QueryRequests;
+};
+
+
+/*
+ * Predicates for loading markers from DynamoDB. An empty predicate matches everything.
+ * Compile() turns the predicates into KeyConditionExpression and FilterExpression,
+ * with a ProjectionExpression of only the attributes the decoder reads, and picks the cheapest access path:
+ * - DeviceIDs set: one Query per device on the table
+ * - Tiles set: one Query per tile on TileIndexName, shorter geohashes expanded to their tiles
+ * - From set, spanning at most MaxTimeBuckets buckets: one Query per bucket on TimeIndexName
+ * - Otherwise: one Scan with a FilterExpression
+ * An empty time range, with From after To, compiles to no requests at all.
+ *
+ * Usage: FMarkerQuery().WithMarkerTypes({ELocationMarkerType::Static}).WithTimeRange(From, To)
+ */
+USTRUCT(BlueprintType)
+struct SPACESMARKERMANAGER_API FMarkerQuery
+{
+	GENERATED_BODY()
+
+	/* Marker types to load. Rows without a marker type are Static. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Query")
+	TArray<ELocationMarkerType> MarkerTypes;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Query")
+	TArray<FString> DeviceIDs;
+
+	/* Inclusive lower bound of created_timestamp */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Query")
+	FDateTime From = FDateTime::MinValue();
+
+	/* Inclusive upper bound of created_timestamp */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Query")
+	FDateTime To = FDateTime::MaxValue();
+
+	/* Geohash tiles, see TileGeohashPrecision in Settings.h. A shorter geohash reads every tile inside it. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Query")
+	TArray<FString> Tiles;
+
+	/* Time ranges longer than this many time buckets are scanned instead of queried */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|MarkerManager|Query")
+	int MaxTimeBuckets = 24 * 14;
+
+	FMarkerQuery& WithMarkerTypes(const TArray<ELocationMarkerType>& InMarkerTypes);
+	FMarkerQuery& WithDeviceIDs(const TArray<FString>& InDeviceIDs);
+	FMarkerQuery& WithTimeRange(const FDateTime InFrom, const FDateTime InTo = FDateTime::MaxValue());
+	FMarkerQuery& WithTiles(const TArray<FString>& InTiles);
+
+	FCompiledMarkerQuery Compile() const;
+
+	/* Start of the time bucket containing a UNIX timestamp, see TimeIndexName in Settings.h */
+	static int64 GetTimeBucket(const int64 UnixTimestamp);
+
+private:
+	bool HasTimeRange() const { return From != FDateTime::MinValue() || To != FDateTime::MaxValue(); }
+};
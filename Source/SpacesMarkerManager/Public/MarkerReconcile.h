@@ -0,0 +1,86 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MarkerRecord.h"
+#include "MarkerReconcile.generated.h"
+
+
+/*
+ * What a reconcile changed, see UMarkerManager::ReconcileMarkersAsync().
+ */
+USTRUCT(BlueprintType)
+struct SPACESMARKERMANAGER_API FMarkerReconcileResult
+{
+	GENERATED_BODY()
+
+	/* False if the read failed, in which case nothing was changed */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Reconcile")
+	bool Success = false;
+
+	/* Rows read from the table */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Reconcile")
+	int Records = 0;
+
+	/* Devices queued to be spawned */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Reconcile")
+	int Added = 0;
+
+	/* Static and temporary markers moved in place, and dynamic markers given newer locations */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Reconcile")
+	int Updated = 0;
+
+	/* Markers destroyed because the table no longer has them */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Reconcile")
+	int Removed = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Reconcile")
+	int Unchanged = 0;
+
+	/* Markers missing from the table but kept, since an update still queued for them may be newer than the read */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Reconcile")
+	int Deferred = 0;
+};
+
+
+/*
+ * A spawned marker as the reconcile compares it against the table.
+ */
+struct FSpawnedMarkerState
+{
+	ELocationMarkerType MarkerType = ELocationMarkerType::Static;
+	/* The location a static or temporary marker was spawned at */
+	FLocationTs LocationTs;
+	/* Newest location of the marker, the end of a dynamic marker's history */
+	FDateTime LatestTimestamp;
+};
+
+
+/*
+ * The difference between a full read of the marker table and the spawned markers, as three sets of changes.
+ * It follows what applying the read would do, without the churn: static and temporary markers stay at
+ * their oldest row, so they change only when that row does, and dynamic markers only gain rows newer than their history,
+ * since decimation removes older ones locally. Temporary and dynamic markers whose lifespan has passed since their
+ * newest row are not spawned again.
+ */
+struct SPACESMARKERMANAGER_API FMarkerReconcilePlan
+{
+	/* Devices without a marker, as the batches to queue */
+	TArray<FMarkerRecordBatch> Added;
+	/* Static and temporary markers with their new location, and dynamic markers with only their new locations */
+	TArray<FMarkerRecordBatch> Updated;
+	/* Spawned markers the table no longer has */
+	TArray<FString> Removed;
+	int32 Unchanged = 0;
+
+	/**
+	 * @param Database The read, coalesced per device
+	 * @param Spawned
+	 * @param StaticMarkersOnly Whether the read covered only static markers. Markers of other types are then left alone.
+	 * @param ReadStartedAt Markers newer than the read may be missing from it, so they are never removed.
+	 * @param TemporaryLifeSpan Seconds a temporary marker lives after its timestamp
+	 * @param DynamicLifeSpan Seconds a dynamic marker lives after the end of its history
+	 **/
+	static FMarkerReconcilePlan Diff(const TArray<FMarkerRecordBatch>& Database, const TMap<FString, FSpawnedMarkerState>& Spawned,
+	                                 const bool StaticMarkersOnly, const FDateTime ReadStartedAt, const float TemporaryLifeSpan,
+	                                 const float DynamicLifeSpan);
+};
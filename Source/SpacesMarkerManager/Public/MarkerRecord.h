@@ -0,0 +1,83 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "aws/core/utils/memory/stl/AWSString.h"
+#include "aws/dynamodbstreams/model/StreamRecord.h"
+#include "LocationMarker.h"
+#include "LocationTs.h"
+
+
+/*
+ * A single decoded marker row, independent of whether it was read by Scan, Query or from DynamoDB Streams.
+ * The device ID stays in UTF-8 until the records are coalesced, so it is converted once per device rather than per row.
+ */
+struct FMarkerRecord
+{
+	Aws::String DeviceID;
+	ELocationMarkerType MarkerType = ELocationMarkerType::Static;
+	FLocationTs LocationTs;
+
+	FMarkerRecord()
+	{
+	}
+
+	FMarkerRecord(const Aws::String& InDeviceID, const ELocationMarkerType InMarkerType, const FLocationTs& InLocationTs)
+		: DeviceID(InDeviceID), MarkerType(InMarkerType), LocationTs(InLocationTs)
+	{
+	}
+};
+
+
+/*
+ * A marker row decoded from a stream record, before its WGS84 location is converted with the georeference.
+ * Decoding does not touch the world, so it can run on any thread.
+ */
+struct FRawMarkerRecord
+{
+	Aws::String DeviceID;
+	ELocationMarkerType MarkerType = ELocationMarkerType::Static;
+	FDateTime Timestamp;
+	double Lon = 0.0;
+	double Lat = 0.0;
+	double Elev = 0.0;
+
+	/**
+	 * Read the new image of a stream record in place.
+	 * @param StreamRecord
+	 * @param OutRecord
+	 * @returns False if the new image has no device_id or created_timestamp.
+	 **/
+	static bool FromStreamRecord(const Aws::DynamoDBStreams::Model::StreamRecord& StreamRecord, FRawMarkerRecord& OutRecord);
+
+	/* Case-insensitive match against the marker names in Settings.h. Unknown names are Static. */
+	static ELocationMarkerType ParseMarkerType(const Aws::String& MarkerTypeName);
+};
+
+
+/*
+ * All records of a single device within one batch, sorted by timestamp.
+ * Applying a batch resolves the marker once, instead of once per record.
+ */
+struct FMarkerRecordBatch
+{
+	FString DeviceID;
+	ELocationMarkerType MarkerType = ELocationMarkerType::Static;
+
+	/* Sorted in ascending order of timestamp */
+	TArray<FLocationTs> Locations;
+
+	/* Dynamic markers go straight to the latest location, as if they had already followed the earlier ones */
+	bool FastForward = false;
+
+	/* Read from a live stream, so it may be shed under load. Reads the caller asked for are always applied in full. */
+	bool Live = false;
+
+	/**
+	 * Group records by device ID, preserving the order in which devices first appear,
+	 * and sort the records of each device by timestamp.
+	 * The marker type of a device is taken from its first record.
+	 * @param Records
+	 * @returns One batch per device
+	 **/
+	static TArray<FMarkerRecordBatch> Coalesce(const TArray<FMarkerRecord>& Records);
+};
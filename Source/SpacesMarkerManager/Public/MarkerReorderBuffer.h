@@ -0,0 +1,95 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MarkerRecord.h"
+
+
+/*
+ * Holds location samples per device for a short while, and releases them in timestamp order.
+ * Records read from several shards, or written late, arrive out of order; the buffer absorbs that disorder
+ * so markers and spawn decisions see a device's samples oldest first.
+ * A sample is released once it is at or behind the device's watermark, the newest timestamp seen for the device
+ * minus the lateness, or once it has been held for the lateness in wall time, so a quiet device is not stalled.
+ * Samples older than what a device has already released are late: they pass straight through,
+ * and are merged into the marker history by a sorted insert.
+ * The lateness is the one trade-off: more absorbs more disorder, less adds less latency.
+ * A device that holds nothing and has sent nothing for longer than the lateness is forgotten,
+ * so the buffer stays bounded by the devices active within the window.
+ * Game thread only.
+ */
+class SPACESMARKERMANAGER_API FMarkerReorderBuffer
+{
+public:
+	/* Seconds of lateness. 0 passes every sample straight through. */
+	void SetLateness(const double Seconds) { LatenessSeconds = FMath::Max(Seconds, 0.0); }
+	double GetLateness() const { return LatenessSeconds; }
+
+	/**
+	 * Hold the samples of Batches. Late samples are moved to OutLate, to be applied right away.
+	 * @param Batches Grouped by device, each sorted by timestamp.
+	 * @param Now Wall time in seconds, from FPlatformTime::Seconds().
+	 * @param OutLate
+	 **/
+	void Add(TArray<FMarkerRecordBatch>&& Batches, const double Now, TArray<FMarkerRecordBatch>& OutLate);
+
+	/**
+	 * Take the samples that are behind their device's watermark, or have been held for the lateness.
+	 * Also forgets the devices that have been idle for longer than the lateness.
+	 * @param Now Wall time in seconds.
+	 * @param OutBatches One batch per device, sorted by timestamp.
+	 **/
+	void Release(const double Now, TArray<FMarkerRecordBatch>& OutBatches);
+
+	/* Take every held sample, regardless of the watermark */
+	void Flush(TArray<FMarkerRecordBatch>& OutBatches);
+
+	/* Recompute the UE coordinates of the held samples from their ECEF coordinates, after the georeference moved */
+	void Reanchor(const FMatrix& EcefToUnreal);
+
+	/* Forget a device, dropping its held samples */
+	void Remove(const FString& DeviceID);
+
+	/* Whether any samples of a device are held */
+	bool IsHolding(const FString& DeviceID) const { return HoldingDevices.Contains(DeviceID); }
+
+	/* Samples currently held */
+	int32 Num() const { return HeldCount; }
+
+	/* Devices currently tracked, holding samples or not */
+	int32 NumDevices() const { return Devices.Num(); }
+
+	/* Samples that arrived behind what their device had already released */
+	int64 GetLateCount() const { return LateCount; }
+
+private:
+	struct FHeldSample
+	{
+		FLocationTs Location;
+		double ArrivedAt = 0.0;
+	};
+
+	struct FDevice
+	{
+		ELocationMarkerType MarkerType = ELocationMarkerType::Static;
+		// Sorted by timestamp
+		TArray<FHeldSample> Held;
+		FDateTime NewestSeen = FDateTime::MinValue();
+		FDateTime NewestReleased = FDateTime::MinValue();
+		// Wall time of the last sample added
+		double LastArrivedAt = 0.0;
+	};
+
+	/* Forget the devices that hold nothing and have been idle for longer than the lateness */
+	void PruneIdle(const double Now);
+
+	/* Move the first Count held samples of a device into a batch of OutBatches */
+	void ReleaseHeld(const FString& DeviceID, FDevice& Device, const int32 Count, TArray<FMarkerRecordBatch>& OutBatches);
+
+	double LatenessSeconds = 0.0;
+	TMap<FString, FDevice> Devices;
+	// Devices with held samples, so a release does not visit every known device
+	TSet<FString> HoldingDevices;
+	int32 HeldCount = 0;
+	int64 LateCount = 0;
+	double LastPruneTime = 0.0;
+};
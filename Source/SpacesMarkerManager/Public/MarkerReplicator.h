@@ -0,0 +1,188 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Engine/NetSerialization.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "LocationMarker.h"
+#include "LocationTs.h"
+#include "MarkerInterestGrid.h"
+#include "MarkerReplicator.generated.h"
+
+class AMarkerReplicator;
+class UMarkerManager;
+struct FReplicatedMarkerList;
+
+
+/*
+ * Latest state of one device, as replicated to clients.
+ * Only the UE coordinate is sent; clients rebuild the WGS84 and ECEF coordinates with their own georeference.
+ */
+USTRUCT()
+struct SPACESMARKERMANAGER_API FReplicatedMarker : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FString DeviceID;
+
+	UPROPERTY()
+	ELocationMarkerType MarkerType = ELocationMarkerType::Static;
+
+	/* UE coordinate of the latest location, quantized to 1 mm */
+	UPROPERTY()
+	FVector_NetQuantize10 Location = FVector::ZeroVector;
+
+	/* UNIX timestamp of the latest location */
+	UPROPERTY()
+	int64 Timestamp = 0;
+
+	// Client-side callbacks, see FFastArraySerializer
+	void PreReplicatedRemove(const FReplicatedMarkerList& InArraySerializer);
+	void PostReplicatedAdd(const FReplicatedMarkerList& InArraySerializer);
+	void PostReplicatedChange(const FReplicatedMarkerList& InArraySerializer);
+};
+
+
+USTRUCT()
+struct SPACESMARKERMANAGER_API FReplicatedMarkerList : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FReplicatedMarker> Items;
+
+	UPROPERTY(NotReplicated)
+	AMarkerReplicator* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FReplicatedMarker, FReplicatedMarkerList>(Items, DeltaParms, *this);
+	}
+};
+
+template <>
+struct TStructOpsTypeTraits<FReplicatedMarkerList> : public TStructOpsTypeTraitsBase2<FReplicatedMarkerList>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+
+/*
+ * Number of markers in a distant grid cell, sent instead of the markers themselves.
+ */
+USTRUCT(BlueprintType)
+struct SPACESMARKERMANAGER_API FReplicatedMarkerCluster : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Replication")
+	FIntVector Cell = FIntVector::ZeroValue;
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Replication")
+	int Count = 0;
+
+	/* Mean UE coordinate of the markers in the cell, quantized to 1 cm */
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|Replication")
+	FVector_NetQuantize Centroid = FVector::ZeroVector;
+};
+
+
+USTRUCT()
+struct SPACESMARKERMANAGER_API FReplicatedMarkerClusterList : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FReplicatedMarkerCluster> Items;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FReplicatedMarkerCluster, FReplicatedMarkerClusterList>(Items, DeltaParms, *this);
+	}
+};
+
+template <>
+struct TStructOpsTypeTraits<FReplicatedMarkerClusterList> : public TStructOpsTypeTraitsBase2<FReplicatedMarkerClusterList>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+
+/*
+ * Replicates the markers around one client's view to that client, as compact delta lists.
+ * The server spawns one replicator per remote player controller, owned by it and relevant only to it.
+ * Interest is decided on the interest grid of UMarkerManager, by the Chebyshev distance in cells
+ * between a marker and the client's view location:
+ * - Near (up to InterestNearRadiusCells): every change is sent at the net update rate
+ * - Mid (up to InterestMidRadiusCells): changes are sent at most every InterestMidUpdateInterval seconds
+ * - Far: one cluster per non-empty cell with its marker count and centroid, every InterestFarUpdateInterval seconds
+ * Only cells whose version changed are visited, and only their changed devices are sent, with delta serialization
+ * enabled so the device ID goes out once. Bandwidth per client follows what it looks at, not the number of markers.
+ * Clients spawn local markers from the list, and dynamic markers interpolate between the replicated locations.
+ * See UMarkerManager::StartServerReplication().
+ */
+UCLASS(NotBlueprintable)
+class SPACESMARKERMANAGER_API AMarkerReplicator : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AMarkerReplicator();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void Tick(float DeltaTime) override;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|Replication")
+	int GetReplicatedMarkerCount() const;
+
+	/**
+	 * @returns Aggregated cells outside the detailed area around the view.
+	 **/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|MarkerManager|Replication")
+	TArray<FReplicatedMarkerCluster> GetClusters() const;
+
+	// Called by the list items on clients
+	void OnMarkerReplicated(const FReplicatedMarker& Item) const;
+	void OnMarkerRemoved(const FReplicatedMarker& Item) const;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UMarkerManager* GetMarkerManager() const;
+	bool GetViewLocation(FVector& OutLocation) const;
+
+	// Server side, see Tick()
+	void SyncDetailedCell(const FMarkerInterestGrid& Grid, const FIntVector& Cell, const int32 MidRadius);
+	void DropDetailedCellsOutOfRange(const int32 MidRadius);
+	void SyncClusters(const FMarkerInterestGrid& Grid, const int32 MidRadius);
+	void UpsertItem(const FString& DeviceID, const FMarkerInterestGrid::FDevice& Device);
+	void RemoveItem(const FString& DeviceID);
+
+	UPROPERTY(Replicated)
+	FReplicatedMarkerList Markers;
+
+	UPROPERTY(Replicated)
+	FReplicatedMarkerClusterList Clusters;
+
+	// Server: index of each device in Markers.Items, and of each cell in Clusters.Items
+	TMap<FString, int32> ItemIndex;
+	TMap<FIntVector, int32> ClusterIndex;
+
+	// Server: devices sent per detailed cell, and the grid version and time each cell was last synced at
+	TMap<FIntVector, TSet<FString>> DetailedCellDevices;
+	TMap<FIntVector, uint64> SyncedCellVersion;
+	TMap<FIntVector, double> LastCellSyncTime;
+	TMap<FIntVector, uint64> SyncedClusterVersion;
+
+	FIntVector ViewCell = FIntVector::ZeroValue;
+	bool HasViewCell = false;
+	double LastClusterSyncTime = -1.0e9;
+};
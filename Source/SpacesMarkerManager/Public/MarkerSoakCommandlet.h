@@ -0,0 +1,44 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MarkerSoakCommandlet.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogMarkerSoak, Display, All);
+
+
+/*
+ * End-to-end soak test of the listen pipeline against DynamoDB Local (DynamoDBLocalEndpoint in Settings.h).
+ * Simulated devices write dynamic marker records with BatchWriteItem from writer threads, while a UMarkerManager
+ * in a headless world follows the table's stream and applies them, ticked at a fixed frame rate.
+ * Every ReportInterval seconds it logs write and apply throughput, write-to-apply latency percentiles,
+ * frame time and memory, and appends them to a CSV file if one is given. A summary is logged at the end.
+ * The table must already exist with a stream, as created by the infra scripts.
+ *
+ * UnrealEditor-Cmd <Project>.uproject -run=MarkerSoak -nullrhi -unattended -Devices=1000 -Rate=1 -Duration=600
+ * -Devices=100         simulated devices
+ * -Rate=1              records per second per device, at most 1 since sort keys are whole seconds; raise -Devices for more
+ * -Duration=60         seconds of writing
+ * -Writers=4           writer threads, each with its share of the devices
+ * -FrameRate=60        frames per second of the manager's world
+ * -ReportInterval=5    seconds between reports
+ * -Warmup=5            seconds between the stream readers starting and the first write
+ * -Drain=30            seconds to wait for outstanding records after the writers stop
+ * -PollingInterval=1   seconds between stream reads
+ * -Listen              use DynamoDBStreamsListen() instead of a marker feed, which follows every shard
+ * -Csv=<path>          per-report CSV output
+ * -Allocations=10000   instead of the soak test, count heap allocations per record on the stream ingestion path
+ *                      for this many synthetic records of -Devices devices. Needs no DynamoDB, but an AWS SDK
+ *                      built with custom memory management.
+ * Returns 0 if every record written was applied.
+ */
+UCLASS()
+class SPACESMARKERMANAGER_API UMarkerSoakCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMarkerSoakCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MarkerRecord.h"
+#include "StreamDeduplicator.h"
+#include "aws/dynamodbstreams/DynamoDBStreamsClient.h"
+
+
+/*
+ * Reads everything a table's stream retains on worker threads, and reduces it to the state that applying
+ * every record in order would end in, see UMarkerManager::DynamoDBStreamsFastForwardAsync().
+ * Shards are read in parallel on a few dedicated threads, from the trim horizon until they are closed, run dry,
+ * or reach records written after the fast-forward started, which are left to the listener.
+ * Records are decoded and reduced per device as they arrive: static and temporary markers keep their oldest location,
+ * dynamic markers their latest one, or every location when the history is kept.
+ * Locations are converted on the worker threads, with a snapshot of the georeference's ECEF to UE transform.
+ */
+class SPACESMARKERMANAGER_API FMarkerStreamFastForward
+{
+public:
+	/**
+	 * @param InClient Used from several threads at once
+	 * @param InDeduplicator Copy of the manager's, so records that were already applied are skipped
+	 * @param InEcefToUnreal Unset without a georeference, in which case WGS84 is kept as the UE coordinate,
+	 * as UMarkerManager::WrapLocationTs() does.
+	 **/
+	FMarkerStreamFastForward(Aws::DynamoDBStreams::DynamoDBStreamsClient* InClient, const FStreamDeduplicator& InDeduplicator,
+	                         const TOptional<FMatrix>& InEcefToUnreal);
+
+	/**
+	 * Read and reduce. Blocks until every shard is done, so call it from a worker thread.
+	 * @param TableName
+	 * @param From Records the stream received before this UTC time are skipped
+	 * @param KeepHistory Keep every location of dynamic markers, rather than only the latest one
+	 * @param MaxEmptyPages Consecutive empty pages after which an open shard is considered caught up
+	 * @param OutBatches One batch per device, with FastForward set
+	 * @returns False if the table has no readable stream. Shards that fail are logged and skipped.
+	 **/
+	bool Run(const Aws::String& TableName, const FDateTime From, const bool KeepHistory, const int32 MaxEmptyPages,
+	         TArray<FMarkerRecordBatch>& OutBatches);
+
+	/* The deduplicator given to the constructor, with the records read by Run() */
+	const FStreamDeduplicator& GetDeduplicator() const { return Deduplicator; }
+
+	int64 GetRecordsRead() const { return RecordsRead; }
+	int64 GetDuplicateRecordsDropped() const { return DuplicateRecordsDropped; }
+
+private:
+	struct FShard;
+
+	void ReadShard(const Aws::String& StreamArn, FShard& Shard, const FDateTime From, const FDateTime Until,
+	               const bool KeepHistory, const int32 MaxEmptyPages) const;
+
+	Aws::DynamoDBStreams::DynamoDBStreamsClient* Client;
+	FStreamDeduplicator Deduplicator;
+	TOptional<FMatrix> EcefToUnreal;
+	int64 RecordsRead = 0;
+	int64 DuplicateRecordsDropped = 0;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CompactTrajectory.h"
+#include "LocationMarker.h"
+#include "LocationTs.h"
+#include "MarkerTemporalStore.generated.h"
+
+
+/*
+ * A device's location at a point in time, as returned by FMarkerTemporalStore.
+ */
+USTRUCT(BlueprintType)
+struct SPACESMARKERMANAGER_API FMarkerState
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|History")
+	FString DeviceID;
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|History")
+	ELocationMarkerType MarkerType = ELocationMarkerType::Static;
+
+	UPROPERTY(BlueprintReadOnly, Category="Spaces|MarkerManager|History")
+	FLocationTs LocationTs;
+};
+
+
+/*
+ * In-memory history of every ingested location, for seeking the whole scene to any moment.
+ * Each device has its own FCompactTrajectory sorted by timestamp, decoded only where a query reads it.
+ * A time bucket index maps each bucket of BucketSeconds to the devices with records in it.
+ * - GetStatesAt(T): per device, a binary search over its blocks and one walk of the block holding T, O(devices * (log n + block))
+ * - GetRecordsBetween(T0, T1): the devices of the buckets in range, then two binary searches per device
+ * Records arrive mostly in order per device, so inserting is usually an append.
+ * Game thread only.
+ */
+class SPACESMARKERMANAGER_API FMarkerTemporalStore
+{
+public:
+	explicit FMarkerTemporalStore(const int64 InBucketSeconds = 60);
+
+	/**
+	 * Add locations of a device. Locations with a timestamp the device already has are ignored.
+	 * @param DeviceID
+	 * @param MarkerType
+	 * @param Locations Need not be sorted, but sorted input is cheaper.
+	 **/
+	void Add(const FString& DeviceID, const ELocationMarkerType MarkerType, const TArray<FLocationTs>& Locations);
+
+	/**
+	 * Latest location of every device at or before Time.
+	 * @param Time
+	 * @param Interpolate Interpolate the UE coordinate linearly between the records around Time.
+	 * @param MaxAgeSeconds Devices whose latest record at Time is older than this are left out. 0 includes them all.
+	 * @param OutStates
+	 **/
+	void GetStatesAt(const FDateTime Time, const bool Interpolate, const double MaxAgeSeconds, TArray<FMarkerState>& OutStates) const;
+
+	/**
+	 * Every record with a timestamp in [From, To], grouped by device and sorted by timestamp within a device.
+	 * @param From
+	 * @param To
+	 * @param OutRecords
+	 **/
+	void GetRecordsBetween(const FDateTime From, const FDateTime To, TArray<FMarkerState>& OutRecords) const;
+
+	/**
+	 * All records of one device in [From, To].
+	 * @returns False if the device is unknown.
+	 **/
+	bool GetDeviceRecords(const FString& DeviceID, const FDateTime From, const FDateTime To, TArray<FLocationTs>& OutLocations) const;
+
+	/* Drop the records older than Time, except each device's latest one before Time, so states at Time stay answerable */
+	void TrimBefore(const FDateTime Time);
+
+	void Reset();
+
+	/* Used to derive the UE and ECEF coordinates of locations stored as WGS84. Without it, WGS84 locations are kept whole. */
+	void SetLocationConverter(FLocationTsFromWgs84&& InFromWgs84) { FromWgs84 = MoveTemp(InFromWgs84); }
+
+	/* Bytes held by the records, and what they would take as a timestamp column and FLocationTs each */
+	SIZE_T GetAllocatedSize() const;
+	SIZE_T GetUncompressedSize() const { return RecordCount * (sizeof(int64) + sizeof(FLocationTs)); }
+
+	/* Timestamps of the oldest and newest record. False if the store is empty. */
+	bool GetTimeRange(FDateTime& OutEarliest, FDateTime& OutLatest) const;
+
+	int32 GetDeviceCount() const { return Tracks.Num(); }
+	int64 GetRecordCount() const { return RecordCount; }
+
+private:
+	struct FTrack
+	{
+		FString DeviceID;
+		ELocationMarkerType MarkerType = ELocationMarkerType::Static;
+		FCompactTrajectory Trajectory;
+		// Newest bucket this track was added to, so in-order appends skip the index lookup
+		int64 LastIndexedBucket = MIN_int64;
+	};
+
+	int64 GetBucket(const int64 Ticks) const { return Ticks / BucketTicks - (Ticks % BucketTicks < 0 ? 1 : 0); }
+	void IndexRecord(const int32 TrackIndex, const int64 Ticks);
+
+	const FLocationTsFromWgs84* GetConverter() const { return FromWgs84 ? &FromWgs84 : nullptr; }
+
+	int64 BucketTicks;
+	FLocationTsFromWgs84 FromWgs84;
+	TArray<FTrack> Tracks;
+	TMap<FString, int32> TrackIndex;
+	// Bucket -> indices of the tracks with records in the bucket
+	TMap<int64, TArray<int32>> BucketIndex;
+	int64 RecordCount = 0;
+	int64 EarliestTicks = MAX_int64;
+	int64 LatestTicks = MIN_int64;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "AwsStringUtils.h"
 #include "aws/core/Region.h"
 #include "aws/core/utils/memory/stl/AWSString.h"
 
@@ -12,35 +13,32 @@ static const char* SpacesAwsRegion = Aws::Region::AP_SOUTHEAST_2;
 static const bool UseDynamoDBLocal = true;
 static const bool UseCesiumGeoreference = false;
 
-inline Aws::String FStringToAwsString(const FString& String)
-{
-	return Aws::String(TCHAR_TO_UTF8(*String));
-}
-
-inline FString AwsStringToFString(const Aws::String& String)
-{
-	return FString(String.c_str());
-}
-
 // DynamoDB attribute names
-static const FString DynamoDBTableName = "mojexa-markers";
-static const FString PartitionKeyAttributeName = "device_id";
-static const FString SortKeyAttributeName = "created_timestamp";
-static const FString PositionXAttributeName = "longitude";
-static const FString PositionYAttributeName = "latitude";
-static const FString PositionZAttributeName = "elevation";
-static const FString MarkerTypeAttributeName = "marker_type";
-
-static const Aws::String DynamoDBTableNameAws = FStringToAwsString(DynamoDBTableName);
-static const Aws::String PartitionKeyAttributeNameAws = FStringToAwsString(PartitionKeyAttributeName);
-static const Aws::String SortKeyAttributeNameAws = FStringToAwsString(SortKeyAttributeName);
-static const Aws::String PositionXAttributeNameAws = FStringToAwsString(PositionXAttributeName);
-static const Aws::String PositionYAttributeNameAws = FStringToAwsString(PositionYAttributeName);
-static const Aws::String PositionZAttributeNameAws = FStringToAwsString(PositionZAttributeName);
-static const Aws::String MarkerTypeAttributeNameAws = FStringToAwsString(MarkerTypeAttributeName);
+static const Aws::String DynamoDBTableNameAws = "mojexa-markers";
+static const Aws::String PartitionKeyAttributeNameAws = "device_id";
+static const Aws::String SortKeyAttributeNameAws = "created_timestamp";
+static const Aws::String PositionXAttributeNameAws = "longitude";
+static const Aws::String PositionYAttributeNameAws = "latitude";
+static const Aws::String PositionZAttributeNameAws = "elevation";
+static const Aws::String MarkerTypeAttributeNameAws = "marker_type";
+static const Aws::String TimeBucketAttributeNameAws = "time_bucket";
+
+// Global secondary index used for incremental sync, see "Time index" in Doc/report.md.
+// Partition key is TimeBucketAttributeNameAws, the UNIX timestamp of the start of the bucket as a string,
+// and sort key is SortKeyAttributeNameAws.
+static const Aws::String TimeIndexName = "time_bucket-created_timestamp-index";
+static const int64 TimeBucketSeconds = 3600;
+
+// Global secondary index used for region streaming, see "Tile index" in Doc/report.md.
+// Partition key is TileAttributeNameAws, the geohash of the WGS84 location with TileGeohashPrecision characters,
+// and sort key is SortKeyAttributeNameAws.
+static const Aws::String TileAttributeNameAws = "geohash_tile";
+static const Aws::String TileIndexName = "geohash_tile-created_timestamp-index";
+static const int32 TileGeohashPrecision = 4;
 
 // Marker types and names
-// For example, to use a Dynamic Marker, the marker_type attribute of the record has to match "Dynamic"
-static const FString StaticMarkerName = "Static";
-static const FString TemporaryMarkerName = "Temporary";
-static const FString DynamicMarkerName = "Dynamic";
\ No newline at end of file
+// For example, to use a Dynamic Marker, the marker_type attribute of the record has to match "Dynamic".
+// Matching is case insensitive.
+static const Aws::String StaticMarkerNameAws = "Static";
+static const Aws::String TemporaryMarkerNameAws = "Temporary";
+static const Aws::String DynamicMarkerNameAws = "Dynamic";
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AwsStringUtils.h"
+#include "aws/core/utils/memory/stl/AWSString.h"
+
+
+/*
+ * Remembers which DynamoDB Streams sequence numbers have already been seen on a single shard.
+ * Sequence numbers increase within a shard, and every pass of a shard iterator reads a contiguous
+ * run of records, so each run is stored as a [First, Last] range. Ranges that overlap are merged.
+ * A small LRU window of hashed sequence numbers catches records that fall outside every range.
+ * Memory is bounded by MaxRanges and WindowSize, regardless of the length of the stream.
+ * The state is kept in memory only: after a restart, a replay delivers again what the previous session applied.
+ * A persisted high watermark alone would not do, since a listener starting at LATEST leaves older records unread below it.
+ */
+class SPACESMARKERMANAGER_API FShardSequenceDeduplicator
+{
+public:
+	explicit FShardSequenceDeduplicator(const int32 InMaxRanges = 16, const int32 InWindowSize = 1024);
+
+	/* Start a new contiguous run. Call this whenever a new shard iterator is created for the shard. */
+	void BeginRun();
+
+	/**
+	 * Record a sequence number read by the current run.
+	 * Duplicates still extend the current run, since the run is contiguous either way.
+	 * @param SequenceNumber
+	 * @returns True if the sequence number has not been seen before, False if the record is a duplicate.
+	 **/
+	bool Accept(const Aws::String& SequenceNumber);
+
+	bool IsDuplicate(const Aws::String& SequenceNumber) const;
+
+	/* Add what another reader of the same shard has seen. The current run, if any, carries on. */
+	void Merge(const FShardSequenceDeduplicator& Other);
+
+	/* Highest sequence number seen on this shard, or an empty string if none */
+	const Aws::String& GetHighWatermark() const { return HighWatermark; }
+
+	/* Compare two numeric sequence number strings. Returns <0, 0, >0 like strcmp */
+	static int32 CompareSequenceNumbers(const Aws::String& A, const Aws::String& B);
+
+private:
+	struct FSequenceRange
+	{
+		Aws::String First;
+		Aws::String Last;
+	};
+
+	void ExtendCurrentRun(const Aws::String& SequenceNumber);
+	void AddToWindow(const uint64 Hash);
+
+	int32 MaxRanges;
+	int32 WindowSize;
+
+	// Ranges in the order they were created, so the oldest range is evicted first
+	TArray<FSequenceRange> Ranges;
+	int32 CurrentRange = INDEX_NONE;
+
+	// LRU window of hashed sequence numbers, stored as a ring buffer
+	TArray<uint64> Window;
+	TSet<uint64> WindowSet;
+	int32 WindowHead = 0;
+
+	Aws::String HighWatermark;
+};
+
+
+/*
+ * Per-shard deduplication for a whole stream. Keeps at most MaxTrackedShards shards,
+ * evicting the least recently used one, since shards roll over every few hours.
+ */
+class SPACESMARKERMANAGER_API FStreamDeduplicator
+{
+public:
+	explicit FStreamDeduplicator(const int32 InMaxTrackedShards = 64);
+
+	FShardSequenceDeduplicator& GetShard(const Aws::String& ShardId);
+
+	/* Merge every shard of another deduplicator into the matching shard of this one */
+	void Merge(const FStreamDeduplicator& Other);
+
+	void Reset();
+
+	int32 Num() const { return Shards.Num(); }
+
+private:
+	int32 MaxTrackedShards;
+	TMap<Aws::String, FShardSequenceDeduplicator> Shards;
+	TArray<Aws::String> ShardOrder; // least recently used first
+};
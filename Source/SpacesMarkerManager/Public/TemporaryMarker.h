@@ -8,6 +8,20 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemporaryMarker, Display, All);
 
+/*
+ * Update tier of a temporary or dynamic marker, assigned by UMarkerManager from the distance to the camera,
+ * the view frustum and the selection. Farther tiers are moved and rescaled less often.
+ * Hidden markers are not rendered and only advance their logical state until they are relevant again.
+ */
+UENUM(BlueprintType, Category="Spaces|Marker")
+enum class EMarkerSignificance : uint8
+{
+	Near,
+	Mid,
+	Far,
+	Hidden
+};
+
 UCLASS(BlueprintType, Blueprintable)
 class SPACESMARKERMANAGER_API ATemporaryMarker : public ALocationMarker
 {
@@ -25,11 +39,44 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Marker|Temporary")
 	float MaxScale = 2.0f;
 
+	/* World time at which the marker will be destroyed, or 0 if no expiry is scheduled */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Spaces|Marker|Temporary")
+	float ExpiryTime = 0.0f;
+
+	/* World time at which the current expiry was scheduled */
+	float ExpiryStartTime = 0.0f;
+
+	/* Incremented whenever the expiry is scheduled or cancelled, so stale timing wheel entries are ignored */
+	uint32 ExpiryGeneration = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Spaces|Marker|Temporary")
+	EMarkerSignificance Significance = EMarkerSignificance::Near;
+
+	/**
+	* Change the update tier. Called by UMarkerManager's significance pass.
+	* @param InSignificance Hidden also hides the actor.
+	* @param UpdateRateDivisor Updates happen at 1/UpdateRateDivisor of the full rate
+	**/
+	virtual void SetSignificance(const EMarkerSignificance InSignificance, const int32 UpdateRateDivisor);
+
+	/**
+	* Destroy the marker LifeSpan seconds from now. The marker shrinks until then.
+	* Expiry is batched by the timing wheel of UMarkerManager, so temporary markers need no timer or tick.
+	* The shrink is driven by the material parameters ExpiryStartTime, ExpiryLifeSpan and MaxScale,
+	* or by UMarkerManager when ShrinkTemporaryMarkersInMaterial is off.
+	* @param LifeSpan Seconds
+	**/
+	UFUNCTION(BlueprintCallable, Category="Spaces|Marker|Temporary")
+	void ScheduleExpiry(const float LifeSpan);
+
+	/* Keep the marker, and restore its size */
+	UFUNCTION(BlueprintCallable, Category="Spaces|Marker|Temporary")
+	void CancelExpiry();
+
+	/* Scale for the remaining lifespan at world time Now */
+	float GetExpiryScale(const float Now) const;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
-
-public:
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
 };
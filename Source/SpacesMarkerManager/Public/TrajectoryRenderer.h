@@ -0,0 +1,114 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "TrajectoryRenderer.generated.h"
+
+class ADynamicMarker;
+class ULineBatchComponent;
+
+
+/*
+ * Draws the paths that dynamic markers have travelled, for every device at once.
+ * Paths follow each marker's history up to where the marker is along it, so the locations it passed between
+ * two samples are drawn as well, and hidden markers that no longer move their actor keep their trail.
+ * When a marker is first seen, the part of its history within TrailSeconds of its position is drawn at once.
+ * Segments go into a few ULineBatchComponent chunks, each holding the segments of ChunkSeconds,
+ * so the path of all devices is drawn with one batch per chunk regardless of the number of devices.
+ * New segments are appended to the newest chunk only, whole chunks are dropped once older than TrailSeconds,
+ * and older chunks are faded by re-coloring them a few times over their life.
+ * Place it in the level, or spawn it, to show trajectories. Does nothing on a dedicated server.
+ * When the manager re-anchors the markers, the trails are cleared and redrawn from the converted histories.
+ */
+UCLASS(BlueprintType, Blueprintable)
+class SPACESMARKERMANAGER_API ATrajectoryRenderer : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ATrajectoryRenderer();
+
+	/* Seconds a segment stays visible */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Trajectory")
+	float TrailSeconds = 300.0f;
+
+	/* Seconds of segments per chunk. Fewer, longer chunks mean fewer draw calls but larger updates. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Trajectory")
+	float ChunkSeconds = 30.0f;
+
+	/* Seconds between samples of the marker histories */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Trajectory")
+	float SampleInterval = 0.1f;
+
+	/* Segments shorter than this, in UE units, are merged into the next one */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Trajectory")
+	float MinSegmentLength = 100.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Trajectory")
+	float LineThickness = 20.0f;
+
+	/* Darken segments as they age, towards FadeColor */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Trajectory")
+	bool FadeByAge = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Trajectory")
+	FLinearColor FadeColor = FLinearColor::Black;
+
+	/* Number of times a chunk is re-colored over its life when fading */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Spaces|Trajectory")
+	int FadeSteps = 8;
+
+	/* Remove every segment */
+	UFUNCTION(BlueprintCallable, Category="Spaces|Trajectory")
+	void ClearTrajectories();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Spaces|Trajectory")
+	int GetSegmentCount() const;
+
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	struct FChunk
+	{
+		ULineBatchComponent* Lines = nullptr;
+		double StartTime = 0.0;
+		double EndTime = 0.0;
+		int32 FadeStep = 0;
+		// Undimmed color of every line, in the order of ULineBatchComponent::BatchedLines
+		TArray<FLinearColor> BaseColors;
+	};
+
+	void SampleMarkers(const double Now);
+	void TrimAndFade(const double Now);
+	FChunk& GetChunkForAppend(const double Now);
+
+	// Oldest first
+	TArray<FChunk> Chunks;
+
+	// Components of dropped chunks, reused for new ones
+	UPROPERTY()
+	TArray<ULineBatchComponent*> FreeLineBatches;
+
+	// Keeps the components of Chunks alive
+	UPROPERTY()
+	TArray<ULineBatchComponent*> UsedLineBatches;
+
+	struct FTrail
+	{
+		// End of the last segment, once there is one
+		FVector LastPoint = FVector::ZeroVector;
+		bool HasPoint = false;
+		// History locations up to this timestamp have been drawn
+		FDateTime LastTimestamp;
+	};
+
+	// Trail of every device
+	TMap<TWeakObjectPtr<ADynamicMarker>, FTrail> Trails;
+
+	FDelegateHandle ReanchoredHandle;
+
+	double LastSampleTime = 0.0;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Async.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "aws/core/utils/threading/Executor.h"
+
+
+/*
+ * Executor for the AWS SDK's *Async and *Callable client methods.
+ * Runs SDK tasks on the Unreal Engine thread pool instead of the SDK's default executor,
+ * which creates a new thread for every request.
+ * Counts the tasks it has handed out, so that their clients and the SDK outlive them.
+ */
+class SPACESMARKERMANAGER_API FUnrealAwsExecutor : public Aws::Utils::Threading::Executor
+{
+public:
+	virtual ~FUnrealAwsExecutor() override
+	{
+		WaitForTasks();
+	}
+
+	/* Block until every submitted task has finished. Tasks submitted meanwhile are waited for too. */
+	void WaitForTasks() const
+	{
+		while (OutstandingTasks.GetValue() > 0) FPlatformProcess::Sleep(0.001f);
+	}
+
+	int32 GetOutstandingTasks() const { return OutstandingTasks.GetValue(); }
+
+protected:
+	virtual bool SubmitToThread(std::function<void()>&& Task) override
+	{
+		OutstandingTasks.Increment();
+		Async(EAsyncExecution::ThreadPool, [this, Task = MoveTemp(Task)]()
+		{
+			Task();
+			OutstandingTasks.Decrement();
+		});
+		return true;
+	}
+
+private:
+	FThreadSafeCounter OutstandingTasks;
+};
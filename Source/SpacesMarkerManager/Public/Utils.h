@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "AwsStringUtils.h"
 #include "aws/dynamodbstreams/model/ShardIteratorType.h"
 #include "Utils.generated.h"
 
@@ -23,6 +24,10 @@ struct FDynamoDBStreamShardIteratorType
 	Aws::DynamoDBStreams::Model::ShardIteratorType Value;
 };
 
+/*
+ * Stream ARNs and shard IDs as handed to Blueprints. C++ code passes Aws::String instead,
+ * so the FString copy is only made when a value crosses into Blueprints.
+ */
 USTRUCT(BlueprintType)
 struct FAwsString
 {
@@ -38,19 +43,19 @@ struct FAwsString
 		
 	}
 
-	static FAwsString FromAwsString(Aws::String AwsStr)
+	static FAwsString FromAwsString(const Aws::String& AwsStr)
 	{
 		FAwsString Str;
 		Str.AwsString = AwsStr;
-		Str.Fstring = *FString(AwsStr.c_str());
+		Str.Fstring = AwsStringToFString(AwsStr);
 		return Str;
 	}
 
-	static FAwsString FromFString(FString FInputStr)
+	static FAwsString FromFString(const FString& FInputStr)
 	{
 		FAwsString Str;
 		Str.Fstring = FInputStr;
-		Str.AwsString = Aws::String(TCHAR_TO_UTF8(*FInputStr));
+		Str.AwsString = FStringToAwsString(FInputStr);
 		return Str;
 	}
-};
+};
\ No newline at end of file
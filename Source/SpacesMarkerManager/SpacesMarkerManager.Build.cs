@@ -13,7 +13,7 @@ public class SpacesMarkerManager : ModuleRules
 		PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "Public"));
 		PrivateIncludePaths.Add(Path.Combine(ModuleDirectory, "Private"));
 		
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HTTP", "Json", "JsonUtilities", "AWSCoreLibrary", "DynamoDBClientLibrary", "DynamoDBStreamsClientLibrary", "CesiumRuntime"}); 
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "NetCore", "InputCore", "HTTP", "Json", "JsonUtilities", "AWSCoreLibrary", "DynamoDBClientLibrary", "DynamoDBStreamsClientLibrary", "CesiumRuntime"}); 
 		PrivateDependencyModuleNames.AddRange(new string[] { "JsonUtilities", "CesiumRuntime"});
 	}
 }